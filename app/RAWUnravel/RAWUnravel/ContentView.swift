@@ -109,11 +109,11 @@ struct ContentView: View {
             // MARK: - Fullscreen Document Picker (Files.app)
             .fullScreenCover(isPresented: $isPickerPresented) {
                 DocumentPicker { pickedURL in
-                    // Copy provider file to our temp directory off the main thread,
-                    // then present FileView only after the copy finishes.
+                    // Prepare the picked file off the main thread (attached in place
+                    // when local, else copied to tmp), then present FileView.
                     DispatchQueue.global(qos: .userInitiated).async {
                         do {
-                            let local = try RUImport.copyToTemp(pickedURL)
+                            let local = try RUImport.prepare(pickedURL)
                             DispatchQueue.main.async {
                                 selectedFileURL = local
                                 selectedFileDisplayName = pickedURL.lastPathComponent
@@ -135,7 +135,7 @@ struct ContentView: View {
             .sheet(isPresented: $isPhotoPickerPresented) {
                 RawPickerViewController { pickedURL, originalName in
                     DispatchQueue.global(qos: .userInitiated).async {
-                        let local = try? RUImport.copyToTemp(pickedURL)
+                        let local = try? RUImport.prepare(pickedURL)
                         DispatchQueue.main.async {
                             selectedFileURL = local
                             selectedFileDisplayName = originalName
@@ -284,7 +284,7 @@ struct ContentView: View {
         private func performCopy() {
             DispatchQueue.global(qos: .userInitiated).async {
                 do {
-                    let local = try RUImport.copyToTemp(sourceURL)
+                    let local = try RUImport.prepare(sourceURL)
 
                     // Extra safety: ensure the file is present & stable before presenting
                     let fm = FileManager.default
@@ -64,6 +64,7 @@ struct DevelopScreen: View {
     @State private var showExportSheet = false
     
     @State private var isLoading = false
+    @State private var histogram: RUImageHistogram?
     
     @State private var showExportSuccess = false
     @State private var screenshotForExport: UIImage?
@@ -74,6 +75,7 @@ struct DevelopScreen: View {
     @State private var exposureCompensation: Float = 0.0
     @State private var blackPoint: Float = 0.0
     @State private var shadows: Float = 0.0
+    @State private var highlightRecovery = false
     
     @Environment(\.presentationMode) private var presentationMode
     
@@ -107,11 +109,6 @@ struct DevelopScreen: View {
     
     @State private var vp = ViewportState(zoom: 1, offset: .zero, lastOffset: .zero, savedCenterFrac: nil, savedZoom: nil)
     
-    @State private var pPhase = ""
-    @State private var pStep  = ""
-    @State private var pIter  = 0
-    @State private var pTotal = 0
-    
     @State private var lastGeoSize: CGSize = .zero
     @State private var savedCenterFrac: CGPoint? = nil  // center in image space as fraction [0,1]
     @State private var savedZoom: CGFloat? = nil
@@ -197,14 +194,17 @@ struct DevelopScreen: View {
         }
 
         DispatchQueue.global(qos: .userInitiated).async {
-            let ui = RTPreviewDecoder.decodeRAWPreview(
+            // FileView usually started this decode already
+            let ui = RUPrefetcher.shared.takePreview(forPath: p) ?? RTPreviewDecoder.decodeRAWPreview(
                 atPath: p,
                 withPP3Path: "",
                 halfSize: true,
                 jobID: previewJobID
             )
+            let hist = RTPreviewDecoder.histogram(forPath: p)
             DispatchQueue.main.async {
                 self.previewImage = ui
+                self.histogram = hist
                 self.isLoading = false
             }
         }
@@ -374,15 +374,33 @@ struct DevelopScreen: View {
                                 },
                                 including: .all     // <- important: swallow the gesture here
                             )}}
+                    // MARK: - Histogram (bottom-left)
+                    if let h = histogram, !isLoading {
+                        VStack {
+                            Spacer()
+                            HStack {
+                                HistogramOverlay(histogram: h)
+                                Spacer()
+                            }
+                        }
+                        .padding(12)
+                    }
                     // MARK: - Loading Spinner
+                    // Samples the decode's progress record once per frame
+                    // (no per-iteration notifications)
                     if isLoading {
-                        VStack(spacing: 8) {
-                            ProgressView().scaleEffect(2)
-                            Text(progressTitle(phase: pPhase, step: pStep))
-                                .font(.headline)
-                            let sub = progressSubtitle(phase: pPhase, step: pStep, iter: pIter, total: pTotal)
-                            if !sub.isEmpty {
-                                Text(sub).font(.subheadline).foregroundColor(.secondary)
+                        TimelineView(.animation) { _ in
+                            let p = RTPreviewDecoder.progress(forJob: previewJobID)
+                            let phase = p?.phase ?? "", step = p?.step ?? ""
+                            VStack(spacing: 8) {
+                                ProgressView().scaleEffect(2)
+                                Text(progressTitle(phase: phase, step: step))
+                                    .font(.headline)
+                                let sub = progressSubtitle(phase: phase, step: step,
+                                                           iter: p?.iter ?? 0, total: p?.total ?? 0)
+                                if !sub.isEmpty {
+                                    Text(sub).font(.subheadline).foregroundColor(.secondary)
+                                }
                             }
                         }
                         .padding(20)
@@ -430,7 +448,8 @@ struct DevelopScreen: View {
                         SunExposurePanel(
                             exposure: $exposureCompensation,
                             blackPoint: $blackPoint,
-                            shadows: $shadows
+                            shadows: $shadows,
+                            highlightRecovery: $highlightRecovery
                         ) { newPP3 in
                             exposurePP3 = newPP3
                             currentPP3 = combinePP3()
@@ -602,19 +621,10 @@ struct DevelopScreen: View {
         }
         // MARK: - On Appear: Initial RAW Load
         .onAppear { initialLoad() }
+        .onDisappear { RTPreviewDecoder.endSession(forPath: fileURL.path) }
         .sheet(isPresented: $showHelpSheet) {
             HelpView()
         }
-        .onReceive(NotificationCenter.default.publisher(for: .rawUnravelProgress)) { note in
-            guard
-                let info = note.userInfo as? [String: Any],
-                (info["job"] as? String) == previewJobID  // only ours
-            else { return }
-            pPhase = info["phase"] as? String ?? ""
-            pStep  = info["step"]  as? String ?? ""
-            pIter  = (info["iter"] as? NSNumber)?.intValue ?? 0
-            pTotal = (info["total"] as? NSNumber)?.intValue ?? 0
-        }
     }
     
     // MARK: - Screenshot Crop & Trigger Export
@@ -736,7 +746,6 @@ struct DevelopScreen: View {
     // MARK: - RAW Preview/FullRes Processing
     func processRAW(with pp3String: String, halfSize: Bool = true) {
         isLoading = true
-        pPhase = ""; pStep = ""; pIter = 0; pTotal = 0
         previewJobID = UUID().uuidString
         
         // 1) CAPTURE the current viewport before we change the image
@@ -744,22 +753,23 @@ struct DevelopScreen: View {
             captureViewport(for: ui, in: lastGeoSize)
         }
         
-        // Write temp PP3
-        let tmp = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent("temp.pp3")
-        try? pp3String.write(to: tmp, atomically: true, encoding: .utf8)
+        // Settings stay in memory; the decoder reuses cached stages they don't touch
+        let settings = RUDevelopSettings(pp3String: pp3String)
         
         // 2) Decode on a background queue
         DispatchQueue.global(qos: .userInitiated).async {
             let lowRes = RTPreviewDecoder.decodeRAWPreview(
                 atPath: fileURL.path,
-                withPP3Path: tmp.path,
-                halfSize: true,
+                settings: settings,
+                binFactor: 2,
                 jobID: previewJobID
             )
+            let hist = RTPreviewDecoder.histogram(forPath: fileURL.path)
             
             // 3) On main thread: assign and RESTORE viewport
             DispatchQueue.main.async {
                 previewImage = lowRes
+                histogram = hist
                 DispatchQueue.main.async {
                     previewImage = lowRes
                     if let p = lowRes {
@@ -776,7 +786,6 @@ struct DevelopScreen: View {
                     }
                     
                     isLoading = false
-                    pPhase = ""; pStep = ""; pIter = 0; pTotal = 0
                 }
                 
             }
@@ -125,6 +125,7 @@ struct ExportOptionsSection: View {
     @Binding var useNativeSize: Bool
     @Binding var outputFormat: ExportJPGView.OutputFormat
     @Binding var pngCompression: Int
+    @Binding var tiffLinear: Bool
     var nativePixels: Int
 
     var body: some View {
@@ -177,10 +178,14 @@ struct ExportOptionsSection: View {
                 .padding(.vertical, 6)
                 .padding(.horizontal, 4)
             } else if outputFormat == .tiff {
-                Text("TIFF will export as 16-bit lossless (no compression).")
-                    .font(.caption)
-                    .foregroundColor(.secondary)
-                    .padding(.vertical, 6)
+                VStack(alignment: .leading, spacing: 2) {
+                    Text("TIFF will export as 16-bit lossless (no compression).")
+                        .font(.caption)
+                        .foregroundColor(.secondary)
+                    Toggle("Linear light", isOn: $tiffLinear)
+                        .padding(.horizontal, 4)
+                }
+                .padding(.vertical, 6)
             }
 
             HStack {
@@ -305,6 +310,7 @@ struct ExportJPGView: View {
 
     @State private var useNativeSize = false
     @State private var pngCompression: Int = 3
+    @State private var tiffLinear = false
     @State private var outputFormat: OutputFormat = .jpeg
     @State private var stepText: String = ""
     @State private var substepText: String = ""
@@ -353,7 +359,11 @@ struct ExportJPGView: View {
     }
     private func cleanedBasename(from url: URL) -> String {
         // Remove extension first
-        let name = url.deletingPathExtension().lastPathComponent
+        var name = url.deletingPathExtension().lastPathComponent
+        // Import-store copies are "<content key>-<name>"
+        if let original = RUImportCache.shared.originalName(forPath: url.path) {
+            name = (original as NSString).deletingPathExtension
+        }
         // If matches UUID- prefix, strip it
         let pattern = #"^[0-9A-Fa-f\-]{36,}-(.+)$"#
         if let re = try? NSRegularExpression(pattern: pattern),
@@ -397,6 +407,7 @@ struct ExportJPGView: View {
                         useNativeSize: $useNativeSize,
                         outputFormat: $outputFormat,
                         pngCompression: $pngCompression,
+                        tiffLinear: $tiffLinear,
                         nativePixels: nativePixels
                     )
                 }
@@ -463,10 +474,14 @@ struct ExportJPGView: View {
                                     .font(.subheadline)
                                     .foregroundColor(.white.opacity(0.9))
                             }
-                            if !substepText.isEmpty {
-                                Text(substepText)
-                                    .font(.caption)
-                                    .foregroundColor(.white.opacity(0.8))
+                            // per-iteration counters are sampled, not posted
+                            TimelineView(.animation) { _ in
+                                let sub = liveSubstep()
+                                if !sub.isEmpty {
+                                    Text(sub)
+                                        .font(.caption)
+                                        .foregroundColor(.white.opacity(0.8))
+                                }
                             }
                         }
                         .padding(.vertical, 22)
@@ -493,6 +508,7 @@ struct ExportJPGView: View {
                                 useNativeSize: $useNativeSize,
                                 outputFormat: $outputFormat,
                                 pngCompression: $pngCompression,
+                                tiffLinear: $tiffLinear,
                                 nativePixels: nativePixels
                             )
                             PreviewSection(
@@ -581,8 +597,6 @@ struct ExportJPGView: View {
             else { return }
 
             let step  = (u["step"]  as? String) ?? ""
-            let iter  = (u["iter"]  as? Int) ?? 0
-            let total = (u["total"] as? Int) ?? 0
 
             switch phase {
             case "libraw":
@@ -594,9 +608,8 @@ struct ExportJPGView: View {
 
             case "rld":
                 if step == "iter" {
-                    // show even when iter==0 (start) or total==0 (defensive)
-                    let sub = total > 0 ? "RLD \(iter)/\(total)" : nil
-                    setStep("Applying RLD sharpening…", sub: sub)
+                    // the iteration count comes from liveSubstep()
+                    setStep("Applying RLD sharpening…")
                 } else if step == "skip" {
                     // no RLD -> still move on visually
                     setStep("Sharpening disabled")
@@ -614,8 +627,16 @@ struct ExportJPGView: View {
                                 quality: Int,
                                 pngCompression: Int) -> Data? {
             guard let cg = image.cgImage else { return nil }
+            return encodeData(for: cg, outputFormat: outputFormat,
+                              quality: quality, pngCompression: pngCompression)
+        }
 
-            // Ensure sRGB-tagged CGImage (UIImage can be DeviceRGB)
+        private func encodeData(for cg: CGImage,
+                                outputFormat: OutputFormat,
+                                quality: Int,
+                                pngCompression: Int) -> Data? {
+            // Ensure sRGB-tagged CGImage (UIImage can be DeviceRGB); sRGB 16-bit
+            // renders pass through untouched, so PNG keeps 16 bpc.
             let cs = CGColorSpace(name: CGColorSpace.sRGB) ?? CGColorSpaceCreateDeviceRGB()
             let bitmapInfo: CGBitmapInfo = [
                 CGBitmapInfo.byteOrder32Big,
@@ -678,6 +699,16 @@ struct ExportJPGView: View {
 
         // MARK: - Export Pipeline
 
+        /// RLD counter of the running export, read from its progress record;
+        /// otherwise the substep set with setStep.
+        private func liveSubstep() -> String {
+            if let p = RTPreviewDecoder.progress(forJob: exportJobID),
+               p.phase == "rld", p.step == "iter", p.total > 0 {
+                return "RLD \(p.iter)/\(p.total)"
+            }
+            return substepText
+        }
+
         private func setStep(_ main: String, sub: String? = nil) {
             DispatchQueue.main.async {
                 self.stepText = main
@@ -758,136 +789,75 @@ struct ExportJPGView: View {
                 }
 
                 // ===== RAW MODE =====
-                self.setStep("Writing settings (.pp3)…")
-                let tempPP3 = URL(fileURLWithPath: NSTemporaryDirectory())
-                    .appendingPathComponent("temp-export-\(UUID().uuidString).pp3")
-                do {
-                    try self.pp3String.write(to: tempPP3, atomically: true, encoding: .utf8)
-                } catch {
-                    DispatchQueue.main.async {
-                        self.toastMessage = "Failed to save .pp3 file!"
-                        self.isProcessingExport = false
-                    }
-                    return
-                }
-
-                let rldIters = rldIterationsFromPP3(self.pp3String)
+                // Settings go to the engine in memory; nothing is written to disk
+                let settings = RUDevelopSettings(pp3String: self.pp3String)
+                let rldIters = settings.deconvIterations
                 self.setStep("Decoding RAW (full-res)…",
-                        sub: rldIters != nil ? "RLD sharpening: \(rldIters!) iterations" : "")
-
-                // --- TIFF 16-bit (no compression) path ---
-                if self.outputFormat == .tiff {
-                    // Create 16-bit CGImage via Obj-C bridge
-                    guard let cg16 = RTPreviewDecoder.createCGImage16FromRAW(
-                            atPath: self.rawFileURL.path,
-                            jobID: self.exportJobID
-                        ) else {
-                        DispatchQueue.main.async {
-                            self.toastMessage = "Failed to decode RAW (16-bit)."
-                            self.isProcessingExport = false
-                        }
-                        return
-                    }
-
-                    var workCG: CGImage? = cg16
-
-                    // Crop (preview -> full-res pixels) in 16-bit space
-                    if let cropRect = self.cropRectInPreview,
-                       let previewSz = self.previewUIImageSize,
-                       previewSz.width > 0, previewSz.height > 0,
-                       let cg0 = workCG {
-                        self.setStep("Cropping…")
-                        let fullPx = pixelSize(of: cg0)
-                        let scaleX = fullPx.width  / previewSz.width
-                        let scaleY = fullPx.height / previewSz.height
-                        let mapped = CGRect(
-                            x: cropRect.origin.x * scaleX,
-                            y: cropRect.origin.y * scaleY,
-                            width:  cropRect.size.width  * scaleX,
-                            height: cropRect.size.height * scaleY
-                        )
-                        workCG = cropCGImage(cg0, to: mapped) ?? cg0
-                    }
-
-                    // Optional resize in 16-bit space
-                    if !self.useNativeSize, let cg0 = workCG {
-                        self.setStep("Resizing to \(self.maxEdge) px…")
-                        workCG = resizeCGImage16(cg0, longEdge: self.maxEdge) ?? cg0
-                    }
+                        sub: rldIters > 0 ? "RLD sharpening: \(rldIters) iterations" : "")
 
-                    guard let finalCG = workCG,
-                          let data = encodeTIFF16NoCompression(finalCG) else {
-                        DispatchQueue.main.async {
-                            self.isProcessingExport = false
-                            self.toastMessage = "TIFF encoding failed."
-                            self.finishedExport = true
-                        }
-                        return
-                    }
-
-                    DispatchQueue.main.async {
-                        self.exportImage = UIImage(cgImage: finalCG) // for size label only
-                        self.exportDocument = DataDocument(data: data)
-                        self.showExporter = true
-                        self.isProcessingExport = false
-                    }
-                    return
+                // --- 16-bit render (all formats): no 8-bit intermediate ---
+                // The crop goes to the engine normalized to the (upright) preview,
+                // so only that part of the sensor is developed.
+                let linearTIFF = self.outputFormat == .tiff && self.tiffLinear
+                var normalizedCrop = CGRect.null
+                if let cropRect = self.cropRectInPreview,
+                   let previewSz = self.previewUIImageSize,
+                   previewSz.width > 0, previewSz.height > 0,
+                   cropRect.width > 0, cropRect.height > 0 {
+                    normalizedCrop = CGRect(
+                        x: cropRect.origin.x / previewSz.width,
+                        y: cropRect.origin.y / previewSz.height,
+                        width:  cropRect.size.width  / previewSz.width,
+                        height: cropRect.size.height / previewSz.height
+                    ).intersection(CGRect(x: 0, y: 0, width: 1, height: 1))
                 }
-
-                // --- JPEG/PNG (8-bit) path using UIImage decode ---
-                guard var exportImg = RTPreviewDecoder.decodeRAWPreview(
-                    atPath: self.rawFileURL.path,
-                    withPP3Path: tempPP3.path,
-                    halfSize: false,
-                    jobID: self.exportJobID
-                ) else {
+                guard let cg16 = RTPreviewDecoder.createCGImage16FromRAW(
+                        atPath: self.rawFileURL.path,
+                        settings: settings,
+                        transfer: linearTIFF ? .linear : .sRGB,
+                        crop: normalizedCrop,
+                        longEdge: self.useNativeSize ? 0 : self.maxEdge,
+                        jobID: self.exportJobID
+                    ) else {
                     DispatchQueue.main.async {
-                        self.toastMessage = "Failed to decode RAW."
+                        self.toastMessage = "Failed to decode RAW (16-bit)."
                         self.isProcessingExport = false
                     }
                     return
                 }
-                exportImg = bakeOrientationUp(exportImg)
 
-                // Crop (preview -> full-res pixels)
-                if let cropRect = self.cropRectInPreview,
-                   let previewSz = self.previewUIImageSize,
-                   previewSz.width > 0, previewSz.height > 0 {
-                    self.setStep("Cropping…")
-                    let fullPx = pixelSize(of: exportImg)
-                    let scaleX = fullPx.width  / previewSz.width
-                    let scaleY = fullPx.height / previewSz.height
-                    let mapped = CGRect(
-                        x: cropRect.origin.x * scaleX,
-                        y: cropRect.origin.y * scaleY,
-                        width:  cropRect.size.width  * scaleX,
-                        height: cropRect.size.height * scaleY
-                    ).integral
-                    exportImg = exportImg.cropped(to: mapped.intersection(CGRect(origin: .zero, size: fullPx)))
-                }
+                var workCG: CGImage = cg16
 
-                // Resize
-                if !self.useNativeSize {
+                // The engine only scales down; upscaling stays a 16-bit CG resize
+                if !self.useNativeSize, max(workCG.width, workCG.height) < self.maxEdge {
                     self.setStep("Resizing to \(self.maxEdge) px…")
-                    exportImg = resizePixels(exportImg, longEdge: self.maxEdge)
+                    workCG = resizeCGImage16(workCG, longEdge: self.maxEdge) ?? workCG
                 }
 
-                // Encode (8-bit)
+                // Encode: TIFF stays 16-bit; PNG keeps 16 bpc; JPEG quantizes in ImageIO
                 self.setStep("Encoding \(self.outputFormat.rawValue)…")
-                guard let data = self.encodeData(for: exportImg,
-                                                 outputFormat: self.outputFormat,
-                                                 quality: self.quality,
-                                                 pngCompression: self.pngCompression) else {
+                let encoded: Data?
+                if self.outputFormat == .tiff {
+                    encoded = encodeTIFF16NoCompression(workCG, linear: linearTIFF)
+                } else {
+                    encoded = self.encodeData(for: workCG,
+                                              outputFormat: self.outputFormat,
+                                              quality: self.quality,
+                                              pngCompression: self.pngCompression)
+                }
+                guard let data = encoded else {
                     DispatchQueue.main.async {
                         self.isProcessingExport = false
-                        self.toastMessage = "Encoding failed."
+                        self.toastMessage = "\(self.outputFormat.rawValue) encoding failed."
                         self.finishedExport = true
                     }
                     return
                 }
 
+                let finalCG = workCG
                 DispatchQueue.main.async {
-                    if toPhotos {
+                    let exportImg = UIImage(cgImage: finalCG)
+                    if toPhotos && self.outputFormat != .tiff {
                         self.setStep("Saving to Photos…")
                         UIImageWriteToSavedPhotosAlbum(exportImg, nil, nil, nil)
                         UINotificationFeedbackGenerator().notificationOccurred(.success)
@@ -933,37 +903,7 @@ private func resizePixels(_ image: UIImage, longEdge: Int) -> UIImage {
     return renderer.image { _ in image.draw(in: CGRect(origin: .zero, size: newPx)) }
 }
 
-// Parse "DeconvIterations" (and the legacy "RLDeconvIterations") from a .pp3
-private func rldIterationsFromPP3(_ pp3: String) -> Int? {
-    let patterns = [
-        #"(?mi)^\s*DeconvIterations\s*=\s*(\d+)\s*$"#,
-        #"(?mi)^\s*RLDeconvIterations\s*=\s*(\d+)\s*$"#
-    ]
-    for pat in patterns {
-        if let re = try? NSRegularExpression(pattern: pat) {
-            let range = NSRange(pp3.startIndex..<pp3.endIndex, in: pp3)
-            if let m = re.firstMatch(in: pp3, options: [], range: range),
-               let r = Range(m.range(at: 1), in: pp3) {
-                return Int(pp3[r])
-            }
-        }
-    }
-    return nil
-}
-
-// Pixel size of a CGImage
-fileprivate func pixelSize(of cg: CGImage) -> CGSize {
-    CGSize(width: cg.width, height: cg.height)
-}
-
-// Crop a 16-bit CGImage (no depth loss)
-fileprivate func cropCGImage(_ cg: CGImage, to rectPx: CGRect) -> CGImage? {
-    let bounded = rectPx.integral.intersection(CGRect(x: 0, y: 0, width: cg.width, height: cg.height))
-    guard bounded.width > 0, bounded.height > 0 else { return nil }
-    return cg.cropping(to: bounded)
-}
-
-// Resize a 16-bit CGImage in 16-bit space (sRGB)
+// Resize a 16-bit CGImage in 16-bit space
 fileprivate func resizeCGImage16(_ cg: CGImage, longEdge: Int) -> CGImage? {
     let srcW = cg.width, srcH = cg.height
     let srcLong = max(srcW, srcH)
@@ -973,7 +913,8 @@ fileprivate func resizeCGImage16(_ cg: CGImage, longEdge: Int) -> CGImage? {
     let dstW = Int(CGFloat(srcW) * scale)
     let dstH = Int(CGFloat(srcH) * scale)
 
-    guard let cs = CGColorSpace(name: CGColorSpace.sRGB) else { return nil }
+    // Keep the source space (sRGB or Linear sRGB) so the transfer survives the resize
+    guard let cs = cg.colorSpace ?? CGColorSpace(name: CGColorSpace.sRGB) else { return nil }
     let bitmapInfo: CGBitmapInfo = [
         CGBitmapInfo.byteOrder16Big,
         CGBitmapInfo(rawValue: CGImageAlphaInfo.premultipliedLast.rawValue)
@@ -993,8 +934,8 @@ fileprivate func resizeCGImage16(_ cg: CGImage, longEdge: Int) -> CGImage? {
     return ctx.makeImage()
 }
 
-// 16-bit TIFF encoder (no compression), sRGB profile
-fileprivate func encodeTIFF16NoCompression(_ cg: CGImage) -> Data? {
+// 16-bit TIFF encoder (no compression); the image's space (sRGB or Linear sRGB) is embedded
+fileprivate func encodeTIFF16NoCompression(_ cg: CGImage, linear: Bool = false) -> Data? {
     let data = NSMutableData()
     guard let dest = CGImageDestinationCreateWithData(
         data as CFMutableData,
@@ -1002,13 +943,13 @@ fileprivate func encodeTIFF16NoCompression(_ cg: CGImage) -> Data? {
         1, nil
     ) else { return nil }
 
-    let props: [CFString: Any] = [
-        kCGImagePropertyProfileName: "sRGB IEC61966-2.1",
+    var props: [CFString: Any] = [
         kCGImagePropertyTIFFDictionary: [
             // 1 = None (uncompressed)
             kCGImagePropertyTIFFCompression as String: 1
         ]
     ]
+    if !linear { props[kCGImagePropertyProfileName] = "sRGB IEC61966-2.1" }
 
     CGImageDestinationAddImage(dest, cg, props as CFDictionary)
     CGImageDestinationFinalize(dest)
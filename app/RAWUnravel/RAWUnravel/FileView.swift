@@ -135,8 +135,14 @@
                  // increment generation and start load
                  loadGeneration += 1
                  loadThumbnailAndMetadata(generation: loadGeneration)
+                 // likely opened next: warm its first develop render in the background
+                 if isRawImage(fileURL) { RUPrefetcher.shared.prefetch(path: fileURL.path) }
                  print("[DBG] FileView onAppear; fileURL=\(fileURL.path) isRaw=\(isRawImage(fileURL))")
              }
+             .onDisappear {
+                 // going to DevelopScreen keeps the warm decode for it
+                 if !showDevelop { RUPrefetcher.shared.cancel(path: fileURL.path) }
+             }
          }
          // --- OUTSIDE VStack: Attach fileImporter and sheet for new file ---
          .fileImporter(
@@ -309,6 +315,24 @@
          }
 
          DispatchQueue.global(qos: .userInitiated).async {
+             // Thumbnail store hit: no ImageIO work at all
+             if let cached = RUThumbnailStore.shared.entry(for: fileURL) {
+                 DispatchQueue.main.async {
+                     if gen != loadGeneration { return }
+                     self.image = cached.thumbnail
+                     self.previewPixelSize = cached.previewSize == .zero ? nil : cached.previewSize
+                     self.metadata = cached.metadata
+                     if let w = cached.metadata[kCGImagePropertyPixelWidth as String] as? Int,
+                        let h = cached.metadata[kCGImagePropertyPixelHeight as String] as? Int {
+                         self.rawSize = CGSize(width: w, height: h)
+                     } else {
+                         self.rawSize = nil
+                     }
+                     self.isLoading = false
+                 }
+                 return
+             }
+
              let originalURL = fileURL
              var attemptURL = fileURL
              var didStartAccess = false
@@ -407,6 +431,11 @@
                  }
              }
 
+             if let thumb = foundThumb, let md = foundMetadata {
+                 RUThumbnailStore.shared.store(thumbnail: thumb, metadata: md,
+                                               previewSize: embeddedPreviewSize ?? .zero, for: originalURL)
+             }
+
              DispatchQueue.main.async {
                  if gen != loadGeneration { return }
 
@@ -470,8 +499,8 @@
      @ViewBuilder
      func metadataSection(for url: URL) -> some View {
          // ---- Gather everything first (no ViewBuilder here) ----
-         let src = CGImageSourceCreateWithURL(url as CFURL, nil)
-         let props = src.flatMap { CGImageSourceCopyPropertiesAtIndex($0, 0, nil) as? [CFString: Any] }
+         // From the loaded (or cached) properties; the view body never opens the file.
+         let props = metadata.isEmpty ? nil : (metadata as NSDictionary) as? [CFString: Any]
 
          let tiff = props?[kCGImagePropertyTIFFDictionary] as? [CFString: Any]
          let exif = props?[kCGImagePropertyExifDictionary] as? [CFString: Any]
@@ -643,6 +672,10 @@ func getEmbeddedJPEGPreviewSize(_ url: URL) -> CGSize? {
 
 func displayBaseFilename(from url: URL) -> String {
     var filename = url.lastPathComponent
+    // Import-store copies are "<content key>-<name>"
+    if let original = RUImportCache.shared.originalName(forPath: url.path) {
+        filename = original
+    }
     // Loop to remove ALL leading "<uuid>-" prefixes
     while filename.count > 37, filename.prefix(36).allSatisfy({ $0.isHexDigit || $0 == "-" }) {
         let uuidCandidate = String(filename.prefix(36))
@@ -0,0 +1,68 @@
+/*
+    RawUnravel - HistogramOverlay.swift
+    -----------------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+import SwiftUI
+
+// MARK: - HistogramOverlay
+// Small translucent RGB + luma histogram of the current preview, drawn from
+// the RUImageHistogram the decoder keeps for the file's last render.
+struct HistogramOverlay: View {
+    let histogram: RUImageHistogram
+
+    var body: some View {
+        ZStack {
+            curve(.luma).fill(Color.white.opacity(0.35))
+            curve(.red).fill(Color.red.opacity(0.45))
+            curve(.green).fill(Color.green.opacity(0.45))
+            curve(.blue).fill(Color.blue.opacity(0.45))
+        }
+        .frame(width: 160, height: 64)
+        .padding(6)
+        .background(Color.black.opacity(0.45))
+        .cornerRadius(8)
+        .allowsHitTesting(false)
+        .accessibilityHidden(true)
+    }
+
+    private func curve(_ channel: RUHistogramChannel) -> HistogramShape {
+        HistogramShape(values: histogram.normalizedValues(for: channel).map { CGFloat($0.floatValue) })
+    }
+}
+
+// Filled polyline over the bins; square-root scaled so midtones stay visible
+// next to a tall clipped bin.
+private struct HistogramShape: Shape {
+    let values: [CGFloat]
+
+    func path(in rect: CGRect) -> Path {
+        var p = Path()
+        guard values.count > 1 else { return p }
+        let dx = rect.width / CGFloat(values.count - 1)
+        p.move(to: CGPoint(x: rect.minX, y: rect.maxY))
+        for (i, v) in values.enumerated() {
+            p.addLine(to: CGPoint(x: rect.minX + CGFloat(i) * dx,
+                                  y: rect.maxY - rect.height * v.squareRoot()))
+        }
+        p.addLine(to: CGPoint(x: rect.maxX, y: rect.maxY))
+        p.closeSubpath()
+        return p
+    }
+}
@@ -26,7 +26,6 @@
 #import <algorithm>
 #import <cmath>
 #import <memory>
-#import <dlfcn.h>
 #include <cstddef>
 #import "RTPreviewDecoder.h"
 #import "RUShared.h"
@@ -72,60 +71,8 @@ extern "C" UIImage * _Nullable RUApplyFlipToUIImage(UIImage * _Nullable src, int
 // This file must be compiled as Objective-C++ (.mm)
 // because it mixes ObjC/UIKit, C, and C++ features.
 
-// MARK: - dlsym helpers (AMAZE / X-Trans)
-//
-// These dynamically resolve libRTProcess entry points for AMAZE and X-Trans
-// demosaicers. We use dlsym() to avoid hard-linking against specific symbols
-// (helps with iOS simulator/device mismatches).
-
-using AmazeFn = int (*)(const float*, int, int, const unsigned[4], float*, float*, float*);
-static AmazeFn loadAmaze() {
-    static AmazeFn fn = nullptr;
-    static bool tried = false;
-    if (tried) return fn;
-    tried = true;
-
-    const char *cands[] = { "amaze_demosaic", "rp_demosaic_amaze" };
-    for (const char *nm : cands) {
-        if (void *p = dlsym(RTLD_DEFAULT, nm)) {
-            fn = (AmazeFn)p;
-            break;
-        }
-    }
-    return fn;
-}
-
-using XTransFn = int (*)(const float*, const float*, const float*, int, int, const unsigned[6][6],
-                         float*, float*, float*);
-static XTransFn loadXTrans() {
-    static XTransFn fn = nullptr;
-    static bool tried = false;
-    if (tried) return fn;
-    tried = true;
-
-    const char *cands[] = { "xtrans_demosaic", "rp_demosaic_xtrans" };
-    for (const char *nm : cands) {
-        if (void *p = dlsym(RTLD_DEFAULT, nm)) {
-            fn = (XTransFn)p;
-            break;
-        }
-    }
-    return fn;
-}
-
-// Exported C-ABI bridge functions called from RTPreviewDecoder.mm
-extern "C" int bridge_amaze_demosaic(const float *mono, int W, int H, const unsigned cf4[4],
-                                     float *R, float *G, float *B) {
-    AmazeFn fn = loadAmaze();
-    return fn ? fn(mono, W, H, cf4, R, G, B) : -1;
-}
-
-extern "C" int bridge_xtrans_demosaic(const float *P0, const float *P1, const float *P2,
-                                      int W, int H, const unsigned xtrans[6][6],
-                                      float *R, float *G, float *B) {
-    XTransFn fn = loadXTrans();
-    return fn ? fn(P0, P1, P2, W, H, xtrans, R, G, B) : -1;
-}
+// Demosaic bridges (bridge_amaze_demosaic / bridge_xtrans_demosaic) live in
+// RUDemosaic.cpp, shared with the portable build.
 
 // MARK: - Orientation helpers
 //
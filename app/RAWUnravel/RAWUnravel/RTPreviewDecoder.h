@@ -3,11 +3,123 @@
 
 #import <UIKit/UIKit.h>
 #import <CoreGraphics/CoreGraphics.h>
+#import "RUDevelopSettings.h"
+#import "RUImageHistogram.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+/// Transfer function of 16-bit exports (both use sRGB primaries).
+typedef NS_ENUM(NSInteger, RUExportTransfer) {
+    RUExportTransferSRGB NS_SWIFT_NAME(sRGB) = 0,   ///< sRGB TRC, tagged sRGB IEC61966-2.1
+    RUExportTransferLinear = 1,                     ///< linear light, tagged Linear sRGB
+};
+
+/// Clipping mask written while previews are packed (bits per pixel).
+typedef NS_ENUM(NSInteger, RUClipMaskMode) {
+    RUClipMaskModeOff = 0,
+    RUClipMaskModeOneBit = 1,    ///< any clipping, one colour
+    RUClipMaskModeEightBit = 8,  ///< raw / tone / gamut flags kept apart
+};
+
+/// Progress of a render job at the moment it was sampled.
+@interface RUJobProgress : NSObject
+@property (nonatomic, readonly) NSString *phase;   ///< "libraw", "rld", "batch", …
+@property (nonatomic, readonly) NSString *step;
+@property (nonatomic, readonly) NSInteger iter;
+@property (nonatomic, readonly) NSInteger total;
+- (instancetype)init NS_UNAVAILABLE;
+- (instancetype)initWithPhase:(NSString *)phase step:(NSString *)step
+                         iter:(NSInteger)iter total:(NSInteger)total NS_DESIGNATED_INITIALIZER;
+@end
+
 @interface RTPreviewDecoder : NSObject
 
+/// Rows per band for full-res renders (default 512; raised to 4× the RLD halo
+/// when sharpening is on). Float working memory is bounded by one band plus
+/// demosaic/RLD halo rows; 0 renders the whole frame at once.
+@property (class, nonatomic) NSInteger fullResBandRows;
+
+/// Binned previews run RLD planes and scratch in FP16 (YES by default where
+/// half conversions are native: ARM, x86 with F16C). Full-res/export renders
+/// always use FP32.
+@property (class, nonatomic) BOOL previewHalfFloat;
+
+/// Previews also record where the raw data clipped, where tone ops pushed a
+/// channel past white and where the camera matrix left sRGB gamut. Off by
+/// default; see clippingOverlay(forPath:).
+@property (class, nonatomic) RUClipMaskMode clipMaskMode;
+
+/// Renders record their stages (name, duration, bytes touched, cache hit or
+/// miss) into per-thread rings and, on Apple platforms, as os_signpost
+/// intervals for Instruments. On by default; see stageTimings(forPath:).
+@property (class, nonatomic) BOOL tracingEnabled;
+
+/// Drops the cached preview stages (base and sharpened planes) and trims the
+/// buffer pool. Also runs on memory warnings once registerForMemoryWarnings
+/// has been called.
++ (void)purgeCaches;
+
+/// Runs purgeCaches on every memory warning. Call once at launch; later calls
+/// do nothing.
++ (void)registerForMemoryWarnings;
+
+/// Ends the render session of a file: its sticky auto-EV, cached metadata and
+/// preview planes are released once in-flight renders finish. The next decode
+/// of the file starts a new session.
++ (void)endSessionForPath:(NSString *)rawPath
+NS_SWIFT_NAME(endSession(forPath:));
+
+/// Asks the binned preview running under `jobID` to stop: it returns nil at
+/// its next stage boundary (planes already built stay cached in the file's
+/// session). Job IDs are single-use; cancelling a finished job does nothing.
++ (void)cancelJob:(NSString *)jobID
+NS_SWIFT_NAME(cancelJob(_:));
+
+/// Latest progress of `jobID`; nil before its first update. Workers only
+/// store into the job's record, and the "RawUnravelProgress" notification
+/// fires on phase/step changes alone, so per-iteration counters (RLD, bands,
+/// batch counts) are read here, e.g. from a TimelineView at display rate.
++ (nullable RUJobProgress *)progressForJob:(NSString *)jobID
+NS_SWIFT_NAME(progress(forJob:));
+
+/// Decodes `rawPath` from `data` from now on: every entry point below reads
+/// the RAW (and its embedded previews) out of `data` through a LibRaw buffer
+/// datastream, never from disk. Use mapped data (Data(contentsOf:options:
+/// .alwaysMapped)) to avoid copying the file at all. `rawPath` is the file's
+/// name for the session; it need not exist, and if it does it must be the
+/// same size. `data` is held until endSession(forPath:). NO if rejected.
++ (BOOL)attachRAWData:(NSData *)data toPath:(NSString *)rawPath
+NS_SWIFT_NAME(attachRAWData(_:toPath:));
+
+/// As above, mapping an open descriptor (regular file; it may be closed or
+/// the file unlinked once this returns).
++ (BOOL)attachRAWFileDescriptor:(int)fd toPath:(NSString *)rawPath
+NS_SWIFT_NAME(attachRAWFileDescriptor(_:toPath:));
+
+/// Display histogram of the last preview rendered for this file (built while
+/// packing the preview, so it costs no extra pass); nil before the first one.
++ (nullable RUImageHistogram *)histogramForPath:(NSString *)rawPath
+NS_SWIFT_NAME(histogram(forPath:));
+
+/// Translucent overlay (same size and orientation as the preview) of the
+/// clipping mask of the last preview rendered for this file; nil when
+/// clipMaskMode was off for it.
++ (nullable UIImage *)clippingOverlayForPath:(NSString *)rawPath
+NS_SWIFT_NAME(clippingOverlay(forPath:));
+
+/// Stages of the last render of this file (preview or full-res), in the order
+/// they started: "name", "category" (NSString), "start" and "duration"
+/// (seconds, NSNumber; start is relative to the first stage), "bytes",
+/// "thread" (NSNumber) and "cache" (@"hit"/@"miss", absent when the stage has
+/// no cache). nil before the first traced render.
++ (nullable NSArray<NSDictionary<NSString *, id> *> *)stageTimingsForPath:(NSString *)rawPath
+NS_SWIFT_NAME(stageTimings(forPath:));
+
+/// Writes every stage still in the trace rings as a Chrome trace-event JSON
+/// file (chrome://tracing, Perfetto). NO if nothing could be written.
++ (BOOL)writeTraceToPath:(NSString *)path
+NS_SWIFT_NAME(writeTrace(toPath:));
+
 /// Half/Full preview entry (UIImage).
 + (nullable UIImage *)decodeRAWPreviewAtPath:(NSString *)rawPath
                                  withPP3Path:(nullable NSString *)pp3Path
@@ -15,6 +127,22 @@ NS_ASSUME_NONNULL_BEGIN
                                        jobID:(nullable NSString *)jobID
 NS_SWIFT_NAME(decodeRAWPreview(atPath:withPP3Path:halfSize:jobID:));
 
+/// Binned preview straight from the sensor mosaic: binFactor 2, 3 or 4
+/// (1/2, 1/3, 1/4 scale, Bayer and X-Trans); 1 selects the full-res path.
++ (nullable UIImage *)decodeRAWPreviewAtPath:(NSString *)rawPath
+                                 withPP3Path:(nullable NSString *)pp3Path
+                                   binFactor:(NSInteger)binFactor
+                                       jobID:(nullable NSString *)jobID
+NS_SWIFT_NAME(decodeRAWPreview(atPath:withPP3Path:binFactor:jobID:));
+
+/// Binned preview with in-memory settings (no .pp3 round trip). Planes from the
+/// previous render of the same file are reused when only later stages changed.
++ (nullable UIImage *)decodeRAWPreviewAtPath:(NSString *)rawPath
+                                    settings:(nullable RUDevelopSettings *)settings
+                                   binFactor:(NSInteger)binFactor
+                                       jobID:(nullable NSString *)jobID
+NS_SWIFT_NAME(decodeRAWPreview(atPath:settings:binFactor:jobID:));
+
 /// Convenience: half-size superpixel/fast preview (UIImage).
 + (nullable UIImage *)previewSuperpixelAtPath:(NSString *)rawPath
                                         jobID:(nullable NSString *)jobID
@@ -31,6 +159,31 @@ NS_SWIFT_NAME(fullResAMAZE(atPath:jobID:));
 CF_RETURNS_RETAINED
 NS_SWIFT_NAME(createCGImage16FromRAW(atPath:jobID:));
 
+/// 16-bit export render: same develop pipeline as full-res (PP3 applied), packed
+/// to RGB16 straight from the float planes, orientation baked (caller must CFRelease).
+/// `crop` is normalized (0..1) in displayed orientation; only that part of the
+/// sensor is developed. CGRectNull exports the whole frame.
+/// `longEdge` > 0 downscales (never up) in linear light right after demosaic,
+/// so RLD and the later stages run at output size; 0 keeps native resolution.
++ (nullable CGImageRef)createCGImage16FromRAWAtPath:(NSString *)rawPath
+                                            pp3Path:(nullable NSString *)pp3Path
+                                           transfer:(RUExportTransfer)transfer
+                                               crop:(CGRect)crop
+                                           longEdge:(NSInteger)longEdge
+                                              jobID:(nullable NSString *)jobID
+CF_RETURNS_RETAINED
+NS_SWIFT_NAME(createCGImage16FromRAW(atPath:pp3Path:transfer:crop:longEdge:jobID:));
+
+/// As above, with the settings passed in memory (no file round trip).
++ (nullable CGImageRef)createCGImage16FromRAWAtPath:(NSString *)rawPath
+                                           settings:(nullable RUDevelopSettings *)settings
+                                           transfer:(RUExportTransfer)transfer
+                                               crop:(CGRect)crop
+                                           longEdge:(NSInteger)longEdge
+                                              jobID:(nullable NSString *)jobID
+CF_RETURNS_RETAINED
+NS_SWIFT_NAME(createCGImage16FromRAW(atPath:settings:transfer:crop:longEdge:jobID:));
+
 /// Read active RAW size quickly.
 + (CGSize)rawActiveSizeAtPath:(NSString *)rawPath
 NS_SWIFT_NAME(rawActiveSize(atPath:));
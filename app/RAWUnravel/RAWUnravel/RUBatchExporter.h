@@ -0,0 +1,105 @@
+/*
+    RawUnravel - RUBatchExporter.h
+    ------------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Native batch export: a FIFO of (RAW, PP3 settings, crop, size, format) jobs
+// run by a small worker pool. Concurrency is capped by core count and by a
+// memory budget, using a per-job estimate from the frame's pixel count. Jobs
+// share the decoder's recycled LibRaw handles and the process buffer pool.
+//
+// Progress: the decoder's own PostProgress steps arrive under each job's
+// jobID; the queue adds phase "batch" with steps "start", "done", "failed"
+// (per job) and "progress" (iter = finished, total = submitted) under the
+// exporter's batchID. Only step changes are notified; read the counts with
+// +[RTPreviewDecoder progressForJob:batchID].
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+#import "RTPreviewDecoder.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(NSInteger, RUBatchFormat) {
+    RUBatchFormatJPEG   = 0,   ///< 8-bit, sRGB
+    RUBatchFormatPNG    = 1,   ///< 16 bpc, sRGB
+    RUBatchFormatTIFF16 = 2,   ///< 16 bpc uncompressed, sRGB or linear
+};
+
+@interface RUBatchExportJob : NSObject
+
+- (instancetype)initWithRAWPath:(NSString *)rawPath outputURL:(NSURL *)outputURL NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic, copy, readonly) NSString *rawPath;
+@property (nonatomic, copy, readonly) NSURL *outputURL;
+/// PostProgress key of this job (UUID).
+@property (nonatomic, copy, readonly) NSString *jobID;
+
+/// Develop settings; nil develops with defaults.
+@property (nonatomic, copy, nullable) RUDevelopSettings *settings;
+/// Normalized crop in displayed orientation; CGRectNull (default) = whole frame.
+@property (nonatomic) CGRect crop;
+/// Output long edge in pixels; 0 (default) = native.
+@property (nonatomic) NSInteger longEdge;
+@property (nonatomic) RUBatchFormat format;
+/// JPEG quality 10...100 (default 85).
+@property (nonatomic) NSInteger quality;
+/// TIFF only: sRGB (default) or linear light.
+@property (nonatomic) RUExportTransfer transfer;
+
+@end
+
+/// Called on the main queue when a job finishes (error nil) or fails.
+typedef void (^RUBatchJobCompletion)(RUBatchExportJob *job, NSError * _Nullable error);
+
+@interface RUBatchExporter : NSObject
+
+@property (class, nonatomic, readonly) RUBatchExporter *shared;
+
+/// Jobs in flight at once; 0 (default) = half the active cores, 1...4.
+/// Each job is itself multithreaded, so more rarely helps.
+@property (atomic) NSInteger maxConcurrentJobs;
+
+/// Estimated bytes all running jobs may hold; 0 (default) = 1/4 of physical
+/// memory. A single job larger than the budget still runs, alone.
+@property (atomic) uint64_t memoryBudgetBytes;
+
+/// PostProgress key for the aggregate "batch"/"progress" posts.
+@property (nonatomic, copy, readonly) NSString *batchID;
+
+/// Finished images per minute since the queue last went busy.
+@property (atomic, readonly) double imagesPerMinute;
+@property (atomic, readonly) NSInteger pendingCount;
+@property (atomic, readonly) NSInteger runningCount;
+
+- (void)enqueueJobs:(NSArray<RUBatchExportJob *> *)jobs
+         completion:(nullable RUBatchJobCompletion)completion
+NS_SWIFT_NAME(enqueue(_:completion:));
+
+/// Drops jobs that have not started; running jobs finish normally.
+- (void)cancelPendingJobs;
+
+/// Rough peak bytes for exporting `job` (raw mosaic + band working set +
+/// output + encoder copy), from the file's pixel count.
++ (uint64_t)estimatedBytesForJob:(RUBatchExportJob *)job;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,270 @@
+/*
+    RawUnravel - RUBatchExporter.mm
+    -------------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+*/
+
+#import "RUBatchExporter.h"
+#import "RUShared.h"
+#import "RUBufferPool.h"
+#import <ImageIO/ImageIO.h>
+#import <UniformTypeIdentifiers/UniformTypeIdentifiers.h>
+#import <QuartzCore/QuartzCore.h>
+#import <algorithm>
+#import <cmath>
+
+static NSString *const kRUBatchErrorDomain = @"RUBatchExporter";
+
+// MARK: - Job
+
+@implementation RUBatchExportJob
+
+- (instancetype)initWithRAWPath:(NSString *)rawPath outputURL:(NSURL *)outputURL {
+    if ((self = [super init])) {
+        _rawPath   = [rawPath copy];
+        _outputURL = [outputURL copy];
+        _jobID     = [NSUUID UUID].UUIDString;
+        _crop      = CGRectNull;
+        _format    = RUBatchFormatJPEG;
+        _quality   = 85;
+        _transfer  = RUExportTransferSRGB;
+    }
+    return self;
+}
+
+@end
+
+// MARK: - Encoding
+
+// Same container settings as the interactive export (ExportJPGView).
+static BOOL RU_BatchWriteImage(CGImageRef cg, RUBatchExportJob *job, NSError **error) {
+    CFStringRef type = (job.format == RUBatchFormatPNG)    ? (__bridge CFStringRef)UTTypePNG.identifier
+                     : (job.format == RUBatchFormatTIFF16) ? (__bridge CFStringRef)UTTypeTIFF.identifier
+                     :                                       (__bridge CFStringRef)UTTypeJPEG.identifier;
+    CGImageDestinationRef dest = CGImageDestinationCreateWithURL((__bridge CFURLRef)job.outputURL, type, 1, NULL);
+    if (!dest) {
+        if (error) *error = [NSError errorWithDomain:kRUBatchErrorDomain code:2
+                                            userInfo:@{NSLocalizedDescriptionKey: @"Cannot create output file."}];
+        return NO;
+    }
+
+    NSMutableDictionary *props = [NSMutableDictionary dictionary];
+    const bool linear = (job.format == RUBatchFormatTIFF16 && job.transfer == RUExportTransferLinear);
+    if (!linear) props[(id)kCGImagePropertyProfileName] = @"sRGB IEC61966-2.1";
+    switch (job.format) {
+        case RUBatchFormatJPEG:
+            props[(id)kCGImageDestinationLossyCompressionQuality] =
+                @((double)std::clamp<NSInteger>(job.quality, 10, 100) / 100.0);
+            break;
+        case RUBatchFormatPNG:
+            break;
+        case RUBatchFormatTIFF16:
+            props[(id)kCGImagePropertyTIFFDictionary] = @{ (id)kCGImagePropertyTIFFCompression: @1 }; // none
+            break;
+    }
+
+    CGImageDestinationAddImage(dest, cg, (__bridge CFDictionaryRef)props);
+    const bool ok = CGImageDestinationFinalize(dest);
+    CFRelease(dest);
+    if (!ok && error) *error = [NSError errorWithDomain:kRUBatchErrorDomain code:3
+                                               userInfo:@{NSLocalizedDescriptionKey: @"Encoding failed."}];
+    return ok;
+}
+
+// MARK: - Exporter
+
+@interface RUBatchEntry : NSObject
+@property (nonatomic, strong) RUBatchExportJob *job;
+@property (nonatomic, copy, nullable) RUBatchJobCompletion completion;
+@property (nonatomic) uint64_t bytes;
+@end
+@implementation RUBatchEntry
+@end
+
+@implementation RUBatchExporter {
+    dispatch_queue_t _q;                     // guards everything below
+    NSMutableArray<RUBatchEntry *> *_pending;
+    NSInteger _running;
+    uint64_t  _inFlightBytes;
+    NSInteger _submitted, _finished;
+    CFTimeInterval _busySince;
+    double    _imagesPerMinute;
+}
+
++ (RUBatchExporter *)shared {
+    static RUBatchExporter *s;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{ s = [RUBatchExporter new]; });
+    return s;
+}
+
+- (instancetype)init {
+    if ((self = [super init])) {
+        _q       = dispatch_queue_create("rawunravel.batch-export", DISPATCH_QUEUE_SERIAL);
+        _pending = [NSMutableArray array];
+        _batchID = [NSUUID UUID].UUIDString;
+    }
+    return self;
+}
+
+- (double)imagesPerMinute { __block double v; dispatch_sync(_q, ^{ v = self->_imagesPerMinute; }); return v; }
+- (NSInteger)pendingCount { __block NSInteger v; dispatch_sync(_q, ^{ v = (NSInteger)self->_pending.count; }); return v; }
+- (NSInteger)runningCount { __block NSInteger v; dispatch_sync(_q, ^{ v = self->_running; }); return v; }
+
+- (NSInteger)effectiveMaxJobs {
+    const NSInteger n = self.maxConcurrentJobs;
+    if (n > 0) return n;
+    return std::clamp<NSInteger>((NSInteger)NSProcessInfo.processInfo.activeProcessorCount / 2, 1, 4);
+}
+
+- (uint64_t)effectiveBudget {
+    const uint64_t b = self.memoryBudgetBytes;
+    return b ? b : NSProcessInfo.processInfo.physicalMemory / 4;
+}
+
++ (uint64_t)estimatedBytesForJob:(RUBatchExportJob *)job {
+    double W = 0, H = 0;
+    CGImageSourceRef src = CGImageSourceCreateWithURL((__bridge CFURLRef)[NSURL fileURLWithPath:job.rawPath],
+                                                      (__bridge CFDictionaryRef)@{(id)kCGImageSourceShouldCache: @NO});
+    if (src) {
+        NSDictionary *props = CFBridgingRelease(CGImageSourceCopyPropertiesAtIndex(src, 0, NULL));
+        W = [props[(id)kCGImagePropertyPixelWidth] doubleValue];
+        H = [props[(id)kCGImagePropertyPixelHeight] doubleValue];
+        CFRelease(src);
+    }
+    if (W <= 0 || H <= 0) {
+        // Unknown to ImageIO: ~1.5 bytes per pixel is typical for compressed 12/14-bit raws.
+        NSNumber *sz = [[NSFileManager defaultManager] attributesOfItemAtPath:job.rawPath error:nil][NSFileSize];
+        const double px = std::max(1.0, sz.doubleValue / 1.5);
+        W = std::sqrt(px * 1.5); H = px / W;
+    }
+
+    double cw = 1, ch = 1;
+    if (!CGRectIsNull(job.crop) && !CGRectIsEmpty(job.crop)) {
+        const CGRect c = CGRectIntersection(job.crop, CGRectMake(0, 0, 1, 1));
+        if (!CGRectIsEmpty(c)) { cw = c.size.width; ch = c.size.height; }
+    }
+    const double rw = W * cw, rh = H * ch;
+    const double s  = job.longEdge > 0 ? std::min(1.0, job.longEdge / std::max(rw, rh)) : 1.0;
+    const double outPx = rw * rh * s * s;
+
+    const NSInteger bandReq = RTPreviewDecoder.fullResBandRows;
+    const double band = (bandReq > 0 ? std::min<double>(rh, bandReq) : rh) + 128; // + halos
+    const double work = 4 * sizeof(float) * (rw + 128) * band;                    // R, G, B, mono
+    const double planes = (s < 1.0) ? 3 * sizeof(float) * outPx : 0;             // scaled output planes
+
+    return (uint64_t)(2 * W * H            // raw_image
+                      + work + planes
+                      + 6 * outPx          // RGB16 pack
+                      + 6 * outPx);        // encoder copy
+}
+
+- (void)enqueueJobs:(NSArray<RUBatchExportJob *> *)jobs completion:(RUBatchJobCompletion)completion {
+    NSArray<RUBatchExportJob *> *copy = [jobs copy];
+    dispatch_async(_q, ^{
+        if (self->_running == 0 && self->_pending.count == 0) {
+            self->_busySince = CACurrentMediaTime();
+            self->_submitted = self->_finished = 0;
+        }
+        for (RUBatchExportJob *job in copy) {
+            RUBatchEntry *e = [RUBatchEntry new];
+            e.job = job;
+            e.completion = completion;
+            e.bytes = [RUBatchExporter estimatedBytesForJob:job];
+            [self->_pending addObject:e];
+            self->_submitted++;
+        }
+        PostProgress(self->_batchID, @"batch", @"progress", self->_finished, self->_submitted);
+        [self pump];
+    });
+}
+
+- (void)cancelPendingJobs {
+    dispatch_async(_q, ^{
+        NSArray<RUBatchEntry *> *dropped = [self->_pending copy];
+        [self->_pending removeAllObjects];
+        self->_submitted -= (NSInteger)dropped.count;
+        NSError *err = [NSError errorWithDomain:NSCocoaErrorDomain code:NSUserCancelledError userInfo:nil];
+        for (RUBatchEntry *e in dropped) {
+            PostProgress(e.job.jobID, @"batch", @"failed", 0, 0);
+            if (e.completion) dispatch_async(dispatch_get_main_queue(), ^{ e.completion(e.job, err); });
+        }
+        PostProgress(self->_batchID, @"batch", @"progress", self->_finished, self->_submitted);
+        [self drainIfIdle];
+    });
+}
+
+// On _q. Starts jobs in FIFO order while a slot is free and the head fits the
+// memory budget; the head job always runs if nothing else is running.
+- (void)pump {
+    const NSInteger maxJobs = [self effectiveMaxJobs];
+    const uint64_t  budget  = [self effectiveBudget];
+    while (_pending.count && _running < maxJobs) {
+        RUBatchEntry *e = _pending.firstObject;
+        if (_running > 0 && _inFlightBytes + e.bytes > budget) break;
+        [_pending removeObjectAtIndex:0];
+        _running++;
+        _inFlightBytes += e.bytes;
+        [self start:e];
+    }
+}
+
+- (void)start:(RUBatchEntry *)e {
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        NSError *err = nil;
+        @autoreleasepool {
+            RUBatchExportJob *job = e.job;
+            PostProgress(job.jobID, @"batch", @"start", 0, 0);
+            const RUExportTransfer transfer =
+                (job.format == RUBatchFormatTIFF16) ? job.transfer : RUExportTransferSRGB;
+            CGImageRef cg = [RTPreviewDecoder createCGImage16FromRAWAtPath:job.rawPath
+                                                                  settings:job.settings
+                                                                  transfer:transfer
+                                                                      crop:job.crop
+                                                                  longEdge:job.longEdge
+                                                                     jobID:job.jobID];
+            if (!cg) {
+                err = [NSError errorWithDomain:kRUBatchErrorDomain code:1
+                                      userInfo:@{NSLocalizedDescriptionKey: @"Failed to decode RAW."}];
+            } else {
+                RU_BatchWriteImage(cg, job, &err);
+                CGImageRelease(cg);
+            }
+            PostProgress(job.jobID, @"batch", err ? @"failed" : @"done", 0, 0);
+        }
+        dispatch_async(self->_q, ^{
+            self->_running--;
+            self->_inFlightBytes -= e.bytes;
+            self->_finished++;
+            const double minutes = (CACurrentMediaTime() - self->_busySince) / 60.0;
+            self->_imagesPerMinute = minutes > 0 ? self->_finished / minutes : 0;
+            PostProgress(self->_batchID, @"batch", @"progress", self->_finished, self->_submitted);
+            if (e.completion) dispatch_async(dispatch_get_main_queue(), ^{ e.completion(e.job, err); });
+            [self pump];
+            [self drainIfIdle];
+        });
+    });
+}
+
+// On _q. Hands idle pooled buffers back to the system once the queue empties.
+- (void)drainIfIdle {
+    if (_running == 0 && _pending.count == 0) RUBufferPool::shared().trim();
+}
+
+@end
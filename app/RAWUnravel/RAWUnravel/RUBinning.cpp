@@ -0,0 +1,268 @@
+/*
+    RawUnravel - RUBinning.cpp
+    --------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RUBinning.h"
+#include "RUParallel.h"
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// MARK: - Bayer quad layout
+// Positions p = 0..3 are (dy,dx) = (0,0) (0,1) (1,0) (1,1) inside the quad.
+struct RUQuad {
+    int   posR = -1, posB = -1, posG0 = -1, posG1 = -1;
+    float blk[4];   // black per position
+    float inv[4];   // 1/(white-black) per position
+};
+
+static bool ru_quad_from_mosaic(const RURawMosaic &m, RUQuad &q) {
+    if (m.period != 2) return false;
+    for (int p = 0; p < 4; ++p) {
+        const int c = m.cfa[p >> 1][p & 1];
+        switch (c) {
+            case 0: if (q.posR >= 0) return false; q.posR = p; break;
+            case 2: if (q.posB >= 0) return false; q.posB = p; break;
+            case 1: case 3:
+                if (q.posG0 < 0) q.posG0 = p;
+                else if (q.posG1 < 0) q.posG1 = p;
+                else return false;
+                break;
+            default: return false;
+        }
+        q.blk[p] = m.black[c];
+        q.inv[p] = 1.f / std::max(1.f, m.white - m.black[c]);
+    }
+    return q.posR >= 0 && q.posB >= 0 && q.posG0 >= 0 && q.posG1 >= 0;
+}
+
+// Scalar tail / fallback: x in [x0, x1) of output row `y`.
+static inline void ru_quad_row_scalar(const RURawMosaic &m, const RUQuad &q, int y, int x0, int x1,
+                                      float *R, float *G, float *B)
+{
+    const uint16_t *rows[2] = { m.row(2 * y), m.row(2 * y + 1) };
+    for (int x = x0; x < x1; ++x) {
+        float v[4];
+        for (int p = 0; p < 4; ++p) {
+            const float s = (float)rows[p >> 1][2 * x + (p & 1)];
+            v[p] = std::max(0.f, (s - q.blk[p]) * q.inv[p]);
+        }
+        R[x] = v[q.posR];
+        G[x] = 0.5f * (v[q.posG0] + v[q.posG1]);
+        B[x] = v[q.posB];
+    }
+}
+
+#if defined(__ARM_NEON)
+// 8 output pixels per step: vld2q_u16 de-interleaves even/odd columns of each
+// raw row, so the four quad positions land in four registers without shuffles.
+static inline void ru_quad_row_neon(const RURawMosaic &m, const RUQuad &q, int y, int Wo,
+                                    float *R, float *G, float *B, int &xDone)
+{
+    const uint16_t *r0 = m.row(2 * y), *r1 = m.row(2 * y + 1);
+    const float32x4_t zero = vdupq_n_f32(0.f);
+    float32x4_t blk[4], inv[4];
+    for (int p = 0; p < 4; ++p) { blk[p] = vdupq_n_f32(q.blk[p]); inv[p] = vdupq_n_f32(q.inv[p]); }
+    const float32x4_t half = vdupq_n_f32(0.5f);
+
+    int x = 0;
+    for (; x + 8 <= Wo; x += 8) {
+        const uint16x8x2_t a = vld2q_u16(r0 + 2 * x);
+        const uint16x8x2_t b = vld2q_u16(r1 + 2 * x);
+        const uint16x8_t src[4] = { a.val[0], a.val[1], b.val[0], b.val[1] };
+        float32x4_t lo[4], hi[4];
+        for (int p = 0; p < 4; ++p) {
+            lo[p] = vcvtq_f32_u32(vmovl_u16(vget_low_u16(src[p])));
+            hi[p] = vcvtq_f32_u32(vmovl_u16(vget_high_u16(src[p])));
+            lo[p] = vmaxq_f32(zero, vmulq_f32(vsubq_f32(lo[p], blk[p]), inv[p]));
+            hi[p] = vmaxq_f32(zero, vmulq_f32(vsubq_f32(hi[p], blk[p]), inv[p]));
+        }
+        vst1q_f32(R + x,     lo[q.posR]);
+        vst1q_f32(R + x + 4, hi[q.posR]);
+        vst1q_f32(B + x,     lo[q.posB]);
+        vst1q_f32(B + x + 4, hi[q.posB]);
+        vst1q_f32(G + x,     vmulq_f32(half, vaddq_f32(lo[q.posG0], lo[q.posG1])));
+        vst1q_f32(G + x + 4, vmulq_f32(half, vaddq_f32(hi[q.posG0], hi[q.posG1])));
+    }
+    xDone = x;
+}
+#endif
+
+bool RU_BayerSuperpixel2x2(const RURawMosaic &m, RUPlanarImage &out)
+{
+    if (!m.data || m.width < 2 || m.height < 2 || m.stride < m.left + m.width) return false;
+    RUQuad q;
+    if (!ru_quad_from_mosaic(m, q)) return false;
+
+    const int Wo = m.width / 2, Ho = m.height / 2;
+    if (!out.allocate(Wo, Ho)) return false;
+
+    RU_ParallelFor(0, Ho, 16, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            float *R = out.R.get() + (std::size_t)y * Wo;
+            float *G = out.G.get() + (std::size_t)y * Wo;
+            float *B = out.B.get() + (std::size_t)y * Wo;
+            int x = 0;
+#if defined(__ARM_NEON)
+            ru_quad_row_neon(m, q, y, Wo, R, G, B, x);
+#endif
+            ru_quad_row_scalar(m, q, y, x, Wo, R, G, B);
+        }
+    });
+    return true;
+}
+
+// MARK: - Per-column level LUT
+// black/inv spelled out for every column of each CFA row phase, so row
+// normalization is a straight (vectorizable) loop with no modulo or lookup.
+struct RULevelRows {
+    int P = 0, W = 0;
+    std::vector<float> blk, inv;   // P rows × W
+    explicit RULevelRows(const RURawMosaic &m) : P(m.period), W(m.width),
+        blk((std::size_t)m.period * m.width), inv((std::size_t)m.period * m.width) {
+        for (int cy = 0; cy < P; ++cy)
+            for (int x = 0; x < W; ++x) {
+                const int c = m.cfa[cy][x % P];
+                blk[(std::size_t)cy * W + x] = m.black[c];
+                inv[(std::size_t)cy * W + x] = 1.f / std::max(1.f, m.white - m.black[c]);
+            }
+    }
+    void normalizeRow(const RURawMosaic &m, int y, float *dst) const {
+        const uint16_t *src = m.row(y);
+        const float *b = &blk[(std::size_t)(y % P) * W];
+        const float *k = &inv[(std::size_t)(y % P) * W];
+        for (int x = 0; x < W; ++x) dst[x] = std::max(0.f, ((float)src[x] - b[x]) * k[x]);
+    }
+};
+
+bool RU_NormalizeMosaic(const RURawMosaic &m, float *dst)
+{
+    if (!m.data || !dst || m.width <= 0 || m.height <= 0 || m.stride < m.left + m.width) return false;
+    const RULevelRows lv(m);
+    RU_ParallelFor(0, m.height, 32, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) lv.normalizeRow(m, y, dst + (std::size_t)y * m.width);
+    });
+    return true;
+}
+
+// MARK: - Generic factor×factor binning
+// Block origins modulo the CFA period repeat with period P/gcd(f,P) per axis;
+// one tap list per (phaseY, phaseX) says which sites feed which channel.
+struct RUTap { int dy, dx; };
+struct RUBlockPhase {
+    std::vector<RUTap> taps[3];
+    float w[3] = {0, 0, 0};
+};
+
+static void ru_build_phase(const RURawMosaic &m, int f, int oy, int ox, RUBlockPhase &ph) {
+    auto chan = [&](int y, int x) { const int c = m.cfa[((y % m.period) + m.period) % m.period]
+                                                       [((x % m.period) + m.period) % m.period];
+                                    return c == 3 ? 1 : c; };
+    for (int ch = 0; ch < 3; ++ch) {
+        for (int grow = 0; grow <= 1 && ph.taps[ch].empty(); ++grow)
+            for (int dy = -grow; dy < f + grow; ++dy)
+                for (int dx = -grow; dx < f + grow; ++dx)
+                    if (chan(oy + dy, ox + dx) == ch) ph.taps[ch].push_back({dy, dx});
+        ph.w[ch] = ph.taps[ch].empty() ? 0.f : 1.f / (float)ph.taps[ch].size();
+    }
+}
+
+// Out-of-frame sites are mirrored by one CFA period so they keep their colour.
+static inline int ru_fold(int v, int n, int P) { return v < 0 ? v + P : (v >= n ? v - P : v); }
+
+static bool ru_bin_generic(const RURawMosaic &m, int f, RUPlanarImage &out)
+{
+    const int P = m.period, W = m.width, H = m.height;
+    const int Wo = W / f, Ho = H / f;
+    const int py = P / std::gcd(f, P), px = P / std::gcd(f, P);
+
+    std::vector<RUBlockPhase> phases((std::size_t)py * px);
+    for (int a = 0; a < py; ++a)
+        for (int b = 0; b < px; ++b)
+            ru_build_phase(m, f, a * f, b * f, phases[(std::size_t)a * px + b]);
+    for (const RUBlockPhase &ph : phases)
+        for (int ch = 0; ch < 3; ++ch) if (ph.taps[ch].empty()) return false;
+
+    if (!out.allocate(Wo, Ho)) return false;
+    const RULevelRows lv(m);
+
+    RU_ParallelFor(0, Ho, 8, [&](int oy0, int oy1) {
+        // f+2 normalized raw rows (block plus one halo row above/below)
+        std::vector<float> rows((std::size_t)(f + 2) * W);
+        for (int oy = oy0; oy < oy1; ++oy) {
+            for (int r = 0; r < f + 2; ++r) {
+                const int y = ru_fold(oy * f + r - 1, H, P);
+                lv.normalizeRow(m, y, &rows[(std::size_t)r * W]);
+            }
+            const RUBlockPhase *rowPh = &phases[(std::size_t)(oy % py) * px];
+            float *R = out.R.get() + (std::size_t)oy * Wo;
+            float *G = out.G.get() + (std::size_t)oy * Wo;
+            float *B = out.B.get() + (std::size_t)oy * Wo;
+            for (int ox = 0; ox < Wo; ++ox) {
+                const RUBlockPhase &ph = rowPh[ox % px];
+                const int x0 = ox * f;
+                float acc[3];
+                for (int ch = 0; ch < 3; ++ch) {
+                    float s = 0.f;
+                    for (const RUTap &t : ph.taps[ch])
+                        s += rows[(std::size_t)(t.dy + 1) * W + ru_fold(x0 + t.dx, W, P)];
+                    acc[ch] = s * ph.w[ch];
+                }
+                R[ox] = acc[0]; G[ox] = acc[1]; B[ox] = acc[2];
+            }
+        }
+    });
+    return true;
+}
+
+// Bayer 4×4 = 2×2 average of superpixels (same sites, same weights as the
+// generic path, but both passes vectorize).
+static bool ru_bin_bayer4(const RURawMosaic &m, RUPlanarImage &out)
+{
+    RUPlanarImage sp;
+    if (!RU_BayerSuperpixel2x2(m, sp)) return false;
+    const int Ws = sp.width, Wo = sp.width / 2, Ho = sp.height / 2;
+    if (!out.allocate(Wo, Ho)) return false;
+    float *src[3] = { sp.R.get(), sp.G.get(), sp.B.get() };
+    float *dst[3] = { out.R.get(), out.G.get(), out.B.get() };
+    RU_ParallelFor(0, Ho, 16, [&](int y0, int y1) {
+        for (int ch = 0; ch < 3; ++ch)
+            for (int y = y0; y < y1; ++y) {
+                const float *a = src[ch] + (std::size_t)(2 * y) * Ws;
+                const float *b = a + Ws;
+                float *o = dst[ch] + (std::size_t)y * Wo;
+                for (int x = 0; x < Wo; ++x)
+                    o[x] = 0.25f * (a[2 * x] + a[2 * x + 1] + b[2 * x] + b[2 * x + 1]);
+            }
+    });
+    return true;
+}
+
+bool RU_BinMosaic(const RURawMosaic &m, int factor, RUPlanarImage &out)
+{
+    if (!m.data || factor < 2 || factor > 4) return false;
+    if (m.width < factor || m.height < factor || m.stride < m.left + m.width) return false;
+    if (m.period == 2 && factor == 2 && RU_BayerSuperpixel2x2(m, out)) return true;
+    if (m.period == 2 && factor == 4 && ru_bin_bayer4(m, out)) return true;
+    return ru_bin_generic(m, factor, out);
+}
@@ -0,0 +1,63 @@
+/*
+    RawUnravel - RUBinning.h
+    ------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Reduced-size RGB straight from the sensor mosaic (LibRaw rawdata.raw_image),
+// without going through dcraw_process / make_mem_image.
+//
+// Output is *camera* RGB in 0..1 (black subtracted, divided by white-black,
+// floored at 0, not clipped); white balance and cam→sRGB are the caller's
+// next stage.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "RUPlanarImage.h"
+
+struct RURawMosaic {
+    const uint16_t *data = nullptr;  // full raw buffer (raw_image)
+    int stride = 0;                  // row pitch in uint16_t elements
+    int left = 0, top = 0;           // visible-area origin inside `data`
+    int width = 0, height = 0;       // visible area
+    int period = 2;                  // CFA repeat: 2 = Bayer, 6 = X-Trans
+    unsigned char cfa[6][6] = {};    // LibRaw colour at (row%period, col%period): 0=R 1=G 2=B 3=G2
+    float black[4] = {0, 0, 0, 0};   // per LibRaw colour
+    float white = 65535.f;
+
+    const uint16_t *row(int y) const { return data + (std::size_t)(y + top) * stride + left; }
+    int colorAt(int y, int x) const { return cfa[y % period][x % period]; }
+};
+
+/// 2×2 Bayer superpixel: one RGB pixel per CFA quad, G = mean of both greens,
+/// black/white normalization fused into the gather (NEON when available).
+/// Output is (width/2)×(height/2). Returns false if the CFA is not a plain
+/// 2×2 Bayer quad (one R, one B, two G); the caller should fall back.
+bool RU_BayerSuperpixel2x2(const RURawMosaic &m, RUPlanarImage &out);
+
+/// factor×factor binning (factor ∈ {2, 3, 4}) for Bayer and X-Trans.
+/// Each output pixel averages every same-colour site in its block; a colour
+/// missing from a block (X-Trans 2×2/4×4) is taken from the block grown by one
+/// site on each side. Output is (width/factor)×(height/factor), multithreaded.
+bool RU_BinMosaic(const RURawMosaic &m, int factor, RUPlanarImage &out);
+
+/// Black/white-normalized visible mosaic (0..1, floored at 0), width×height
+/// floats into `dst`: the single-plane input the full-res demosaicers expect.
+/// Uses the same per-colour levels as the binning paths.
+bool RU_NormalizeMosaic(const RURawMosaic &m, float *dst);
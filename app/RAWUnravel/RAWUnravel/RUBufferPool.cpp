@@ -0,0 +1,129 @@
+/*
+    RawUnravel - RUBufferPool.cpp
+    -----------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RUBufferPool.h"
+#include "aligned_allocator.h"
+#include <algorithm>
+#include <unistd.h>
+
+// 1/16 of physical memory, 64 MB…1 GB.
+static std::size_t ru_default_max_cached() {
+    const long pages = sysconf(_SC_PHYS_PAGES), page = sysconf(_SC_PAGESIZE);
+    const std::size_t phys = (pages > 0 && page > 0) ? (std::size_t)pages * (std::size_t)page : 0;
+    return std::clamp<std::size_t>(phys / 16, 64u << 20, 1024u << 20);
+}
+
+RUBufferPool::RUBufferPool() : maxCached_(ru_default_max_cached()) {}
+
+RUBufferPool &RUBufferPool::shared() {
+    // Intentionally leaked: CGDataProvider release callbacks may fire during
+    // process teardown, after static destructors would have run.
+    static RUBufferPool *pool = new RUBufferPool();
+    return *pool;
+}
+
+void *RUBufferPool::acquire(std::size_t bytes) {
+    if (bytes == 0) return nullptr;
+    const std::size_t want = roundUp(bytes);
+    acquires_.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        // best fit within the slack; exact sizes win
+        std::size_t best = idle_.size();
+        for (std::size_t i = 0; i < idle_.size(); ++i) {
+            const std::size_t b = idle_[i].bytes;
+            if (b < want || b - want > want / kRUPoolSlack) continue;
+            if (best == idle_.size() || b < idle_[best].bytes) best = i;
+            if (b == want) break;
+        }
+        if (best != idle_.size()) {
+            const Entry e = idle_[best];
+            idle_.erase(idle_.begin() + (std::ptrdiff_t)best);
+            cached_ -= e.bytes;
+            if (e.bytes != want) larger_[e.p] = e.bytes;
+            return e.p;
+        }
+    }
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes_.fetch_add(want, std::memory_order_relaxed);
+    return rt_aligned_malloc(want, kRUPoolAlign);
+}
+
+void RUBufferPool::release(void *p, std::size_t bytes) {
+    if (!p) return;
+    std::size_t have = roundUp(bytes);
+    std::vector<Entry> drop;
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        if (!larger_.empty()) {
+            const auto it = larger_.find(p);
+            if (it != larger_.end()) { have = it->second; larger_.erase(it); }
+        }
+        if (have <= maxCached_) {
+            // oldest out until the newcomer fits
+            std::size_t n = 0;
+            while (cached_ + have > maxCached_) cached_ -= idle_[n++].bytes;
+            drop.assign(idle_.begin(), idle_.begin() + (std::ptrdiff_t)n);
+            idle_.erase(idle_.begin(), idle_.begin() + (std::ptrdiff_t)n);
+            idle_.push_back({p, have});
+            cached_ += have;
+            p = nullptr;
+        }
+    }
+    for (const Entry &e : drop) rt_aligned_free(e.p);
+    if (p) rt_aligned_free(p);
+}
+
+void RUBufferPool::trim() {
+    std::vector<Entry> drop;
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        drop.swap(idle_);
+        cached_ = 0;
+    }
+    for (const Entry &e : drop) rt_aligned_free(e.p);
+}
+
+void RUBufferPool::setMaxCachedBytes(std::size_t bytes) {
+    std::vector<Entry> drop;
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        maxCached_ = bytes;
+        std::size_t n = 0;
+        while (cached_ > maxCached_) cached_ -= idle_[n++].bytes;   // oldest first
+        drop.assign(idle_.begin(), idle_.begin() + (std::ptrdiff_t)n);
+        idle_.erase(idle_.begin(), idle_.begin() + (std::ptrdiff_t)n);
+    }
+    for (const Entry &e : drop) rt_aligned_free(e.p);
+}
+
+RUBufferPool::Stats RUBufferPool::stats() const {
+    Stats s;
+    s.acquires       = acquires_.load(std::memory_order_relaxed);
+    s.allocations    = allocations_.load(std::memory_order_relaxed);
+    s.allocatedBytes = allocatedBytes_.load(std::memory_order_relaxed);
+    return s;
+}
+
+std::size_t RUBufferPool::cachedBytes() {
+    std::lock_guard<std::mutex> lk(m_);
+    return cached_;
+}
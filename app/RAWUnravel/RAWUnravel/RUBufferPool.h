@@ -0,0 +1,123 @@
+/*
+    RawUnravel - RUBufferPool.h
+    ---------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Process-wide recycler for large pixel buffers (BGRA packs, float planes).
+//
+// Conventions:
+// - Sizes are rounded up to kRUPoolGranule so repeated renders of the same
+//   frame hit the same bucket.
+// - release() must be given the same byte count that was passed to acquire();
+//   this is what lets a CGDataProvider release callback hand a buffer back
+//   with only (data, size) in hand.
+// - Buffers are 64-byte aligned (NEON / cache line friendly).
+// - acquire() reuses the smallest idle buffer no more than 1/kRUPoolSlack
+//   larger than the request, so bands and crops of nearby sizes share buffers.
+// - Idle buffers are capped (default 1/16 of physical memory, 64 MB…1 GB); a
+//   release that does not fit evicts the oldest idle buffers first.
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class RUBufferPool {
+public:
+    static constexpr std::size_t kRUPoolGranule = 64 * 1024;
+    static constexpr std::size_t kRUPoolAlign   = 64;
+    static constexpr std::size_t kRUPoolSlack   = 8;
+
+    static RUBufferPool &shared();
+
+    /// Returns an uninitialized buffer of at least `bytes` bytes, or nullptr.
+    void *acquire(std::size_t bytes);
+    /// Returns a buffer obtained from acquire(bytes) to the pool.
+    void  release(void *p, std::size_t bytes);
+    /// Frees every cached (idle) buffer.
+    void  trim();
+
+    void        setMaxCachedBytes(std::size_t bytes);
+    std::size_t cachedBytes();
+
+    /// Running totals since launch: every acquire(), and the ones the cache
+    /// could not serve (fresh allocations). Diff two snapshots for a stage.
+    struct Stats { uint64_t acquires = 0, allocations = 0, allocatedBytes = 0; };
+    Stats stats() const;
+
+private:
+    RUBufferPool();
+    RUBufferPool(const RUBufferPool &) = delete;
+    RUBufferPool &operator=(const RUBufferPool &) = delete;
+
+    struct Entry { void *p; std::size_t bytes; };
+
+    static std::size_t roundUp(std::size_t bytes) {
+        return (bytes + kRUPoolGranule - 1) / kRUPoolGranule * kRUPoolGranule;
+    }
+
+    std::mutex         m_;
+    std::vector<Entry> idle_;                           // oldest first
+    std::unordered_map<void *, std::size_t> larger_;    // lent out bigger than asked: real size
+    std::size_t        cached_    = 0;
+    std::size_t        maxCached_ = 0;
+    std::atomic<uint64_t> acquires_{0}, allocations_{0}, allocatedBytes_{0};
+};
+
+// MARK: - RUPooled<T>
+// Move-only owner of `count` elements borrowed from RUBufferPool::shared().
+// The destructor returns the storage; detach() gives up ownership (e.g. when
+// the buffer is handed to a CGDataProvider whose release callback returns it).
+template <class T>
+class RUPooled {
+public:
+    RUPooled() = default;
+    explicit RUPooled(std::size_t count)
+        : p_(static_cast<T *>(RUBufferPool::shared().acquire(count * sizeof(T)))),
+          n_(p_ ? count : 0) {}
+    ~RUPooled() { reset(); }
+
+    RUPooled(RUPooled &&o) noexcept : p_(std::exchange(o.p_, nullptr)), n_(std::exchange(o.n_, 0)) {}
+    RUPooled &operator=(RUPooled &&o) noexcept {
+        if (this != &o) { reset(); p_ = std::exchange(o.p_, nullptr); n_ = std::exchange(o.n_, 0); }
+        return *this;
+    }
+    RUPooled(const RUPooled &) = delete;
+    RUPooled &operator=(const RUPooled &) = delete;
+
+    T          *get() const { return p_; }
+    std::size_t size() const { return n_; }
+    std::size_t bytes() const { return n_ * sizeof(T); }
+    explicit operator bool() const { return p_ != nullptr; }
+    T &operator[](std::size_t i) const { return p_[i]; }
+
+    T *detach() { n_ = 0; return std::exchange(p_, nullptr); }
+    void reset() {
+        if (p_) RUBufferPool::shared().release(p_, n_ * sizeof(T));
+        p_ = nullptr; n_ = 0;
+    }
+
+private:
+    T          *p_ = nullptr;
+    std::size_t n_ = 0;
+};
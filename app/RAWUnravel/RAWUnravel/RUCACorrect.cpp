@@ -0,0 +1,97 @@
+/*
+    RawUnravel - RUCACorrect.cpp
+    ----------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RUCACorrect.h"
+#include "RUBufferPool.h"
+#include "librtprocess.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// MARK: - Fit cache
+
+bool RUCAFitCache::find(uint64_t key, RUCAFit &fit) const {
+    std::lock_guard<std::mutex> lk(m_);
+    const auto it = fits_.find(key);
+    if (it == fits_.end()) return false;
+    fit = it->second;
+    return true;
+}
+
+void RUCAFitCache::store(uint64_t key, const RUCAFit &fit) {
+    std::lock_guard<std::mutex> lk(m_);
+    if (fits_.size() >= kMaxFits) fits_.clear();
+    fits_[key] = fit;
+}
+
+void RUCAFitCache::clear() {
+    std::lock_guard<std::mutex> lk(m_);
+    fits_.clear();
+}
+
+// MARK: - Correction
+
+namespace {
+
+// CA_correct's tiles per scheduling chunk. Tiles cost about the same, so
+// small chunks only balance the last few.
+constexpr std::size_t kRU_CAChunkTiles = 2;
+
+// Frame size + fit settings → cache key.
+uint64_t ru_fit_key(int w, int h, const RUCASettings &s) {
+    uint64_t k = 1469598103934665603ull;
+    const int v[] = { w, h, s.iterations, s.avoidColourshift ? 1 : 0 };
+    for (int i : v) { k ^= (uint32_t)i; k *= 1099511628211ull; }
+    return k;
+}
+
+} // namespace
+
+bool RU_CACorrectMosaic(float *mono, int W, int H, const unsigned cfa[2][2],
+                        const RUCASettings &s, RUCAFitCache *cache)
+{
+    if (!mono || W < 32 || H < 32 || !s.active()) return false;
+
+    // CA_correct leaves a border untouched, so it writes a copy rather than
+    // the input it is still reading tiles from.
+    const size_t n = (size_t)W * H;
+    RUPooled<float> out(n);
+    if (!out) return false;
+    memcpy(out.get(), mono, n * sizeof(float));
+    std::vector<float *> in((size_t)H), to((size_t)H);
+    for (int y = 0; y < H; ++y) {
+        in[(size_t)y] = mono + (size_t)y * W;
+        to[(size_t)y] = out.get() + (size_t)y * W;
+    }
+
+    const uint64_t key = ru_fit_key(W, H, s);
+    RUCAFit fit {};
+    const bool cached = s.autoCA && cache && cache->find(key, fit);
+    // cached: CA_correct skips the fit and only applies `fit`
+    const rpError e = CA_correct(0, 0, W, H, s.autoCA, (size_t)std::clamp(s.iterations, 1, 5),
+                                 s.red, s.blue, s.avoidColourshift,
+                                 in.data(), to.data(), cfa, [](double) { return false; },
+                                 fit.p, cached, 1.f, 1.f, kRU_CAChunkTiles);
+    if (e != RP_NO_ERROR) return false;
+    if (s.autoCA && cache && !cached) cache->store(key, fit);
+    memcpy(mono, out.get(), n * sizeof(float));
+    return true;
+}
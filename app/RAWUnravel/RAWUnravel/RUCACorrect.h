@@ -0,0 +1,69 @@
+/*
+    RawUnravel - RUCACorrect.h
+    --------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Lateral chromatic aberration correction (librtprocess CA_correct) on a
+// normalized Bayer mosaic, ahead of demosaic.
+//
+// One CA_correct pass covers the whole frame: librtprocess spreads its tiles
+// over OpenMP threads in chunks of `chunkSize` tiles, and auto-CA fits one polynomial
+// (CA_correct's fitParams) for the frame. The fit is in CA_correct's tile
+// coordinates of that window, so it only applies to the same window; the
+// full-res path therefore corrects the frame mosaic once and its bands read
+// from the result. The fit is most of the cost and is kept in an
+// RUCAFitCache (one per session), so re-rendering the same file only
+// applies it.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+struct RUCASettings {
+    bool  autoCA = false;
+    int   iterations = 2;           // auto-CA passes, 1...5
+    float red = 0.f, blue = 0.f;    // manual shifts (autoCA off)
+    bool  avoidColourshift = true;
+
+    bool active() const { return autoCA || red != 0.f || blue != 0.f; }
+};
+
+/// CA_correct's fitParams for one frame.
+struct RUCAFit { double p[2][2][16]; };
+
+class RUCAFitCache {
+public:
+    bool find(uint64_t key, RUCAFit &fit) const;
+    void store(uint64_t key, const RUCAFit &fit);
+    void clear();
+
+private:
+    static constexpr size_t kMaxFits = 16;   // one per frame size + settings; cleared when full
+    mutable std::mutex m_;
+    std::unordered_map<uint64_t, RUCAFit> fits_;
+};
+
+/// Corrects the W×H frame mosaic (0...1, `cfa` as LibRaw colours 0=R 1=G
+/// 2=B) in place. Auto-CA fits are cached in `cache` (may be null) by frame
+/// size and settings. false if nothing ran (inactive settings, no memory or
+/// a CA_correct error); the mosaic is then unchanged.
+bool RU_CACorrectMosaic(float *mono, int W, int H, const unsigned cfa[2][2],
+                        const RUCASettings &s, RUCAFitCache *cache);
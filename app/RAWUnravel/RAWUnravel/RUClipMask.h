@@ -0,0 +1,84 @@
+/*
+    RawUnravel - RUClipMask.h
+    -------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// Clipping / gamut-warning mask written by the pack stage. Flags:
+//  - RUClipRaw:   a camera channel at the white level (color.maximum) before
+//                 white balance, i.e. no data left to recover;
+//  - RUClipTone:  a channel at or above 1.0 after tone ops (shows as 255);
+//  - RUClipGamut: a channel negative after the camera → sRGB matrix.
+// 8 bits per pixel keeps the flags; 1 bit per pixel only says "any flag".
+// Rows are padded to whole bytes, so pack threads never share a byte.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "RUBufferPool.h"
+
+enum RUClipFlag : uint8_t {
+    RUClipRaw   = 1u << 0,
+    RUClipTone  = 1u << 1,
+    RUClipGamut = 1u << 2,
+};
+
+struct RUClipMask {
+    int    width = 0, height = 0;
+    int    bits = 8;                 // 1 or 8
+    size_t rowBytes = 0;
+    RUPooled<uint8_t> data;
+
+    bool allocate(int W, int H, int bitsPerPixel) {
+        width = W; height = H;
+        bits = (bitsPerPixel == 1) ? 1 : 8;
+        rowBytes = (bits == 1) ? ((size_t)W + 7) / 8 : (size_t)W;
+        data = RUPooled<uint8_t>(rowBytes * (size_t)H);
+        return bool(data);
+    }
+
+    uint8_t *row(int y) { return data.get() + (size_t)y * rowBytes; }
+    const uint8_t *row(int y) const { return data.get() + (size_t)y * rowBytes; }
+
+    /// Flags at (x, y); a 1-bit mask reports any set bit as RUClipTone.
+    uint8_t at(int x, int y) const {
+        const uint8_t *r = row(y);
+        if (bits == 8) return r[x];
+        return ((r[x >> 3] >> (x & 7)) & 1) ? RUClipTone : 0;
+    }
+};
+
+/// Writes one mask row left to right (used inside the pack loop).
+struct RUClipRowWriter {
+    uint8_t *dst;
+    int      bits;
+    uint8_t  acc = 0;
+
+    RUClipRowWriter(uint8_t *row, int bitsPerPixel) : dst(row), bits(bitsPerPixel) {}
+
+    inline void put(int x, uint8_t flags) {
+        if (bits == 8) { dst[x] = flags; return; }
+        acc |= (uint8_t)((flags != 0) << (x & 7));
+        if ((x & 7) == 7) { dst[x >> 3] = acc; acc = 0; }
+    }
+    /// Flushes a partial last byte; `width` is the row length.
+    inline void finish(int width) {
+        if (bits == 1 && (width & 7)) dst[width >> 3] = acc;
+    }
+};
@@ -0,0 +1,142 @@
+/*
+    RawUnravel - RUDemosaic.cpp
+    ---------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RUDemosaic.h"
+#include <cstddef>
+#include <dlfcn.h>
+#if defined(RU_RTPROCESS_UPSTREAM)
+#include "librtprocess.h"
+#include "RUBufferPool.h"
+#include <vector>
+
+// Upstream names AMaZE amaze_demosaic (the app's build renames it).
+rpError amaze_demosaic(int raw_width, int raw_height, int winx, int winy, int winw, int winh,
+                       const float * const *rawData, float **red, float **green, float **blue,
+                       const unsigned cfarray[2][2], const std::function<bool(double)> &setProgCancel,
+                       double initGain, int border, float inputScale, float outputScale,
+                       std::size_t chunkSize, bool measure);
+#endif
+
+// MARK: - dlsym helpers (AMAZE / X-Trans)
+//
+// These dynamically resolve libRTProcess entry points for AMAZE and X-Trans
+// demosaicers. We use dlsym() to avoid hard-linking against specific symbols
+// (helps with iOS simulator/device mismatches).
+
+using AmazeFn = int (*)(const float*, int, int, const unsigned[4], float*, float*, float*);
+static AmazeFn loadAmaze() {
+    static AmazeFn fn = nullptr;
+    static bool tried = false;
+    if (tried) return fn;
+    tried = true;
+
+    const char *cands[] = { "amaze_demosaic", "rp_demosaic_amaze" };
+    for (const char *nm : cands) {
+        if (void *p = dlsym(RTLD_DEFAULT, nm)) {
+            fn = (AmazeFn)p;
+            break;
+        }
+    }
+    return fn;
+}
+
+using XTransFn = int (*)(const float*, const float*, const float*, int, int, const unsigned[6][6],
+                         float*, float*, float*);
+static XTransFn loadXTrans() {
+    static XTransFn fn = nullptr;
+    static bool tried = false;
+    if (tried) return fn;
+    tried = true;
+
+    const char *cands[] = { "xtrans_demosaic", "rp_demosaic_xtrans" };
+    for (const char *nm : cands) {
+        if (void *p = dlsym(RTLD_DEFAULT, nm)) {
+            fn = (XTransFn)p;
+            break;
+        }
+    }
+    return fn;
+}
+
+#if defined(RU_RTPROCESS_UPSTREAM)
+// MARK: - Upstream librtprocess (row pointers)
+
+// Row pointers into a tightly packed W×H plane.
+static std::vector<float *> ru_rows(float *plane, int W, int H) {
+    std::vector<float *> rows((size_t)H);
+    for (int y = 0; y < H; ++y) rows[(size_t)y] = plane + (size_t)y * W;
+    return rows;
+}
+
+static int ru_upstream_amaze(const float *mono, int W, int H, const unsigned cf4[4],
+                             float *R, float *G, float *B) {
+    const unsigned cfa[2][2] = { { cf4[0], cf4[1] }, { cf4[2], cf4[3] } };
+    std::vector<float *> in = ru_rows(const_cast<float *>(mono), W, H);
+    std::vector<float *> r = ru_rows(R, W, H), g = ru_rows(G, W, H), b = ru_rows(B, W, H);
+    const auto keepGoing = [](double) { return false; };
+    // planes are 0..1: no scaling in or out; AMaZE leaves a 4 px border to bayerborder
+    if (amaze_demosaic(W, H, 0, 0, W, H, in.data(), r.data(), g.data(), b.data(),
+                       cfa, keepGoing, 1.0, 4, 1.f, 1.f, 2, false) != RP_NO_ERROR) return -1;
+    return bayerborder_demosaic(W, H, 4, in.data(), r.data(), g.data(), b.data(), cfa) == RP_NO_ERROR ? 0 : -1;
+}
+
+static int ru_upstream_xtrans(const float *P0, const float *P1, const float *P2, int W, int H,
+                              const unsigned xtrans[6][6], float *R, float *G, float *B) {
+    // Markesteijn reads one mosaic; pick each photosite from its colour plane
+    RUPooled<float> mono((size_t)W * H);
+    if (!mono) return -1;
+    const float *planes[3] = { P0, P1, P2 };
+    for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x) {
+            const size_t i = (size_t)y * W + x;
+            mono[i] = planes[xtrans[y % 6][x % 6] % 3][i];
+        }
+    std::vector<float *> in = ru_rows(mono.get(), W, H);
+    std::vector<float *> r = ru_rows(R, W, H), g = ru_rows(G, W, H), b = ru_rows(B, W, H);
+    const float identity[3][4] = { { 1.f, 0.f, 0.f, 0.f }, { 0.f, 1.f, 0.f, 0.f }, { 0.f, 0.f, 1.f, 0.f } };
+    const auto keepGoing = [](double) { return false; };
+    return markesteijn_demosaic(W, H, in.data(), r.data(), g.data(), b.data(), xtrans, identity,
+                                keepGoing, 1, false) == RP_NO_ERROR ? 0 : -1;
+}
+#endif
+
+// MARK: - Entry points
+
+extern "C" int bridge_amaze_demosaic(const float *mono, int W, int H, const unsigned cf4[4],
+                                     float *R, float *G, float *B) {
+    if (AmazeFn fn = loadAmaze()) return fn(mono, W, H, cf4, R, G, B);
+#if defined(RU_RTPROCESS_UPSTREAM)
+    return ru_upstream_amaze(mono, W, H, cf4, R, G, B);
+#else
+    return -1;
+#endif
+}
+
+extern "C" int bridge_xtrans_demosaic(const float *P0, const float *P1, const float *P2,
+                                      int W, int H, const unsigned xtrans[6][6],
+                                      float *R, float *G, float *B) {
+    if (XTransFn fn = loadXTrans()) return fn(P0, P1, P2, W, H, xtrans, R, G, B);
+#if defined(RU_RTPROCESS_UPSTREAM)
+    return ru_upstream_xtrans(P0, P1, P2, W, H, xtrans, R, G, B);
+#else
+    return -1;
+#endif
+}
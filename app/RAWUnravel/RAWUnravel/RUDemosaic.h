@@ -0,0 +1,47 @@
+/*
+    RawUnravel - RUDemosaic.h
+    -------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Demosaic entry points the develop pipeline calls: AMaZE for Bayer,
+// Markesteijn for X-Trans, on normalized (0..1) float planes. The app's
+// librtprocess build exports flat C entry points, resolved at run time;
+// builds against upstream librtprocess (RU_RTPROCESS_UPSTREAM) call its
+// row-pointer API instead.
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Bayer: `mono` is the W×H mosaic, cf4 the 2×2 CFA (0=R, 1=G, 2=B).
+/// R/G/B receive W×H planes. 0 on success.
+int bridge_amaze_demosaic(const float *mono, int W, int H, const unsigned cf4[4],
+                          float *R, float *G, float *B);
+
+/// X-Trans: P0/P1/P2 hold each photosite's value in its own colour plane.
+/// 0 on success.
+int bridge_xtrans_demosaic(const float *P0, const float *P1, const float *P2,
+                           int W, int H, const unsigned xtrans[6][6],
+                           float *R, float *G, float *B);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,834 @@
+/*
+    RawUnravel - RUDevelop.cpp
+    --------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RUDevelop.h"
+#include "RUBinning.h"
+#include "RUBufferPool.h"
+#include "RUCACorrect.h"
+#include "RUDemosaic.h"
+#include "RUHighlights.h"
+#include "RUHistogram.h"
+#include "RULibRawStream.h"
+#include "RUParallel.h"
+#include "RUPlanarImage.h"
+#include "RUResample.h"
+#include "RURLD.h"
+#include "RUSession.h"
+#include "RUToneOps.h"
+#include "RUTrace.h"
+#include <libraw/libraw.h>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sys/stat.h>
+#include <unordered_map>
+#include <vector>
+
+// LibRaw sizes.flip → EXIF orientation (same table as RUMapLibRawFlipToEXIF).
+static int ru_exif_from_flip(int flip) {
+    static const int kExif[8] = { 1, 2, 4, 3, 5, 6, 8, 7 };
+    return (flip >= 0 && flip < 8) ? kExif[flip] : 1;
+}
+
+// MARK: - LibRaw handle reuse
+// libraw_init allocates a multi-megabyte LibRaw object. Renders borrow a
+// recycled handle instead (batch export runs several back to back); release
+// recycles the image data and restores the default output params, since the
+// dcraw fallback paths tweak them.
+static constexpr size_t kRU_LibRawIdleMax = 4;
+static std::mutex                   gRU_LibRawMutex;
+static std::vector<libraw_data_t *> gRU_LibRawIdle;
+static libraw_output_params_t       gRU_LibRawDefaults;
+static bool                         gRU_LibRawHaveDefaults = false;
+// Datastreams of handles opened through RU_LibRawOpen; freed on release.
+static std::unordered_map<libraw_data_t *, std::unique_ptr<RUMappedDatastream>> gRU_LibRawStreams;
+
+static libraw_data_t *RU_LibRawAcquire() {
+    {
+        std::lock_guard<std::mutex> lk(gRU_LibRawMutex);
+        if (!gRU_LibRawIdle.empty()) {
+            libraw_data_t *raw = gRU_LibRawIdle.back();
+            gRU_LibRawIdle.pop_back();
+            return raw;
+        }
+    }
+    libraw_data_t *raw = libraw_init(0);
+    if (raw) {
+        std::lock_guard<std::mutex> lk(gRU_LibRawMutex);
+        if (!gRU_LibRawHaveDefaults) { gRU_LibRawDefaults = raw->params; gRU_LibRawHaveDefaults = true; }
+    }
+    return raw;
+}
+
+static void RU_LibRawRelease(libraw_data_t *raw) {
+    if (!raw) return;
+    libraw_recycle(raw);
+    std::lock_guard<std::mutex> lk(gRU_LibRawMutex);
+    gRU_LibRawStreams.erase(raw);
+    if (gRU_LibRawHaveDefaults && gRU_LibRawIdle.size() < kRU_LibRawIdleMax) {
+        raw->params = gRU_LibRawDefaults;
+        gRU_LibRawIdle.push_back(raw);
+        return;
+    }
+    libraw_close(raw);
+}
+
+// Opens `bytes` on `raw` through a buffer datastream over the mapping; the
+// stream lives until RU_LibRawRelease.
+static int RU_LibRawOpenBytes(libraw_data_t *raw, std::shared_ptr<const RUMappedBytes> bytes) {
+    if (!raw || !bytes) return LIBRAW_IO_ERROR;
+    auto stream = std::make_unique<RUMappedDatastream>(std::move(bytes));
+    const int rc = static_cast<LibRaw *>(raw->parent_class)->open_datastream(stream.get());
+    std::lock_guard<std::mutex> lk(gRU_LibRawMutex);
+    gRU_LibRawStreams[raw] = std::move(stream);
+    return rc;
+}
+
+// Opens `path` on `raw`, reading from the session's shared mapping of the
+// file (every render of a file shares its pages, and LibRaw's reads become
+// memcpys); LibRaw's own file stream if the file cannot be mapped.
+static int RU_LibRawOpen(libraw_data_t *raw, const char *path) {
+    const std::shared_ptr<RUSession> session = RU_SessionForPath(path);
+    if (std::shared_ptr<const RUMappedBytes> bytes = session ? session->mapping() : nullptr)
+        return RU_LibRawOpenBytes(raw, std::move(bytes));
+    return libraw_open_file(raw, path);
+}
+
+// MARK: - Files
+
+bool RU_RawAvailable(const char *path) {
+    if (!path || !*path) return false;
+    struct stat st {};
+    if (stat(path, &st) == 0) return true;
+    const std::shared_ptr<RUSession> s = RU_SessionForPath(path);
+    return s && s->attached();
+}
+
+bool RU_RawActiveSize(const char *path, int &w, int &h) {
+    if (!path) return false;
+    const std::shared_ptr<RUSession> session = RU_SessionForPath(path);
+    if (session && session->rawSize(w, h)) return true;
+
+    // Sizes are known once the file is identified; no need to unpack.
+    std::shared_ptr<const RUMappedBytes> bytes = session ? session->mapping() : nullptr;
+    std::unique_ptr<RUMappedDatastream> stream = bytes ? std::make_unique<RUMappedDatastream>(bytes) : nullptr;
+    LibRaw raw;   // after the stream: destroyed first
+    if ((stream ? raw.open_datastream(stream.get()) : raw.open_file(path)) != LIBRAW_SUCCESS) return false;
+
+    // Active area from LibRaw
+    w = raw.imgdata.sizes.raw_width;
+    h = raw.imgdata.sizes.raw_height;
+    raw.recycle();
+
+    if (session) session->setRawSize(w, h);
+    return true;
+}
+// MARK: - Mosaic, white balance, highlights
+
+// Describe LibRaw's unpacked mosaic for RUBinning. The CFA table is sampled
+// with libraw_COLOR (visible-area coordinates), so Bayer and X-Trans share it;
+// patterns that do not repeat every 2 or 6 pixels are rejected.
+static bool RU_MosaicFromLibRaw(libraw_data_t *raw, RURawMosaic &m) {
+    if (!raw || !raw->rawdata.raw_image || raw->idata.filters == 0) return false;
+    const libraw_image_sizes_t &S = raw->sizes;
+    m.data   = raw->rawdata.raw_image;
+    m.stride = S.raw_pitch ? (int)(S.raw_pitch / 2) : (int)S.raw_width;
+    m.left   = S.left_margin;  m.top    = S.top_margin;
+    m.width  = S.width;        m.height = S.height;
+    if (m.left + m.width > m.stride || m.top + m.height > (int)S.raw_height) return false;
+
+    m.period = (raw->idata.filters == 9) ? 6 : 2;
+    for (int r = 0; r < 6; ++r)
+        for (int c = 0; c < 6; ++c)
+            m.cfa[r][c] = (unsigned char)libraw_COLOR(raw, r, c);
+    for (int r = 0; r < 12; ++r)
+        for (int c = 0; c < 12; ++c)
+            if (libraw_COLOR(raw, r, c) != m.cfa[r % m.period][c % m.period]) return false;
+
+    for (int c = 0; c < 4; ++c) m.black[c] = (float)(raw->color.black + raw->color.cblack[c]);
+    m.white = (float)raw->color.maximum;
+    return m.white > m.black[0];
+}
+
+// Camera RGB (0..1, black-subtracted) → linear sRGB, the way dcraw_process
+// does it with use_camera_wb: multipliers normalized so the smallest is 1,
+// clip to 1 after WB, then LibRaw's rgb_cam (camera → sRGB) and clamp.
+// As-shot multipliers (pre_mul when the camera gave none), smallest = 1.
+static void RU_CameraWBMultipliers(const libraw_colordata_t &C, float wb[3]) {
+    const float *src = (C.cam_mul[0] > 0.f && C.cam_mul[1] > 0.f && C.cam_mul[2] > 0.f)
+                     ? C.cam_mul : C.pre_mul;
+    for (int c = 0; c < 3; ++c) wb[c] = src[c] > 0.f ? src[c] : 1.f;
+    const float wmin = std::min({ wb[0], wb[1], wb[2] });
+    for (int c = 0; c < 3; ++c) wb[c] /= wmin;
+}
+
+// LibRaw's as-shot WB and rgb_cam through RU_ApplyWBMatrix. `keepOver`:
+// highlights were reconstructed, so values above 1.0 are image data and pass
+// through (tone ops and pack bring them into range).
+static void RU_ApplyCameraWBToSRGB(const libraw_colordata_t &C,
+                                   float *R, float *G, float *B, size_t N,
+                                   uint8_t *flags = nullptr, bool keepOver = false) {
+    float wb[3];
+    RU_CameraWBMultipliers(C, wb);
+
+    float M[9];
+    for (int r = 0; r < 3; ++r) for (int c = 0; c < 3; ++c) M[3*r+c] = C.rgb_cam[r][c];
+    RU_ApplyWBMatrix(R, G, B, N, wb, M, flags, keepOver);
+}
+
+// Highlight reconstruction stage (PP3 hlRecovery): demosaiced camera RGB,
+// before WB. true if any region was rebuilt (WB then keeps values over 1).
+static bool RU_ReconstructHighlights(const libraw_colordata_t &C, const RU_PP3 &P,
+                                     float *R, float *G, float *B, int W, int H)
+{
+    if (!P.hlRecovery) return false;
+    float wb[3];
+    RU_CameraWBMultipliers(C, wb);
+    return RU_RecoverHighlights(R, G, B, W, H, wb) > 0;
+}
+// MARK: - Banded full-res execution
+// Full-res renders stream over horizontal bands so the float working set is
+// one band plus halos instead of the whole frame. Only raw_image (LibRaw) and
+// the output are frame-sized.
+std::atomic<int>  gRU_FullResBandRows{512};
+
+// Precision policy for interactive (binned) previews: FP16 working planes for
+// the bandwidth-bound stages, on by default only where half conversions are
+// native. Full-res/export renders always stay FP32.
+std::atomic<bool> gRU_PreviewHalfFloat{RU_NATIVE_HALF != 0};
+
+std::atomic<int>  gRU_ClipMaskBits{0};
+
+// AMaZE looks at most 16 rows past a tile edge; rows nearer than that to a
+// band cut would see a clamped border instead of real data. Same for columns
+// when only a crop window is developed.
+static constexpr int kRU_DemosaicHaloRows = 16;
+
+// Fills camera-RGB (0..1) of the frame window [x0, x1) × [y0, y1) into R/G/B
+// (stride = x1 - x0, first pixel = (x0, y0)). x0 and y0 are always multiples
+// of 6, so the CFA phase (Bayer or X-Trans) of the window matches the frame.
+using RUBandDemosaic = std::function<bool(int x0, int y0, int x1, int y1, float *R, float *G, float *B)>;
+
+// demosaic → WB/cam→sRGB → RLD → tone → Lab → pack, one band at a time.
+// Develops `region` of the W×H frame (plus demosaic/RLD halos, clamped to the
+// frame) into `out`, already allocated for the region; false if a band fails
+// to demosaic.
+static bool RU_RenderFullResBands(int W, int H, const RURegion &region,
+                                  const libraw_colordata_t &color,
+                                  const RU_PP3 &P, const RUJobHooks &job, RUPackTarget &out,
+                                  const RUBandDemosaic &demosaic)
+{
+    const int   iters = P.deconvIter;
+    const float amt   = P.deconvAmount;
+    const float rad   = fmaxf(0.05f, P.deconvRadius);
+    const bool  rld   = iters > 0 && amt > 0.f && rad > 0.05f;
+    const int   rldHalo = rld ? RU_RLDHaloRows(iters, rad) : 0;
+
+    // Each band re-runs RLD over its halo rows; at 4× the halo or more, that
+    // adds at most half of the frame's RLD work (30 iterations at r=2 has a
+    // 360-row halo, which would otherwise dwarf a 512-row band).
+    const int RH       = region.height();
+    const int req      = gRU_FullResBandRows.load(std::memory_order_relaxed);
+    const int minRows  = std::max(64, 4 * rldHalo);
+    const int bandRows = (req > 0) ? std::min(RH, std::max(req, minRows)) : RH;
+    const int bands    = (RH + bandRows - 1) / bandRows;
+
+    // Columns: the region plus both halos, left edge on the CFA period. RLD
+    // runs across the whole window; its border error stays in the halo.
+    const int x0 = std::max(0, region.x0 - rldHalo - kRU_DemosaicHaloRows) / 6 * 6;
+    const int x1 = std::min(W, region.x1 + rldHalo + kRU_DemosaicHaloRows);
+    const int WW = x1 - x0;
+    const float userEV = P.hasExposure ? P.exposureEV : 0.f;
+
+    if (rld) job.post("rld", "iter", 0, iters * bands);
+    else     job.post("rld", "skip", 0, 0);
+
+    for (int b = 0; b < bands; ++b) {
+        // core rows this band owns, RLD context around them, demosaic context around that
+        const int y0 = region.y0 + b * bandRows, y1 = std::min(region.y1, y0 + bandRows);
+        const int w0 = std::max(0, y0 - rldHalo), w1 = std::min(H, y1 + rldHalo);
+        const int d0 = std::max(0, w0 - kRU_DemosaicHaloRows) / 6 * 6;
+        const int d1 = std::min(H, w1 + kRU_DemosaicHaloRows);
+
+        const size_t nd = (size_t)WW * (d1 - d0);
+        RUPooled<float> R(nd), G(nd), B(nd);
+        if (!R || !G || !B) return false;
+        job.post("libraw", "demosaic", b, bands);
+        {
+            RUTraceScope t("demosaic", "develop", nd * (3 * sizeof(float) + sizeof(uint16_t)));
+            if (!demosaic(x0, d0, x1, d1, R.get(), G.get(), B.get())) return false;
+        }
+
+        // highlights see the whole demosaiced band (regions cut by the band
+        // edge still have their other borders to propagate from)
+        bool hl;
+        {
+            RUTraceScope t("highlights", "develop", P.hlRecovery ? nd * 24 : 0);
+            hl = RU_ReconstructHighlights(color, P, R.get(), G.get(), B.get(), WW, d1 - d0);
+        }
+
+        // RLD context rows only; demosaic halo rows are dropped from here on
+        const size_t wOff = (size_t)WW * (w0 - d0), nw = (size_t)WW * (w1 - w0);
+        float *Rw = R.get() + wOff, *Gw = G.get() + wOff, *Bw = B.get() + wOff;
+        RUPooled<uint8_t> flags(out.mask ? nw : 0);
+        {
+            RUTraceScope t("wb_matrix", "develop", nw * 24);
+            RU_ApplyCameraWBToSRGB(color, Rw, Gw, Bw, nw, flags.get(), hl);
+        }
+
+        if (rld) {
+            RUTraceScope t("rld", "develop", nw * 24 * iters);
+            const RURLDParams rp { iters, rad, amt, P.deconvDamping };
+            RU_RLDLuma(Rw, Gw, Bw, WW, w1 - w0, rp, [&](int iter, int total) {
+                job.post("rld", "iter", b * total + iter, total * bands);
+            });
+        }
+
+        // core rows only from here on (the tone/Lab ops are per pixel, so the
+        // column halo can ride along)
+        const size_t cOff = (size_t)WW * (y0 - w0);
+        const int    nc   = WW * (y1 - y0);
+        float *Rc = Rw + cOff, *Gc = Gw + cOff, *Bc = Bw + cOff;
+        {
+            RUTraceScope t("tone", "develop", (size_t)nc * 24);
+            RU_ApplyExposureEV(Rc, Gc, Bc, nc, userEV);
+            if (P.hasBlack)    RU_ApplyBlack(Rc, Gc, Bc, nc, P.black);
+            if (P.hasShadows)  RU_ApplyShadows(Rc, Gc, Bc, nc, P.shadows);
+        }
+        {
+            RUTraceScope t("lab", "develop", (size_t)nc * 24);
+            RU_ApplyLabOps_OnPlanes(Rc, Gc, Bc, nc,
+                                    P.chromaEnabled, P.chromaticity,
+                                    P.cChromaEnabled, P.cChroma,
+                                    P.jContrastEnabled, P.jContrast);
+        }
+        const int cx = region.x0 - x0;
+        const uint8_t *Fc = flags ? flags.get() + cOff + cx : nullptr;
+        RUTraceScope t("pack", "develop", (size_t)region.width() * (y1 - y0) * (out.format == RUPackTarget::RGB16 ? 18 : 16));
+        RU_PackRows(out, Rc + cx, Gc + cx, Bc + cx, (size_t)WW, y0 - region.y0, y1 - region.y0, Fc);
+    }
+    if (rld) job.post("rld", "iter", iters * bands, iters * bands);
+    return true;
+}
+
+// Downscaled variant for exports with a target size: demosaic → highlights →
+// Lanczos-3 to the output size (camera RGB, linear light) one band of output
+// rows at a time, then WB/cam→sRGB → RLD → tone → Lab → pack on the small
+// planes. `out` is already allocated at the output size; `region` is the
+// sensor window.
+static bool RU_RenderScaledBands(int W, int H, const RURegion &region,
+                                 const libraw_colordata_t &color,
+                                 const RU_PP3 &P, const RUJobHooks &job, RUPackTarget &out,
+                                 const RUBandDemosaic &demosaic)
+{
+    const int OW = out.srcW, OH = out.srcH;
+    const double sx = (double)region.width()  / OW;   // source px per output px
+    const double sy = (double)region.height() / OH;
+    const int supX = (int)std::ceil(3.0 * std::max(1.0, sx)) + 1;
+    const int supY = (int)std::ceil(3.0 * std::max(1.0, sy)) + 1;
+
+    // RLD on the output grid: the PSF shrinks with the image. Below half an
+    // output pixel the resampler has already absorbed it.
+    const int   iters = P.deconvIter;
+    const float amt   = P.deconvAmount;
+    const float rad   = fmaxf(0.05f, P.deconvRadius) / (float)std::max(sx, sy);
+    const bool  rld   = iters > 0 && amt > 0.f && rad >= 0.5f;
+
+    const size_t on = (size_t)OW * OH;
+    RUPooled<float> SR(on), SG(on), SB(on);
+    if (!SR || !SG || !SB) return false;
+
+    // Columns: the region plus kernel support plus demosaic halo, left edge on
+    // the CFA period. Taps never reach the (unreliable) halo columns.
+    const int x0 = std::max(0, region.x0 - supX - kRU_DemosaicHaloRows) / 6 * 6;
+    const int x1 = std::min(W, region.x1 + supX + kRU_DemosaicHaloRows);
+    const int WW = x1 - x0;
+    RUResampleTaps th;
+    if (!RU_LanczosTaps(OW, region.x0 - x0, sx, 0, WW, th)) return false;
+
+    const int req      = gRU_FullResBandRows.load(std::memory_order_relaxed);
+    const int bandOut  = (req > 0) ? std::min(OH, std::max(8, (int)(std::max(req, 64) / sy))) : OH;
+    const int bands    = (OH + bandOut - 1) / bandOut;
+    bool hl = false;   // some band had highlights rebuilt
+
+    for (int b = 0; b < bands; ++b) {
+        // output rows of this band → source rows their taps read → demosaic rows
+        const int j0 = b * bandOut, j1 = std::min(OH, j0 + bandOut);
+        const double c0 = region.y0 + (j0 + 0.5) * sy - 0.5;
+        const double c1 = region.y0 + (j1 - 0.5) * sy - 0.5;
+        const int s0 = std::max(0, (int)std::floor(c0) - supY);
+        const int s1 = std::min(H, (int)std::ceil(c1) + supY + 1);
+        const int d0 = std::max(0, s0 - kRU_DemosaicHaloRows) / 6 * 6;
+        const int d1 = std::min(H, s1 + kRU_DemosaicHaloRows);
+
+        const size_t nd = (size_t)WW * (d1 - d0);
+        RUPooled<float> R(nd), G(nd), B(nd);
+        RUPooled<float> T((size_t)OW * (s1 - s0));
+        if (!R || !G || !B || !T) return false;
+        job.post("libraw", "demosaic", b, bands);
+        {
+            RUTraceScope t("demosaic", "develop", nd * (3 * sizeof(float) + sizeof(uint16_t)));
+            if (!demosaic(x0, d0, x1, d1, R.get(), G.get(), B.get())) return false;
+        }
+        // highlights on sensor pixels: after the resampler, clipped pixels
+        // would already be blended with their unclipped neighbours
+        {
+            RUTraceScope t("highlights", "develop", P.hlRecovery ? nd * 24 : 0);
+            hl |= RU_ReconstructHighlights(color, P, R.get(), G.get(), B.get(), WW, d1 - d0);
+        }
+
+        RUTraceScope t("resample", "develop", ((size_t)WW * (s1 - s0) + (size_t)OW * (j1 - j0)) * 12);
+        RUResampleTaps tv;
+        if (!RU_LanczosTaps(j1 - j0, region.y0 - s0 + j0 * sy, sy, 0, s1 - s0, tv)) return false;
+        const size_t sOff = (size_t)WW * (s0 - d0), oOff = (size_t)OW * j0;
+        const std::pair<float *, float *> planes[3] = {
+            { R.get() + sOff, SR.get() + oOff },
+            { G.get() + sOff, SG.get() + oOff },
+            { B.get() + sOff, SB.get() + oOff },
+        };
+        for (const auto &pl : planes) {
+            RU_ResampleH(pl.first, (size_t)WW, s1 - s0, th, T.get(), (size_t)OW);
+            RU_ResampleV(T.get(), (size_t)OW, OW, tv, pl.second, (size_t)OW);
+        }
+    }
+
+    // WB/cam→sRGB is linear, so it commutes with the resampler: run it once
+    // here on the small planes.
+    float *R = SR.get(), *G = SG.get(), *B = SB.get();
+    {
+        RUTraceScope t("wb_matrix", "develop", on * 24);
+        RU_ApplyCameraWBToSRGB(color, R, G, B, on, nullptr, hl);
+    }
+
+    if (rld) {
+        RUTraceScope t("rld", "develop", on * 24 * iters);
+        const RURLDParams rp { iters, rad, amt, P.deconvDamping };
+        job.post("rld", "iter", 0, iters);
+        RU_RLDLuma(R, G, B, OW, OH, rp, [&](int iter, int total) {
+            job.post("rld", "iter", iter, total);
+        });
+    } else {
+        job.post("rld", "skip", 0, 0);
+    }
+
+    const int n = (int)on;
+    {
+        RUTraceScope t("tone", "develop", on * 24);
+        RU_ApplyExposureEV(R, G, B, n, P.hasExposure ? P.exposureEV : 0.f);
+        if (P.hasBlack)    RU_ApplyBlack(R, G, B, n, P.black);
+        if (P.hasShadows)  RU_ApplyShadows(R, G, B, n, P.shadows);
+    }
+    {
+        RUTraceScope t("lab", "develop", on * 24);
+        RU_ApplyLabOps_OnPlanes(R, G, B, n,
+                                P.chromaEnabled, P.chromaticity,
+                                P.cChromaEnabled, P.cChroma,
+                                P.jContrastEnabled, P.jContrast);
+    }
+    RUTraceScope t("pack", "develop", on * (out.format == RUPackTarget::RGB16 ? 18 : 16));
+    RU_PackRows(out, R, G, B, (size_t)OW, 0, OH);
+    return true;
+}
+
+// Opens `path` on a pooled handle, traced.
+static libraw_data_t *RU_TracedOpen(const char *path) {
+    RUTraceScope t("libraw.open", "libraw");
+    libraw_data_t *raw = RU_LibRawAcquire();
+    if (!raw) return nullptr;
+    if (RU_LibRawOpen(raw, path) != LIBRAW_SUCCESS) { RU_LibRawRelease(raw); return nullptr; }
+    return raw;
+}
+
+static bool RU_TracedUnpack(libraw_data_t *raw) {
+    RUTraceScope t("libraw.unpack", "libraw", (uint64_t)raw->sizes.raw_pitch * raw->sizes.raw_height);
+    return libraw_unpack(raw) == LIBRAW_SUCCESS;
+}
+
+// Stage events of the render that just finished go to the file's session.
+static void RU_StoreTimings(const char *path, const RUTraceJob &trace) {
+    if (!RU_TraceEnabled()) return;
+    if (const std::shared_ptr<RUSession> s = RU_SessionForPath(path))
+        s->setTimings(std::make_shared<const RUSession::Timings>(trace.events()));
+}
+
+static bool RU_RenderFullResJob(const char *path, const RU_PP3 &P, const RUJobHooks &job, RUPackTarget &out)
+{
+    job.post("libraw", "open");
+    libraw_data_t *raw = RU_TracedOpen(path);
+    if (!raw) return false;
+    job.post("libraw", "identify");
+
+    const int W = raw->sizes.iwidth, H = raw->sizes.iheight;
+    if (!RU_TracedUnpack(raw)) { RU_LibRawRelease(raw); return false; }
+    job.post("libraw", "unpack");
+
+    bool ok = false;
+    job.post("libraw", "demosaic");
+    RURawMosaic mosaic;
+    if (out.exif == 0) out.exif = ru_exif_from_flip(raw->sizes.flip);
+    const RURegion region = (W > 0 && H > 0) ? out.resolveRegion(W, H) : RURegion{};
+    const int RW = region.width(), RH = region.height(), RL = std::max(RW, RH);
+    const bool scaled = out.longEdge > 0 && out.longEdge < RL;
+    const int OW = scaled ? std::max(1, (int)lrint((double)RW * out.longEdge / RL)) : RW;
+    const int OH = scaled ? std::max(1, (int)lrint((double)RH * out.longEdge / RL)) : RH;
+    auto render = scaled ? RU_RenderScaledBands : RU_RenderFullResBands;
+    const bool haveMosaic = RU_MosaicFromLibRaw(raw, mosaic) && mosaic.width == W && mosaic.height == H;
+    if (W <= 0 || H <= 0 || !out.allocate(OW, OH)) {
+        // no room for the output
+    } else if (haveMosaic && mosaic.period == 2) {
+        // ---- Bayer path (CA → AMAZE) ----
+        // Visible area only, same per-colour black/white as the binned preview.
+        RUCASettings ca;
+        ca.autoCA = P.caAuto; ca.iterations = P.caAutoIterations;
+        ca.red = P.caRed; ca.blue = P.caBlue; ca.avoidColourshift = P.caAvoidColourshift;
+        unsigned cf4[4], cfa[2][2];
+        for (int k=0;k<4;k++) { const unsigned c = mosaic.cfa[k>>1][k&1]; cf4[k] = cfa[k>>1][k&1] = (c == 3) ? 1 : c; }
+
+        // Lateral CA: one CA_correct pass over the whole frame (one fit, no
+        // seams), cached in the session; bands then read the corrected mosaic.
+        // Costs a frame-sized float plane while CA is on.
+        RUPooled<float> caFrame;
+        if (ca.active()) {
+            RUTraceScope t("ca_correct", "develop", (uint64_t)W * H * 12);
+            const std::shared_ptr<RUSession> session = RU_SessionForPath(path);
+            caFrame = RUPooled<float>((size_t)W * H);
+            if (!caFrame || !RU_NormalizeMosaic(mosaic, caFrame.get()) ||
+                !RU_CACorrectMosaic(caFrame.get(), W, H, cfa, ca, session ? &session->caFits : nullptr))
+                caFrame.reset();   // develop uncorrected
+        }
+        ok = render(W, H, region, raw->color, P, job, out,
+                    [&](int x0, int y0, int x1, int y1, float *R, float *G, float *B) {
+            const int bw = x1 - x0, bh = y1 - y0;
+            if (caFrame && bw == W)   // full-width band: the rows are already packed
+                return bridge_amaze_demosaic(caFrame.get() + (size_t)y0 * W, bw, bh, cf4, R, G, B) == 0;
+            RUPooled<float> mono((size_t)bw * bh);
+            if (!mono) return false;
+            if (caFrame) {
+                for (int y = 0; y < bh; ++y)
+                    memcpy(mono.get() + (size_t)y * bw, caFrame.get() + (size_t)(y0 + y) * W + x0, bw * sizeof(float));
+            } else {
+                RURawMosaic band = mosaic;
+                band.left += x0; band.width  = bw;
+                band.top  += y0; band.height = bh;
+                if (!RU_NormalizeMosaic(band, mono.get())) return false;
+            }
+            return bridge_amaze_demosaic(mono.get(), bw, bh, cf4, R, G, B) == 0;
+        });
+
+    } else if (haveMosaic && mosaic.period == 6) {
+        // ---- X-Trans path (Markesteijn) ----
+        // Same mosaic and levels as Bayer; band origins are multiples of 6,
+        // so the frame's 6×6 pattern holds for every band.
+        unsigned xp[6][6];
+        for (int r = 0; r < 6; ++r) for (int c = 0; c < 6; ++c) xp[r][c] = mosaic.cfa[r][c] == 3 ? 1 : mosaic.cfa[r][c];
+        ok = render(W, H, region, raw->color, P, job, out,
+                    [&](int x0, int y0, int x1, int y1, float *R, float *G, float *B) {
+            RURawMosaic band = mosaic;
+            band.left += x0; band.width  = x1 - x0;
+            band.top  += y0; band.height = y1 - y0;
+            const size_t n = (size_t)band.width * band.height;
+            RUPooled<float> mono(n);
+            if (!mono || !RU_NormalizeMosaic(band, mono.get())) return false;
+
+            // the bridge takes each photosite in its own colour plane (others 0)
+            RUPooled<float> P0(n), P1(n), P2(n);
+            if (!P0 || !P1 || !P2) return false;
+            float *planes[3] = { P0.get(), P1.get(), P2.get() };
+            RU_ParallelFor(0, band.height, 64, [&](int r0, int r1) {
+                for (int y = r0; y < r1; ++y) {
+                    const size_t o = (size_t)y * band.width;
+                    for (int c = 0; c < 3; ++c) memset(planes[c] + o, 0, band.width * sizeof(float));
+                    for (int x = 0; x < band.width; ++x)
+                        planes[xp[y % 6][x % 6]][o + x] = mono[o + x];
+                }
+            });
+            return bridge_xtrans_demosaic(P0.get(), P1.get(), P2.get(), band.width, band.height, xp, R, G, B) == 0;
+        });
+
+    } else if (raw->rawdata.color3_image) {
+        // ---- LibRaw-expanded 3-colour image (no CFA mosaic to read) ----
+        const uint16_t (*ximg)[3] = raw->rawdata.color3_image;
+        const float white = (float)raw->color.maximum;
+        float blackGlobal = (float)raw->color.black; if (!(blackGlobal>0.f)) blackGlobal=0.f;
+        const float denom = std::max(1.0f, white - blackGlobal);
+
+        ok = render(W, H, region, raw->color, P, job, out,
+                    [&](int x0, int y0, int x1, int y1, float *R, float *G, float *B) {
+            const int bw = x1 - x0;
+            const size_t n = (size_t)bw * (y1 - y0);
+            RUPooled<float> P0(n), P1(n), P2(n);
+            if (!P0 || !P1 || !P2) return false;
+            for (int y=y0; y<y1; ++y) {
+                const uint16_t (*row)[3] = &ximg[y*(size_t)W];
+                for (int x=x0; x<x1; ++x) {
+                    const size_t i = (size_t)(y-y0)*bw + (x-x0);
+                    P0[i] = std::max(0.f, ((float)row[x][0] - blackGlobal) / denom);
+                    P1[i] = std::max(0.f, ((float)row[x][1] - blackGlobal) / denom);
+                    P2[i] = std::max(0.f, ((float)row[x][2] - blackGlobal) / denom);
+                }
+            }
+            unsigned xp[6][6];
+            for (int r=0;r<6;++r) for (int c=0;c<6;++c)
+                xp[r][c] = (unsigned)(unsigned char)raw->idata.xtrans[r][c];
+
+            return bridge_xtrans_demosaic(P0.get(), P1.get(), P2.get(), bw, y1 - y0, xp, R, G, B) == 0;
+        });
+    }
+    RU_LibRawRelease(raw);
+    job.post("libraw", "convert_rgb");
+    if (!ok) out.pixels.reset();
+    return ok;
+}
+
+bool RU_RenderFullRes(const char *path, const RU_PP3 &P, const RUJobHooks &job, RUPackTarget &out)
+{
+    RUTraceJob trace;
+    bool ok;
+    {
+        RUTraceScope t("render.fullres", "render");
+        ok = RU_RenderFullResJob(path, P, job, out);
+    }
+    RU_StoreTimings(path, trace);
+    return ok;
+}
+
+// MARK: - Binned previews
+
+// Opens the file and bins the mosaic into linear sRGB planes (highlight
+// reconstruction when P asks, camera WB and cam→sRGB applied), plus the
+// RUClipRaw/RUClipGamut flags of that step. Falls back to dcraw's half-size
+// for exotic CFAs (no flags: all zero; dcraw clips highlights itself).
+static bool RU_BinnedBase(const char *path, int binFactor, const RU_PP3 &P, const RUJobHooks &job,
+                          RUPlanarImage &img, RUPooled<uint8_t> &flags)
+{
+    job.post("libraw", "open");
+    libraw_data_t *raw = RU_TracedOpen(path);
+    if (!raw) return false;
+    if (job.isCancelled())           { RU_LibRawRelease(raw); return false; }
+    job.post("libraw", "unpack");
+    if (!RU_TracedUnpack(raw))       { RU_LibRawRelease(raw); return false; }
+    if (job.isCancelled())           { RU_LibRawRelease(raw); return false; }
+
+    // ---- bin straight from raw_image into pooled planes ----
+    RURawMosaic mosaic;
+    job.post("libraw", "demosaic");
+    bool binned;
+    {
+        RUTraceScope t("bin", "develop");
+        binned = RU_MosaicFromLibRaw(raw, mosaic) && RU_BinMosaic(mosaic, binFactor, img);
+        if (binned) t.setBytes((uint64_t)mosaic.width * mosaic.height * 2 + img.pixels() * 12);
+    }
+    if (binned) {
+        job.post("libraw", "convert_rgb");
+        bool hl;
+        {
+            RUTraceScope t("highlights", "develop", P.hlRecovery ? img.pixels() * 24 : 0);
+            hl = RU_ReconstructHighlights(raw->color, P, img.R.get(), img.G.get(), img.B.get(),
+                                          img.width, img.height);
+        }
+        RUTraceScope t("wb_matrix", "develop", img.pixels() * 25);
+        flags = RUPooled<uint8_t>(img.pixels());
+        RU_ApplyCameraWBToSRGB(raw->color, img.R.get(), img.G.get(), img.B.get(), img.pixels(),
+                               flags.get(), hl);
+    } else {
+        // Non-mosaic / exotic CFA: let dcraw bin 2×2, then read image[][4]
+        // directly (no make_mem_image, no 16-bit interleaved intermediate).
+        raw->params.half_size      = 1;     // superpixel
+        raw->params.gamm[0]        = 1.0f;  // linear TRC
+        raw->params.gamm[1]        = 1.0f;
+        raw->params.no_auto_bright = 1;
+        raw->params.use_camera_wb  = 1;     // <-- let LibRaw apply camera WB
+        raw->params.highlight      = P.hlRecovery ? 2 : 0;  // dcraw blend mode
+        raw->params.output_color   = 1;     // <-- sRGB primaries
+        raw->params.output_bps     = 16;
+        raw->params.user_flip      = 0;
+        RUTraceScope t("libraw.dcraw_process", "libraw");
+        if (libraw_dcraw_process(raw) || !raw->image) { RU_LibRawRelease(raw); return false; }
+        job.post("libraw", "convert_rgb");
+
+        // image[][4] is iheight×iwidth, unflipped (user_flip=0; EXIF applied below)
+        const int Wi = raw->sizes.iwidth, Hi = raw->sizes.iheight;
+        if (Wi <= 0 || Hi <= 0 || !img.allocate(Wi, Hi)) { RU_LibRawRelease(raw); return false; }
+        const ushort (*px)[4] = raw->image;
+        const float k = 1.f / 65535.f;
+        for (size_t i = 0, n = img.pixels(); i < n; ++i) {
+            img.R[i] = px[i][0] * k;
+            img.G[i] = px[i][1] * k;
+            img.B[i] = px[i][2] * k;
+        }
+        flags = RUPooled<uint8_t>(img.pixels());
+        if (flags) memset(flags.get(), 0, img.pixels());
+    }
+    RU_LibRawRelease(raw);
+    return true;
+}
+
+static bool RU_RenderBinnedJob(const std::shared_ptr<RUSession> &session, const char *path,
+                               const RU_PP3 &P, int binFactor, const RUJobHooks &job,
+                               RUPackTarget &out)
+{
+    const bool sharpen = P.deconvIter > 0 && P.deconvAmount > 0.f && P.deconvRadius > 0.f;
+    RUSession::PreviewStages &stages = session->stages;
+    const int maskBits = gRU_ClipMaskBits.load(std::memory_order_relaxed);
+    RUPlanarImage img;
+    RUPooled<uint8_t> flags;   // per-pixel RUClipFlag from the WB step (mask mode only)
+    bool haveBase = false, haveSharpened = false;
+    uint64_t baseGen = 0;      // stages.generation of the base `img` came from
+    {
+        RUTraceScope t("preview.stages", "cache");
+        std::lock_guard<std::mutex> lk(session->stageMutex);
+        baseGen = stages.generation;
+        const uint32_t dirty = RU_PP3Diff(stages.P, P);
+        if (stages.bin == binFactor && !(dirty & RUStageRaw)) {
+            const bool rldClean = !(dirty & RUStageRLD);
+            if (sharpen && rldClean && stages.sharpened)
+                haveSharpened = haveBase = img.copyFrom(stages.sharpened);
+            else
+                haveBase = img.copyFrom(stages.base);
+            if (haveBase && maskBits && stages.flags) {
+                flags = RUPooled<uint8_t>(img.pixels());
+                if (flags) memcpy(flags.get(), stages.flags.get(), img.pixels());
+            }
+        }
+        t.setCache(haveBase);
+        if (haveBase) t.setBytes(img.pixels() * 12);
+    }
+    if (haveBase) {
+        job.post("libraw", "convert_rgb");
+    } else {
+        if (!RU_BinnedBase(path, binFactor, P, job, img, flags)) return false;
+        std::lock_guard<std::mutex> lk(session->stageMutex);
+        baseGen = ++stages.generation;
+        stages.bin = binFactor;
+        stages.P = P;
+        stages.sharpened.reset();
+        if (!stages.base.copyFrom(img)) stages.bin = 0;
+        stages.flags = RUPooled<uint8_t>(flags ? img.pixels() : 0);
+        if (stages.flags) memcpy(stages.flags.get(), flags.get(), img.pixels());
+    }
+
+    const int    W = img.width;
+    const int    H = img.height;
+    const size_t N = img.pixels();
+    RUPooled<float> &R = img.R, &G = img.G, &B = img.B;
+
+    if (job.isCancelled()) return false;   // the base stays cached for the next render
+    if (sharpen && haveSharpened) {
+        RUTraceScope t("rld", "develop");
+        t.setCache(true);
+    } else if (sharpen) {
+        RUTraceScope t("rld", "develop", N * 24 * P.deconvIter);
+        t.setCache(false);
+        job.post("rld", "iter", 0, P.deconvIter); // show “RLD 0/N”
+        // Interactive path: RLD planes + scratch may run in FP16 (preview
+        // precision policy); back to FP32 for tone/pack.
+        const RUPrecision prec = gRU_PreviewHalfFloat.load(std::memory_order_relaxed)
+                               ? RUPrecision::Float16 : RUPrecision::Float32;
+        img.convertTo(prec);  // stays FP32 if the FP16 planes can't be had
+        const RURLDParams rp { P.deconvIter, fmaxf(0.05f, P.deconvRadius), P.deconvAmount, P.deconvDamping };
+        RU_RLDLuma(img, rp, [&job](int iter, int total) {
+            job.post("rld", "iter", iter, total); // Swift shows “RLD iter/total”
+        });
+        if (!img.convertTo(RUPrecision::Float32)) return false;
+
+        // Only onto the base this render started from: a concurrent render
+        // with other raw-stage settings may have replaced it meanwhile.
+        std::lock_guard<std::mutex> lk(session->stageMutex);
+        if (stages.bin == binFactor && stages.generation == baseGen) {
+            stages.P = P;
+            if (!stages.sharpened.copyFrom(img)) stages.sharpened.reset();
+        }
+        if (job.isCancelled()) return false;
+    }
+    // ---- linear tone ops ----
+    {
+        RUTraceScope t("tone", "develop", N * 24);
+        if (P.hasExposure) RU_ApplyExposureEV(R.get(), G.get(), B.get(), (int)N, P.exposureEV);
+        if (P.hasBlack)    RU_ApplyBlack    (R.get(), G.get(), B.get(), (int)N, P.black);
+        if (P.hasShadows)  RU_ApplyShadows  (R.get(), G.get(), B.get(), (int)N, P.shadows);
+    }
+    // 🔆 Preview brightness normalizer
+    // Sticky auto-EV normalization: the first render of the file fixes the
+    // baseline (measured net of the slider), later renders reuse it so tone
+    // and sharpening changes don't shift the overall brightness.
+    const float userEV = P.hasExposure ? P.exposureEV : 0.f;
+    float baseEV;
+    if (!session->hasStickyEV(baseEV)) {
+        // first render only; every other row is plenty for a 99th percentile
+        RUTraceScope t("auto_ev", "develop", N * 6);
+        const float measuredEV = RU_AutoEVFromPercentile(R.get(), G.get(), B.get(), W, H, 2, 0.99f, 0.95f);
+        baseEV = session->stickyEV(measuredEV + userEV);
+    }
+    RU_ApplyExposureEV(R.get(), G.get(), B.get(), (int)N, baseEV);
+    
+    // ---- Pack to BGRA sRGB (display histogram on the way) ----
+    auto hist = std::make_shared<RUHistogram>(256);
+    out.format    = RUPackTarget::BGRA8;
+    out.histogram = hist.get();
+    std::shared_ptr<RUClipMask> mask;
+    if (maskBits) {
+        mask = std::make_shared<RUClipMask>();
+        mask->bits = maskBits;
+        out.mask = mask.get();
+    }
+    if (!out.allocate(W, H)) return false;
+    {
+        RUTraceScope t("pack", "develop", N * 16);
+        RU_PackRows(out, R.get(), G.get(), B.get(), (size_t)W, 0, H, flags.get());
+    }
+
+    // ✅ Apply Color Appearance/Lab adjustments in preview too
+    if (P.chromaEnabled || P.cChromaEnabled || P.jContrastEnabled) {
+        RUTraceScope t("lab", "develop", N * 8);
+        RU_ApplyLabOps_OnBGRA(out.pixels.get(), W, H,
+                              P.chromaEnabled,  P.chromaticity,
+                              P.cChromaEnabled, P.cChroma,
+                              P.jContrastEnabled, P.jContrast);
+        RU_HistogramBGRA8(out.pixels.get(), N, *hist);  // Lab moved the pixels after pack
+    }
+    session->setHistogram(std::move(hist));
+    session->setClipMask(out.mask ? std::move(mask) : nullptr);
+    out.histogram = nullptr;   // both belong to the session now
+    out.mask      = nullptr;
+    return true;
+}
+
+bool RU_RenderBinned(const char *path, const RU_PP3 &P, int binFactor, const RUJobHooks &job,
+                     RUPackTarget &out)
+{
+    if (!RU_RawAvailable(path)) return false;
+    const std::shared_ptr<RUSession> session = RU_SessionForPath(path);
+    if (!session) return false;
+
+    RUTraceJob trace;
+    bool ok;
+    {
+        RUTraceScope t("render.preview", "render");
+        ok = RU_RenderBinnedJob(session, path, P, binFactor, job, out);
+    }
+    if (RU_TraceEnabled())
+        session->setTimings(std::make_shared<const RUSession::Timings>(trace.events()));
+    return ok;
+}
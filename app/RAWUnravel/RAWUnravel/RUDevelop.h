@@ -0,0 +1,71 @@
+/*
+    RawUnravel - RUDevelop.h
+    ------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// The RAW develop pipeline without any platform image types: LibRaw open /
+// unpack, binned or banded full-res demosaic, WB and cam→sRGB, RLD, tone,
+// Lab and pack into an RUPackTarget. Per-file state (mapping, preview stages,
+// histogram, clip mask) lives in the file's RUSession. The app wraps this in
+// RTPreviewDecoder; tools/cli drives it directly.
+
+#pragma once
+#include <atomic>
+#include <functional>
+#include "RUPack.h"
+#include "RUPP3.h"
+
+/// How a render reports progress and learns it should stop. Both optional.
+struct RUJobHooks {
+    std::function<void(const char *phase, const char *step, int iter, int total)> progress;
+    std::function<bool()> cancelled;   // checked at stage boundaries
+
+    void post(const char *phase, const char *step, int iter = 0, int total = 0) const {
+        if (progress) progress(phase, step, iter, total);
+    }
+    bool isCancelled() const { return cancelled && cancelled(); }
+};
+
+// MARK: - Settings
+/// Rows per band of full-res renders (at least 4× the RLD halo); 0 renders the
+/// frame as a single band.
+extern std::atomic<int>  gRU_FullResBandRows;
+/// FP16 working planes for the bandwidth-bound stages of binned previews.
+extern std::atomic<bool> gRU_PreviewHalfFloat;
+/// Clipping mask bits per pixel for previews (0 = off, 1 or 8).
+extern std::atomic<int>  gRU_ClipMaskBits;
+
+/// Something to decode: the file exists, or bytes were attached for it.
+bool RU_RawAvailable(const char *path);
+
+/// Raw frame size from LibRaw's identify step (cached in the session).
+bool RU_RawActiveSize(const char *path, int &w, int &h);
+
+/// Opens/unpacks `path` and runs the banded pipeline over out.crop into `out`
+/// (allocated here once the frame size is known), downscaled when out.longEdge
+/// asks for it. out.exif 0 takes the file's orientation from LibRaw. false if
+/// LibRaw or the demosaicer fail.
+bool RU_RenderFullRes(const char *path, const RU_PP3 &P, const RUJobHooks &job, RUPackTarget &out);
+
+/// Binned preview (binFactor 2…4): sensor mosaic → bin + WB → RLD → tone →
+/// sticky auto-EV → pack BGRA8 → Lab. Reuses the session's stages when only
+/// later stages changed; the histogram and clip mask go to the session.
+/// `out` is allocated here. false on failure or cancellation.
+bool RU_RenderBinned(const char *path, const RU_PP3 &P, int binFactor, const RUJobHooks &job,
+                     RUPackTarget &out);
@@ -0,0 +1,88 @@
+/*
+    RawUnravel - RUDevelopSettings.h
+    --------------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// In-memory develop settings handed straight to RTPreviewDecoder (no .pp3
+// file on the render path). Build one from PP3 text or through the typed
+// properties; `settingsHash` keys caches and -invalidatedStagesSince: tells
+// a renderer which stages it has to redo.
+
+#import <Foundation/Foundation.h>
+
+#ifdef __cplusplus
+#include "RUPP3.h"
+#endif
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// Pipeline stages, in processing order.
+typedef NS_OPTIONS(NSUInteger, RUDevelopStage) {
+    RUDevelopStageSharpen = 1 << 0,   ///< RL deconvolution
+    RUDevelopStageTone    = 1 << 1,   ///< exposure, black point, shadows
+    RUDevelopStageLab     = 1 << 2,   ///< chromaticity, C-chroma, J-contrast
+    RUDevelopStageRaw     = 1 << 3,   ///< CA correction, highlight reconstruction (run first)
+};
+
+@interface RUDevelopSettings : NSObject <NSCopying>
+
+/// Defaults (no adjustments).
+- (instancetype)init NS_DESIGNATED_INITIALIZER;
+/// Parsed from .pp3 text; unknown keys are ignored.
+- (instancetype)initWithPP3String:(NSString *)pp3;
+
+// Tone. Setting a value enables it.
+@property (nonatomic) float exposureEV;
+@property (nonatomic) float blackPoint;     ///< PP3 units, 0...255
+@property (nonatomic) float shadows;        ///< -100...100
+
+// Lab / colour appearance
+@property (nonatomic) BOOL  chromaEnabled;
+@property (nonatomic) float chromaticity;
+@property (nonatomic) BOOL  cChromaEnabled;
+@property (nonatomic) float cChroma;
+@property (nonatomic) BOOL  jContrastEnabled;
+@property (nonatomic) float jContrast;
+
+// Raw
+@property (nonatomic) BOOL highlightReconstruction;  ///< inpaint clipped highlights
+@property (nonatomic) BOOL autoCA;                   ///< fit and correct lateral CA (full-res)
+@property (nonatomic) float caRed;                   ///< manual CA shifts, used when autoCA is off
+@property (nonatomic) float caBlue;
+
+// RL deconvolution
+@property (nonatomic) NSInteger deconvIterations;
+@property (nonatomic) float deconvAmount;
+@property (nonatomic) float deconvRadius;
+@property (nonatomic) float deconvDamping;
+
+/// Stable hash of every setting (equal settings → equal hash).
+@property (nonatomic, readonly) uint64_t settingsHash;
+
+/// Stages whose inputs differ from `previous` (all of them when nil).
+- (RUDevelopStage)invalidatedStagesSince:(nullable RUDevelopSettings *)previous;
+
+#ifdef __cplusplus
+/// The parsed values, as the renderers take them.
+- (const RU_PP3 &)params;
+#endif
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,106 @@
+/*
+    RawUnravel - RUDevelopSettings.mm
+    ---------------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#import "RUDevelopSettings.h"
+
+@implementation RUDevelopSettings {
+    RU_PP3 _p;
+}
+
+- (instancetype)init {
+    return [super init];
+}
+
+- (instancetype)initWithPP3String:(NSString *)pp3 {
+    if ((self = [self init])) {
+        NSData *utf8 = [pp3 dataUsingEncoding:NSUTF8StringEncoding];
+        RU_ParsePP3((const char *)utf8.bytes, utf8.length, _p);
+    }
+    return self;
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    RUDevelopSettings *c = [[RUDevelopSettings allocWithZone:zone] init];
+    c->_p = _p;
+    return c;
+}
+
+- (const RU_PP3 &)params { return _p; }
+
+- (float)exposureEV { return _p.exposureEV; }
+- (void)setExposureEV:(float)v { _p.exposureEV = v; _p.hasExposure = fabsf(v) > 1e-4f; }
+- (float)blackPoint { return _p.black * 255.f; }
+- (void)setBlackPoint:(float)v { _p.black = v / 255.f; _p.hasBlack = true; }
+- (float)shadows { return _p.shadows; }
+- (void)setShadows:(float)v { _p.shadows = v; _p.hasShadows = true; }
+
+- (BOOL)chromaEnabled { return _p.chromaEnabled; }
+- (void)setChromaEnabled:(BOOL)v { _p.chromaEnabled = v; }
+- (float)chromaticity { return _p.chromaticity; }
+- (void)setChromaticity:(float)v { _p.chromaticity = v; }
+- (BOOL)cChromaEnabled { return _p.cChromaEnabled; }
+- (void)setCChromaEnabled:(BOOL)v { _p.cChromaEnabled = v; }
+- (float)cChroma { return _p.cChroma; }
+- (void)setCChroma:(float)v { _p.cChroma = v; }
+- (BOOL)jContrastEnabled { return _p.jContrastEnabled; }
+- (void)setJContrastEnabled:(BOOL)v { _p.jContrastEnabled = v; }
+- (float)jContrast { return _p.jContrast; }
+- (void)setJContrast:(float)v { _p.jContrast = v; }
+
+- (BOOL)highlightReconstruction { return _p.hlRecovery; }
+- (void)setHighlightReconstruction:(BOOL)v { _p.hlRecovery = v; }
+- (BOOL)autoCA { return _p.caAuto; }
+- (void)setAutoCA:(BOOL)v { _p.caAuto = v; }
+- (float)caRed { return _p.caRed; }
+- (void)setCaRed:(float)v { _p.caRed = v; }
+- (float)caBlue { return _p.caBlue; }
+- (void)setCaBlue:(float)v { _p.caBlue = v; }
+
+- (NSInteger)deconvIterations { return _p.deconvIter; }
+- (void)setDeconvIterations:(NSInteger)v { _p.deconvIter = (int)v; }
+- (float)deconvAmount { return _p.deconvAmount; }
+- (void)setDeconvAmount:(float)v { _p.deconvAmount = v; }
+- (float)deconvRadius { return _p.deconvRadius; }
+- (void)setDeconvRadius:(float)v { _p.deconvRadius = v; }
+- (float)deconvDamping { return _p.deconvDamping; }
+- (void)setDeconvDamping:(float)v { _p.deconvDamping = v; }
+
+- (uint64_t)settingsHash { return RU_PP3Hash(_p); }
+
+- (RUDevelopStage)invalidatedStagesSince:(RUDevelopSettings *)previous {
+    const uint32_t m = previous ? RU_PP3Diff(previous->_p, _p) : RUStageAll;
+    RUDevelopStage s = 0;
+    if (m & RUStageRaw)  s |= RUDevelopStageRaw;
+    if (m & RUStageRLD)  s |= RUDevelopStageSharpen;
+    if (m & RUStageTone) s |= RUDevelopStageTone;
+    if (m & RUStageLab)  s |= RUDevelopStageLab;
+    return s;
+}
+
+- (BOOL)isEqual:(id)other {
+    if (other == self) return YES;
+    if (![other isKindOfClass:[RUDevelopSettings class]]) return NO;
+    return RU_PP3Diff(_p, ((RUDevelopSettings *)other)->_p) == 0;
+}
+
+- (NSUInteger)hash { return (NSUInteger)RU_PP3Hash(_p); }
+
+@end
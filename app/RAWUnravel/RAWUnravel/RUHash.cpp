@@ -0,0 +1,111 @@
+/*
+    RawUnravel - RUHash.cpp
+    -----------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RUHash.h"
+#include <cstring>
+
+namespace {
+
+constexpr uint64_t kP1 = 11400714785074694791ull;
+constexpr uint64_t kP2 = 14029467366897019727ull;
+constexpr uint64_t kP3 =  1609587929392839161ull;
+constexpr uint64_t kP4 =  9650029242287828579ull;
+constexpr uint64_t kP5 =  2870177450012600261ull;
+
+inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+// little-endian loads (every target we ship is LE)
+inline uint64_t read64(const unsigned char *p) { uint64_t v; memcpy(&v, p, 8); return v; }
+inline uint32_t read32(const unsigned char *p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+inline uint64_t round(uint64_t acc, uint64_t in) {
+    acc += in * kP2;
+    return rotl(acc, 31) * kP1;
+}
+
+inline uint64_t merge(uint64_t acc, uint64_t v) {
+    acc ^= round(0, v);
+    return acc * kP1 + kP4;
+}
+
+} // namespace
+
+RUXXH64::RUXXH64(uint64_t seed) : seed_(seed) {
+    v_[0] = seed + kP1 + kP2;
+    v_[1] = seed + kP2;
+    v_[2] = seed;
+    v_[3] = seed - kP1;
+}
+
+void RUXXH64::update(const void *data, size_t len) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    total_ += len;
+
+    if (bufLen_ + len < 32) {
+        memcpy(buf_ + bufLen_, p, len);
+        bufLen_ += len;
+        return;
+    }
+    if (bufLen_) {
+        const size_t fill = 32 - bufLen_;
+        memcpy(buf_ + bufLen_, p, fill);
+        for (int i = 0; i < 4; ++i) v_[i] = round(v_[i], read64(buf_ + 8 * i));
+        p += fill; len -= fill;
+        bufLen_ = 0;
+    }
+    uint64_t v0 = v_[0], v1 = v_[1], v2 = v_[2], v3 = v_[3];
+    for (; len >= 32; p += 32, len -= 32) {
+        v0 = round(v0, read64(p));
+        v1 = round(v1, read64(p + 8));
+        v2 = round(v2, read64(p + 16));
+        v3 = round(v3, read64(p + 24));
+    }
+    v_[0] = v0; v_[1] = v1; v_[2] = v2; v_[3] = v3;
+    memcpy(buf_, p, len);
+    bufLen_ = len;
+}
+
+uint64_t RUXXH64::digest() const {
+    uint64_t h;
+    if (total_ >= 32) {
+        h = rotl(v_[0], 1) + rotl(v_[1], 7) + rotl(v_[2], 12) + rotl(v_[3], 18);
+        for (int i = 0; i < 4; ++i) h = merge(h, v_[i]);
+    } else {
+        h = seed_ + kP5;
+    }
+    h += total_;
+
+    const unsigned char *p = buf_, *end = buf_ + bufLen_;
+    for (; p + 8 <= end; p += 8) h = rotl(h ^ round(0, read64(p)), 27) * kP1 + kP4;
+    if (p + 4 <= end) { h = rotl(h ^ (uint64_t)read32(p) * kP1, 23) * kP2 + kP3; p += 4; }
+    for (; p < end; ++p) h = rotl(h ^ (uint64_t)*p * kP5, 11) * kP1;
+
+    h ^= h >> 33; h *= kP2;
+    h ^= h >> 29; h *= kP3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t RU_XXH64(const void *data, size_t len, uint64_t seed) {
+    RUXXH64 s(seed);
+    s.update(data, len);
+    return s.digest();
+}
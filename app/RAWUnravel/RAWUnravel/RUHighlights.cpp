@@ -0,0 +1,192 @@
+/*
+    RawUnravel - RUHighlights.cpp
+    -----------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RUHighlights.h"
+#include "RUBufferPool.h"
+#include "RUParallel.h"
+#include "librtprocess.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+constexpr int   kCell   = 32;       // scheduling grid, pixels
+constexpr int   kMargin = 2;        // cells of context around each region
+constexpr float kClip   = 0.999f;   // at the white level
+constexpr float kNear   = 0.90f;    // inpainter blends from here up
+constexpr float kScale  = 65535.f;  // HLRecovery_inpaint works in raw units
+constexpr double kWholeFrame = 0.6; // tile area share above which one tile is cheaper
+
+enum : uint8_t { kCellClean = 0, kCellNear = 1, kCellClipped = 2 };
+
+struct RUBox { int x0, y0, x1, y1; };   // cells, half-open
+
+bool ru_overlap(const RUBox &a, const RUBox &b) {
+    return a.x0 < b.x1 && b.x0 < a.x1 && a.y0 < b.y1 && b.y0 < a.y1;
+}
+
+// 8-connected groups of marked cells that contain a clipped one → bounding
+// boxes grown by kMargin, overlapping boxes merged.
+std::vector<RUBox> ru_regions(const std::vector<uint8_t> &cells, int gw, int gh) {
+    std::vector<RUBox> boxes;
+    std::vector<uint8_t> seen(cells.size(), 0);
+    std::vector<int> stack;
+    for (int start = 0; start < gw * gh; ++start) {
+        if (!cells[start] || seen[start]) continue;
+        RUBox b { gw, gh, 0, 0 };
+        bool clipped = false;
+        stack.assign(1, start); seen[start] = 1;
+        while (!stack.empty()) {
+            const int i = stack.back(); stack.pop_back();
+            const int cx = i % gw, cy = i / gw;
+            clipped |= cells[i] == kCellClipped;
+            b.x0 = std::min(b.x0, cx); b.x1 = std::max(b.x1, cx + 1);
+            b.y0 = std::min(b.y0, cy); b.y1 = std::max(b.y1, cy + 1);
+            for (int dy = -1; dy <= 1; ++dy)
+                for (int dx = -1; dx <= 1; ++dx) {
+                    const int nx = cx + dx, ny = cy + dy;
+                    if (nx < 0 || ny < 0 || nx >= gw || ny >= gh) continue;
+                    const int n = ny * gw + nx;
+                    if (cells[n] && !seen[n]) { seen[n] = 1; stack.push_back(n); }
+                }
+        }
+        if (!clipped) continue;  // bright but intact: nothing to reconstruct
+        b.x0 = std::max(0, b.x0 - kMargin); b.y0 = std::max(0, b.y0 - kMargin);
+        b.x1 = std::min(gw, b.x1 + kMargin); b.y1 = std::min(gh, b.y1 + kMargin);
+        boxes.push_back(b);
+    }
+    // merge until no two boxes overlap (tiles must not share pixels)
+    for (bool merged = true; merged; ) {
+        merged = false;
+        for (size_t i = 0; i < boxes.size() && !merged; ++i)
+            for (size_t j = i + 1; j < boxes.size(); ++j) {
+                if (!ru_overlap(boxes[i], boxes[j])) continue;
+                boxes[i] = { std::min(boxes[i].x0, boxes[j].x0), std::min(boxes[i].y0, boxes[j].y0),
+                             std::max(boxes[i].x1, boxes[j].x1), std::max(boxes[i].y1, boxes[j].y1) };
+                boxes.erase(boxes.begin() + (long)j);
+                merged = true;
+                break;
+            }
+    }
+    return boxes;
+}
+
+// One tile through the inpainter: scale to WB'd raw units, run, scale back.
+// The planes are left alone if the inpainter fails.
+bool ru_inpaint_tile(float *R, float *G, float *B, int W, int x0, int y0, int x1, int y1,
+                     const float wb[3], const float chmax[3], const float clmax[3])
+{
+    const int tw = x1 - x0, th = y1 - y0;
+    const size_t n = (size_t)tw * th;
+    RUPooled<float> buf(n * 3);
+    if (!buf) return false;
+    float *plane[3] = { buf.get(), buf.get() + n, buf.get() + 2 * n };
+    float *const src[3] = { R, G, B };
+    std::vector<float *> rows[3];
+    for (int c = 0; c < 3; ++c) {
+        const float k = wb[c] * kScale;
+        rows[c].resize((size_t)th);
+        for (int y = 0; y < th; ++y) {
+            const float *s = src[c] + (size_t)(y0 + y) * W + x0;
+            float *d = plane[c] + (size_t)y * tw;
+            for (int x = 0; x < tw; ++x) d[x] = s[x] * k;
+            rows[c][(size_t)y] = d;
+        }
+    }
+    const rpError e = HLRecovery_inpaint(tw, th, rows[0].data(), rows[1].data(), rows[2].data(),
+                                         chmax, clmax, [](double) { return false; });
+    if (e != RP_NO_ERROR) return false;
+    for (int c = 0; c < 3; ++c) {
+        const float k = 1.f / (wb[c] * kScale);
+        for (int y = 0; y < th; ++y) {
+            const float *s = plane[c] + (size_t)y * tw;
+            float *d = src[c] + (size_t)(y0 + y) * W + x0;
+            for (int x = 0; x < tw; ++x) d[x] = s[x] * k;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int RU_RecoverHighlights(float *R, float *G, float *B, int W, int H, const float wb[3])
+{
+    if (!R || !G || !B || W <= 0 || H <= 0) return 0;
+    const int gw = (W + kCell - 1) / kCell, gh = (H + kCell - 1) / kCell;
+
+    // ---- scan: cell marks + per-channel maxima ----
+    std::vector<uint8_t> cells((size_t)gw * gh, kCellClean);
+    float chmax[3] = { 0.f, 0.f, 0.f };
+    std::mutex maxMerge;
+    RU_ParallelFor(0, gh, 2, [&](int cy0, int cy1) {
+        float m[3] = { 0.f, 0.f, 0.f };
+        for (int cy = cy0; cy < cy1; ++cy) {
+            const int y1 = std::min(H, (cy + 1) * kCell);
+            for (int y = cy * kCell; y < y1; ++y) {
+                const size_t row = (size_t)y * W;
+                for (int cx = 0; cx < gw; ++cx) {
+                    const int x1 = std::min(W, (cx + 1) * kCell);
+                    float r = 0.f, g = 0.f, b = 0.f;
+                    for (int x = cx * kCell; x < x1; ++x) {
+                        r = std::max(r, R[row + x]); g = std::max(g, G[row + x]); b = std::max(b, B[row + x]);
+                    }
+                    const float v = std::max({ r, g, b });
+                    uint8_t &cell = cells[(size_t)cy * gw + cx];
+                    if (v >= kClip) cell = kCellClipped;
+                    else if (v >= kNear && cell == kCellClean) cell = kCellNear;
+                    m[0] = std::max(m[0], r); m[1] = std::max(m[1], g); m[2] = std::max(m[2], b);
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lk(maxMerge);
+        for (int c = 0; c < 3; ++c) chmax[c] = std::max(chmax[c], m[c]);
+    });
+    if (std::find(cells.begin(), cells.end(), (uint8_t)kCellClipped) == cells.end()) return 0;
+
+    // ---- schedule ----
+    std::vector<RUBox> boxes = ru_regions(cells, gw, gh);
+    if (boxes.empty()) return 0;
+    size_t area = 0;
+    for (const RUBox &b : boxes) area += (size_t)(b.x1 - b.x0) * (b.y1 - b.y0);
+    if ((double)area > kWholeFrame * gw * gh) boxes.assign(1, RUBox { 0, 0, gw, gh });
+
+    float clmax[3], chmaxS[3];
+    for (int c = 0; c < 3; ++c) {
+        clmax[c]  = wb[c] * kScale;
+        chmaxS[c] = std::max(chmax[c], 1.f) * wb[c] * kScale;
+    }
+
+    // ---- inpaint, one tile per region ----
+    std::atomic<int> done { 0 };
+    RU_ParallelFor(0, (int)boxes.size(), 1, [&](int i0, int i1) {
+        for (int i = i0; i < i1; ++i) {
+            const RUBox &b = boxes[(size_t)i];
+            if (ru_inpaint_tile(R, G, B, W, b.x0 * kCell, b.y0 * kCell,
+                                std::min(W, b.x1 * kCell), std::min(H, b.y1 * kCell),
+                                wb, chmaxS, clmax))
+                done.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    return done.load();
+}
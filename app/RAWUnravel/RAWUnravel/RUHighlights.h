@@ -0,0 +1,42 @@
+/*
+    RawUnravel - RUHighlights.h
+    ---------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Highlight reconstruction (librtprocess HLRecovery_inpaint) on demosaiced
+// camera-RGB planes, before white balance.
+//
+// The inpainter works on whole frames; here it only sees clipped regions.
+// One max-scan marks 32×32 cells that hold clipped or near-clipped pixels;
+// 8-connected groups of marked cells that contain real clipping become
+// bounding boxes (plus a margin the inpainter propagates colour from),
+// overlapping boxes are merged and each box runs as its own tile, tiles in
+// parallel. An unclipped frame costs the scan and nothing else; if the boxes
+// would cover most of the frame it runs as one tile, so the cost never
+// exceeds a single full-frame call.
+
+#pragma once
+#include <cstddef>
+
+/// Reconstructs clipped highlights of W×H camera-RGB planes in place. Planes
+/// are normalized so 1.0 is the white level; `wb` are the multipliers the WB
+/// step will apply (smallest 1). Reconstructed values may exceed 1.0, so the
+/// WB step after it must not clip them. Returns the number of regions
+/// inpainted (0: nothing clipped, planes untouched).
+int RU_RecoverHighlights(float *R, float *G, float *B, int W, int H, const float wb[3]);
@@ -0,0 +1,166 @@
+/*
+    RawUnravel - RUHistogram.cpp
+    ----------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RUHistogram.h"
+#include "RUParallel.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+float RUHistogram::percentile(Channel c, float p) const {
+    if (count == 0) return 0.f;
+    const uint64_t cutoff = (uint64_t)llrint(std::clamp(p, 0.f, 1.f) * (double)count);
+    uint64_t acc = 0;
+    int bin = bins - 1;
+    for (int b = 0; b < bins; ++b) { acc += ch[c][b]; if (acc >= cutoff) { bin = b; break; } }
+    return (float)bin / (float)(bins - 1);
+}
+
+uint32_t RUHistogram::peak(Channel c) const {
+    return *std::max_element(ch[c], ch[c] + bins);
+}
+
+// MARK: - Linear planes
+
+// NaN → 0, so a bad pixel can never index outside the bins.
+static inline float ru_clamp01(float v) { return v > 0.f ? (v < 1.f ? v : 1.f) : 0.f; }
+
+// Scalar tail / fallback: floor(clamp(v) * (bins-1)), as the old auto-EV did.
+static inline void ru_hist_row_scalar(const float *R, const float *G, const float *B,
+                                      int x0, int x1, float scale, RUHistogram &h)
+{
+    for (int x = x0; x < x1; ++x) {
+        const float r = ru_clamp01(R[x]), g = ru_clamp01(G[x]), b = ru_clamp01(B[x]);
+        const float y = ru_clamp01(0.2126f * R[x] + 0.7152f * G[x] + 0.0722f * B[x]);
+        h.ch[0][(int)(r * scale)]++;
+        h.ch[1][(int)(g * scale)]++;
+        h.ch[2][(int)(b * scale)]++;
+        h.ch[3][(int)(y * scale)]++;
+    }
+}
+
+#if defined(__ARM_NEON)
+// 4 pixels per step: luma, clamp and bin index in vector registers, then four
+// scalar increments per channel (the scatter itself does not vectorize).
+static inline int ru_hist_row_neon(const float *R, const float *G, const float *B,
+                                   int W, float scale, RUHistogram &h)
+{
+    const float32x4_t zero = vdupq_n_f32(0.f), one = vdupq_n_f32(1.f), s = vdupq_n_f32(scale);
+    const float32x4_t kr = vdupq_n_f32(0.2126f), kg = vdupq_n_f32(0.7152f), kb = vdupq_n_f32(0.0722f);
+    int x = 0;
+    for (; x + 4 <= W; x += 4) {
+        const float32x4_t r = vld1q_f32(R + x), g = vld1q_f32(G + x), b = vld1q_f32(B + x);
+        const float32x4_t y = vmlaq_f32(vmlaq_f32(vmulq_f32(kr, r), kg, g), kb, b);
+        uint32_t idx[4][4];
+        vst1q_u32(idx[0], vcvtq_u32_f32(vmulq_f32(vminq_f32(vmaxq_f32(r, zero), one), s)));
+        vst1q_u32(idx[1], vcvtq_u32_f32(vmulq_f32(vminq_f32(vmaxq_f32(g, zero), one), s)));
+        vst1q_u32(idx[2], vcvtq_u32_f32(vmulq_f32(vminq_f32(vmaxq_f32(b, zero), one), s)));
+        vst1q_u32(idx[3], vcvtq_u32_f32(vmulq_f32(vminq_f32(vmaxq_f32(y, zero), one), s)));
+        for (int c = 0; c < 4; ++c)
+            for (int k = 0; k < 4; ++k) h.ch[c][idx[c][k]]++;
+    }
+    return x;
+}
+#endif
+
+void RU_HistogramLinear(const float *R, const float *G, const float *B,
+                        int W, int H, size_t stride, int rowStep, RUHistogram &out)
+{
+    out.reset(out.bins);
+    if (!R || !G || !B || W <= 0 || H <= 0) return;
+    rowStep = std::max(1, rowStep);
+    const int rows = (H + rowStep - 1) / rowStep;
+    const float scale = (float)(out.bins - 1);
+    std::mutex merge;
+
+    RU_ParallelFor(0, rows, 16, [&](int r0, int r1) {
+        std::unique_ptr<RUHistogram> local(new RUHistogram(out.bins));
+        for (int r = r0; r < r1; ++r) {
+            const size_t o = (size_t)r * rowStep * stride;
+            int x = 0;
+#if defined(__ARM_NEON)
+            x = ru_hist_row_neon(R + o, G + o, B + o, W, scale, *local);
+#endif
+            ru_hist_row_scalar(R + o, G + o, B + o, x, W, scale, *local);
+        }
+        local->count = (uint64_t)(r1 - r0) * W;
+        std::lock_guard<std::mutex> lk(merge);
+        out.merge(*local);
+    });
+}
+
+// MARK: - Encoded pixels
+
+#if defined(__ARM_NEON)
+// Luma bins of 16 BGRA8 pixels, (54r + 183g + 19b) >> 8 as RU_HistogramAdd8:
+// vld4 deinterleaves for free and the weights sum to 256, so the products fit
+// 16-bit lanes. Returns the pixels binned; the increments stay scalar.
+static inline size_t ru_hist_bgra8_neon(RUHistogram &h, const uint8_t *bgra, size_t n)
+{
+    const uint8x8_t kr = vdup_n_u8(54), kg = vdup_n_u8(183), kb = vdup_n_u8(19);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const uint8_t *p = bgra + i * 4;
+        const uint8x16x4_t v = vld4q_u8(p);   // B, G, R, A
+        uint16x8_t lo = vmull_u8(vget_low_u8(v.val[2]), kr);
+        lo = vmlal_u8(lo, vget_low_u8(v.val[1]), kg);
+        lo = vmlal_u8(lo, vget_low_u8(v.val[0]), kb);
+        uint16x8_t hi = vmull_u8(vget_high_u8(v.val[2]), kr);
+        hi = vmlal_u8(hi, vget_high_u8(v.val[1]), kg);
+        hi = vmlal_u8(hi, vget_high_u8(v.val[0]), kb);
+        uint8_t y[16];
+        vst1q_u8(y, vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+        for (int k = 0; k < 16; ++k) {
+            h.ch[0][p[k*4+2]]++; h.ch[1][p[k*4+1]]++; h.ch[2][p[k*4+0]]++;
+            h.ch[3][y[k]]++;
+        }
+    }
+    h.count += i;
+    return i;
+}
+#endif
+
+void RU_HistogramAddBGRA8(RUHistogram &h, const uint8_t *bgra, size_t n) {
+    size_t i = 0;
+#if defined(__ARM_NEON)
+    i = ru_hist_bgra8_neon(h, bgra, n);
+#endif
+    for (; i < n; ++i) RU_HistogramAdd8(h, bgra[i*4+2], bgra[i*4+1], bgra[i*4+0]);
+}
+
+void RU_HistogramBGRA8(const uint8_t *bgra, size_t pixels, RUHistogram &out)
+{
+    out.reset(256);
+    if (!bgra || !pixels) return;
+    const int rows = (int)((pixels + 4095) / 4096);   // 4096-pixel chunks
+    std::mutex merge;
+    RU_ParallelFor(0, rows, 4, [&](int c0, int c1) {
+        std::unique_ptr<RUHistogram> local(new RUHistogram(256));
+        const size_t i0 = (size_t)c0 * 4096, i1 = std::min(pixels, (size_t)c1 * 4096);
+        RU_HistogramAddBGRA8(*local, bgra + i0 * 4, i1 - i0);
+        std::lock_guard<std::mutex> lk(merge);
+        out.merge(*local);
+    });
+}
@@ -0,0 +1,89 @@
+/*
+    RawUnravel - RUHistogram.h
+    --------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// R, G, B and luma histograms, built per thread and merged.
+//
+// Two producers:
+//  - RU_HistogramLinear: linear-light float planes (auto-EV), optionally on
+//    every `rowStep`-th row only; NEON bins four pixels per step.
+//  - RU_HistogramAdd8 / RU_HistogramAdd16 / RU_HistogramAddBGRA8: encoded
+//    output pixels, called by the pack stage on the values it has just
+//    written, so display histograms cost no extra pass.
+// Luma is Rec.709 weights on whatever the bins hold (linear or encoded).
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+struct RUHistogram {
+    enum Channel : int { Red = 0, Green = 1, Blue = 2, Luma = 3 };
+    static constexpr int kMaxBins = 1024;
+
+    int      bins  = 256;
+    uint64_t count = 0;
+    uint32_t ch[4][kMaxBins];
+
+    explicit RUHistogram(int nbins = 256) { reset(nbins); }
+
+    void reset(int nbins) {
+        bins = nbins < 2 ? 2 : (nbins > kMaxBins ? kMaxBins : nbins);
+        count = 0;
+        memset(ch, 0, sizeof ch);
+    }
+
+    void merge(const RUHistogram &o) {
+        for (int c = 0; c < 4; ++c)
+            for (int b = 0; b < bins; ++b) ch[c][b] += o.ch[c][b];
+        count += o.count;
+    }
+
+    /// Position (0...1, bin / (bins-1)) of the lowest bin at which the
+    /// cumulative count reaches p of all samples.
+    float percentile(Channel c, float p) const;
+
+    /// Largest bin of channel c (for normalizing a plot).
+    uint32_t peak(Channel c) const;
+};
+
+/// Linear [0,1]-clamped histogram of W×H planes (`stride` floats per row),
+/// every `rowStep`-th row. `out` keeps its bin count and is overwritten.
+void RU_HistogramLinear(const float *R, const float *G, const float *B,
+                        int W, int H, size_t stride, int rowStep, RUHistogram &out);
+
+/// Adds one 8-bit pixel (out.bins must be 256).
+inline void RU_HistogramAdd8(RUHistogram &h, uint8_t r, uint8_t g, uint8_t b) {
+    h.ch[0][r]++; h.ch[1][g]++; h.ch[2][b]++;
+    h.ch[3][(54u * r + 183u * g + 19u * b) >> 8]++;
+    h.count++;
+}
+
+/// Adds one 16-bit pixel into 256 bins.
+inline void RU_HistogramAdd16(RUHistogram &h, uint16_t r, uint16_t g, uint16_t b) {
+    RU_HistogramAdd8(h, (uint8_t)(r >> 8), (uint8_t)(g >> 8), (uint8_t)(b >> 8));
+}
+
+/// Adds `n` pixels of a tightly packed BGRA8 run (out.bins must be 256). NEON
+/// computes the luma bins 16 pixels at a time; the increments stay scalar.
+void RU_HistogramAddBGRA8(RUHistogram &h, const uint8_t *bgra, size_t n);
+
+/// Histogram of a tightly packed BGRA8 buffer (for pixels changed after pack).
+void RU_HistogramBGRA8(const uint8_t *bgra, size_t pixels, RUHistogram &out);
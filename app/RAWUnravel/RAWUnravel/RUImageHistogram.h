@@ -0,0 +1,67 @@
+/*
+    RawUnravel - RUImageHistogram.h
+    -------------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+// Read-only view of a display histogram (256 bins of the 8-bit sRGB output)
+// for UI overlays. Snapshots are immutable; fetch a new one after each render.
+
+#import <Foundation/Foundation.h>
+
+#ifdef __cplusplus
+#include <memory>
+#include "RUHistogram.h"
+#endif
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(NSInteger, RUHistogramChannel) {
+    RUHistogramChannelRed   = 0,
+    RUHistogramChannelGreen = 1,
+    RUHistogramChannelBlue  = 2,
+    RUHistogramChannelLuma  = 3,
+};
+
+@interface RUImageHistogram : NSObject
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic, readonly) NSInteger binCount;
+/// Pixels counted.
+@property (nonatomic, readonly) uint64_t sampleCount;
+
+- (uint32_t)countForChannel:(RUHistogramChannel)channel bin:(NSInteger)bin
+NS_SWIFT_NAME(count(for:bin:));
+
+/// binCount values in 0...1, relative to the channel's largest bin (plotting).
+- (NSArray<NSNumber *> *)normalizedValuesForChannel:(RUHistogramChannel)channel
+NS_SWIFT_NAME(normalizedValues(for:));
+
+/// Position (0...1) below which fraction `p` of the pixels fall.
+- (float)percentile:(float)p channel:(RUHistogramChannel)channel
+NS_SWIFT_NAME(percentile(_:channel:));
+
+#ifdef __cplusplus
+- (instancetype)initWithHistogram:(std::shared_ptr<const RUHistogram>)histogram NS_DESIGNATED_INITIALIZER;
+#endif
+
+@end
+
+NS_ASSUME_NONNULL_END
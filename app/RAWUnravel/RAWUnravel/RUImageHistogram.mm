@@ -0,0 +1,59 @@
+/*
+    RawUnravel - RUImageHistogram.mm
+    --------------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#import "RUImageHistogram.h"
+#import <algorithm>
+
+@implementation RUImageHistogram {
+    std::shared_ptr<const RUHistogram> _h;
+}
+
+- (instancetype)initWithHistogram:(std::shared_ptr<const RUHistogram>)histogram {
+    if ((self = [super init])) {
+        _h = histogram ? std::move(histogram) : std::make_shared<RUHistogram>(256);
+    }
+    return self;
+}
+
+- (NSInteger)binCount { return _h->bins; }
+- (uint64_t)sampleCount { return _h->count; }
+
+- (uint32_t)countForChannel:(RUHistogramChannel)channel bin:(NSInteger)bin {
+    if (channel < 0 || channel > 3 || bin < 0 || bin >= _h->bins) return 0;
+    return _h->ch[channel][bin];
+}
+
+- (NSArray<NSNumber *> *)normalizedValuesForChannel:(RUHistogramChannel)channel {
+    if (channel < 0 || channel > 3) return @[];
+    const RUHistogram::Channel c = (RUHistogram::Channel)channel;
+    const float inv = 1.f / (float)std::max<uint32_t>(1, _h->peak(c));
+    NSMutableArray<NSNumber *> *v = [NSMutableArray arrayWithCapacity:(NSUInteger)_h->bins];
+    for (int b = 0; b < _h->bins; ++b) [v addObject:@(_h->ch[c][b] * inv)];
+    return v;
+}
+
+- (float)percentile:(float)p channel:(RUHistogramChannel)channel {
+    if (channel < 0 || channel > 3) return 0.f;
+    return _h->percentile((RUHistogram::Channel)channel, p);
+}
+
+@end
@@ -23,73 +23,72 @@ import Foundation
 import UniformTypeIdentifiers
 
 // MARK: - RUImport
-// Provides safe import of RAW files from security-scoped file providers
-// into a local temporary directory, suitable for LibRaw/librtprocess.
-// Ensures files are copied (not linked) and validated, and cleans up old imports.
+// Prepares RAW files for LibRaw/librtprocess. Files already inside the app's
+// container are attached in place: the decoder reads a mapping of the file
+// itself and nothing is copied. Anything else (security-scoped file providers)
+// is copied, not linked, into a local temporary directory and validated;
+// copies are content-addressed, so the same file is only ever stored once,
+// and old imports are cleaned up.
 
 enum RUImport {
 
+    // MARK: Prepare
+
+    /// Local URL for decoding `url`: the file itself when it is already in the
+    /// app's container (attached in place), otherwise a copy in tmp.
+    /// Always call from a background queue.
+    static func prepare(_ url: URL) throws -> URL {
+        let local = try attachInPlace(url) ?? copyToTemp(url)
+        RUThumbnailStore.shared.prefetch([local])   // FileView's thumbnail + metadata
+        return local
+    }
+
+    // MARK: Attach In Place
+
+    /// Hands a file inside the app's container (picker copies, Inbox, our
+    /// Documents/tmp) to the decoder as mapped data, skipping another copy;
+    /// every decode of the path then reads that mapping.
+    /// - Returns: `url` when attached; nil if the file is outside the
+    ///   container, unreadable or empty.
+    static func attachInPlace(_ url: URL) -> URL? {
+        guard url.isFileURL else { return nil }
+        let home = URL(fileURLWithPath: NSHomeDirectory()).resolvingSymlinksInPath().path + "/"
+        guard url.resolvingSymlinksInPath().path.hasPrefix(home) else { return nil }
+        guard let data = try? Data(contentsOf: url, options: [.alwaysMapped]), !data.isEmpty else { return nil }
+        return RTPreviewDecoder.attachRAWData(data, toPath: url.path) ? url : nil
+    }
+
     // MARK: Copy to Temp
     
-    /// Copy a (possibly security-scoped) file-provider URL into app's tmp dir.
+    /// Import a (possibly security-scoped) file-provider URL into the app's
+    /// content-addressed import store (`RUImportCache`, in tmp). The copy is
+    /// named by its content hash; re-opening a file already imported returns
+    /// the stored copy without copying it again.
     /// Always call from a background queue to avoid blocking the main thread.
     /// - Parameter url: Security-scoped URL returned from a file importer.
     /// - Returns: Local tmp URL safe for decoding.
     static func copyToTemp(_ url: URL) throws -> URL {
-        if Thread.isMainThread {
-            // Not fatal, but strongly recommend calling off-main.
-        }
-
-        let fm = FileManager.default
-        let baseDir = fm.temporaryDirectory.appendingPathComponent("RAWUnravel_Imported", isDirectory: true)
-        try? fm.createDirectory(at: baseDir, withIntermediateDirectories: true)
-
-        let destURL = baseDir.appendingPathComponent("\(UUID().uuidString)-\(url.lastPathComponent)")
-
         let didStartOriginal = url.startAccessingSecurityScopedResource()
         defer { if didStartOriginal { url.stopAccessingSecurityScopedResource() } }
 
         let coordinator = NSFileCoordinator(filePresenter: nil)
         var coordError: NSError?
         var lastError: Error?
+        var stored: URL?
 
         coordinator.coordinate(readingItemAt: url, options: [.forUploading], error: &coordError) { readingURL in
             let didStartReadingURL = readingURL.startAccessingSecurityScopedResource()
             defer { if didStartReadingURL { readingURL.stopAccessingSecurityScopedResource() } }
 
+            // Providers may still be materializing the file: retry briefly.
             let maxAttempts = 6
             for attempt in 0..<maxAttempts {
                 do {
-                    try? fm.removeItem(at: destURL)
-                    try fm.copyItem(at: readingURL, to: destURL)
-
-                    if let attrs = try? fm.attributesOfItem(atPath: destURL.path),
-                       let size = attrs[.size] as? NSNumber, size.intValue > 0 {
-                        lastError = nil
-                        break
-                    } else {
-                        try? fm.removeItem(at: destURL)
-                        lastError = NSError(domain: "RUImport", code: -2,
-                                            userInfo: [NSLocalizedDescriptionKey: "Copied file has zero size."])
-                    }
+                    stored = try RUImportCache.shared.importFile(at: readingURL, sourceURL: url)
+                    lastError = nil
+                    break
                 } catch {
                     lastError = error
-                    do {
-                        let data = try Data(contentsOf: readingURL, options: [.mappedIfSafe])
-                        try data.write(to: destURL, options: [.atomic])
-                        if let attrs = try? fm.attributesOfItem(atPath: destURL.path),
-                           let size = attrs[.size] as? NSNumber, size.intValue > 0 {
-                            lastError = nil
-                            break
-                        } else {
-                            try? fm.removeItem(at: destURL)
-                            lastError = NSError(domain: "RUImport", code: -3,
-                                                userInfo: [NSLocalizedDescriptionKey: "Written file has zero size."])
-                        }
-                    } catch {
-                        lastError = error
-                        try? fm.removeItem(at: destURL)
-                    }
                 }
                 if attempt < maxAttempts - 1 {
                     Thread.sleep(forTimeInterval: 0.12 + Double(attempt) * 0.05)
@@ -98,37 +97,18 @@ enum RUImport {
         }
 
         if let ce = coordError { throw ce }
-        guard fm.fileExists(atPath: destURL.path) else {
+        guard let local = stored else {
             throw lastError ?? NSError(domain: "RUImport", code: -1,
                                        userInfo: [NSLocalizedDescriptionKey: "Provider did not vend a local file."])
         }
-
-        let attrs = try fm.attributesOfItem(atPath: destURL.path)
-        if let size = attrs[.size] as? NSNumber, size.intValue > 0 {
-            return destURL
-        } else {
-            try? fm.removeItem(at: destURL)
-            throw lastError ?? NSError(domain: "RUImport", code: -4,
-                                       userInfo: [NSLocalizedDescriptionKey: "Imported file appears empty."])
-        }
+        return local
     }
 
     // MARK: Prune Old Imports
     
-    /// Delete imported temporary files older than `days` (default: 3).
+    /// Delete imported files not opened for `days` (default: 3).
     /// Safe to call at app launch to keep tmp directory clean.
     static func pruneOldTempImports(olderThan days: Int = 3) {
-        let fm = FileManager.default
-        let baseDir = fm.temporaryDirectory.appendingPathComponent("RAWUnravel_Imported", isDirectory: true)
-        guard let urls = try? fm.contentsOfDirectory(at: baseDir,
-                                                     includingPropertiesForKeys: [.contentModificationDateKey],
-                                                     options: [.skipsHiddenFiles]) else { return }
-        let cutoff = Date().addingTimeInterval(-Double(days) * 86_400)
-        for u in urls {
-            let rv = try? u.resourceValues(forKeys: [.contentModificationDateKey])
-            if (rv?.contentModificationDate ?? .distantPast) < cutoff {
-                try? fm.removeItem(at: u)
-            }
-        }
+        RUImportCache.shared.prune(olderThanDays: days)
     }
 }
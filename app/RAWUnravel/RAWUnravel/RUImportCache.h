@@ -0,0 +1,61 @@
+/*
+    RawUnravel - RUImportCache.h
+    ----------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Content-addressed store for imported RAWs: tmp/RAWUnravel_Imported/<key>-<name>,
+// where the key is the XXH64 of the file (16 hex digits), computed while
+// copying it in, and <name> the original file name. Content already stored is
+// not kept twice, and re-importing the same source (path, size, mtime) returns
+// the stored copy without reading it again. Stored paths name content, so
+// everything keyed by the decoded path (render sessions, previews) is keyed by
+// content too.
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface RUImportCache : NSObject
+
+@property (class, nonatomic, readonly) RUImportCache *shared;
+
+/// Stored copy of the file at `url`, copied in on a miss. `sourceURL` is the
+/// file's identity for the source index (the picked URL; `url` may be a
+/// coordinated snapshot of it). Call off the main thread.
+- (nullable NSURL *)importFileAtURL:(NSURL *)url sourceURL:(NSURL *)sourceURL error:(NSError **)error
+NS_SWIFT_NAME(importFile(at:sourceURL:));
+
+/// Content key (16 hex digits) of a stored file; nil for other paths.
+- (nullable NSString *)contentKeyForPath:(NSString *)path
+NS_SWIFT_NAME(contentKey(forPath:));
+
+/// Original file name of a stored file (its name without the "<key>-"
+/// prefix); nil for other paths.
+- (nullable NSString *)originalNameForPath:(NSString *)path
+NS_SWIFT_NAME(originalName(forPath:));
+
+/// Deletes stored files not imported or re-opened for `days` and drops
+/// their index entries. Last use is kept in the index, never in the stored
+/// file's mtime (part of its render-session identity).
+- (void)pruneOlderThanDays:(NSInteger)days
+NS_SWIFT_NAME(prune(olderThanDays:));
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,244 @@
+/*
+    RawUnravel - RUImportCache.mm
+    -----------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#import "RUImportCache.h"
+#import "RUHash.h"
+#import <cerrno>
+#import <fcntl.h>
+#import <sys/stat.h>
+#import <unistd.h>
+#import <vector>
+
+static NSString *const kRUImportErrorDomain = @"RUImport";
+static NSString *const kRUImportIndexName   = @".index.plist";
+static NSString *const kRUImportSources     = @"sources";    // source key → stored name
+static NSString *const kRUImportContents    = @"contents";   // content key → stored name
+static NSString *const kRUImportLastUse     = @"lastUse";    // stored name → last import (s since 1970)
+static constexpr size_t kRUImportChunk      = 1 << 20;
+
+static NSError *RU_ImportError(NSInteger code, NSString *what) {
+    return [NSError errorWithDomain:kRUImportErrorDomain code:code
+                           userInfo:@{NSLocalizedDescriptionKey: what}];
+}
+
+static bool RU_StatFile(NSString *path, struct stat &st) {
+    return stat(path.fileSystemRepresentation, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+// Copies `src` to `dst` (created, must not exist), hashing on the way.
+// Returns the byte count, -1 on error.
+static int64_t RU_CopyHashing(NSString *src, NSString *dst, uint64_t &hash) {
+    const int in = open(src.fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+    if (in < 0) return -1;
+    const int out = open(dst.fileSystemRepresentation, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (out < 0) { close(in); return -1; }
+
+    RUXXH64 h;
+    std::vector<unsigned char> buf(kRUImportChunk);
+    int64_t total = 0;
+    bool ok = true;
+    for (;;) {
+        const ssize_t n = read(in, buf.data(), buf.size());
+        if (n == 0) break;
+        if (n < 0) { if (errno == EINTR) continue; ok = false; break; }
+        h.update(buf.data(), (size_t)n);
+        for (ssize_t w = 0; w < n; ) {
+            const ssize_t k = write(out, buf.data() + w, (size_t)(n - w));
+            if (k < 0) { if (errno == EINTR) continue; ok = false; break; }
+            w += k;
+        }
+        if (!ok) break;
+        total += n;
+    }
+    close(in);
+    if (close(out) != 0) ok = false;
+    if (!ok) { unlink(dst.fileSystemRepresentation); return -1; }
+    hash = h.digest();
+    return total;
+}
+
+@implementation RUImportCache {
+    NSString *_dir;
+    dispatch_queue_t _q;                                     // guards the indexes
+    NSMutableDictionary<NSString *, NSString *> *_sources;
+    NSMutableDictionary<NSString *, NSString *> *_contents;
+    NSMutableDictionary<NSString *, NSNumber *> *_lastUse;   // not the file's mtime: that is its identity
+}
+
++ (RUImportCache *)shared {
+    static RUImportCache *s;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{ s = [RUImportCache new]; });
+    return s;
+}
+
+- (instancetype)init {
+    if ((self = [super init])) {
+        _dir = [NSTemporaryDirectory() stringByAppendingPathComponent:@"RAWUnravel_Imported"];
+        [[NSFileManager defaultManager] createDirectoryAtPath:_dir withIntermediateDirectories:YES
+                                                   attributes:nil error:nil];
+        _q = dispatch_queue_create("rawunravel.import-cache", DISPATCH_QUEUE_SERIAL);
+        NSDictionary *saved = [NSDictionary dictionaryWithContentsOfFile:[self indexPath]];
+        NSDictionary *src = saved[kRUImportSources], *con = saved[kRUImportContents], *use = saved[kRUImportLastUse];
+        _sources  = [src isKindOfClass:NSDictionary.class] ? [src mutableCopy] : [NSMutableDictionary dictionary];
+        _contents = [con isKindOfClass:NSDictionary.class] ? [con mutableCopy] : [NSMutableDictionary dictionary];
+        _lastUse  = [use isKindOfClass:NSDictionary.class] ? [use mutableCopy] : [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (NSString *)indexPath { return [_dir stringByAppendingPathComponent:kRUImportIndexName]; }
+
+// _q only
+- (void)saveIndex {
+    [@{ kRUImportSources: _sources, kRUImportContents: _contents, kRUImportLastUse: _lastUse }
+        writeToFile:[self indexPath] atomically:YES];
+}
+
+// _q only. Stamps the stored file `name` as used now, for pruning.
+- (void)markUsed:(NSString *)name {
+    _lastUse[name] = @([NSDate date].timeIntervalSince1970);
+}
+
+// _q only. Path of the indexed file `name` if it is still there with `size`
+// bytes, else nil (stale entries go at the next prune).
+- (nullable NSString *)storedPath:(nullable NSString *)name size:(int64_t)size {
+    if (!name) return nil;
+    NSString *p = [_dir stringByAppendingPathComponent:name];
+    struct stat st {};
+    return (RU_StatFile(p, st) && st.st_size == size) ? p : nil;
+}
+
+// Path + size + mtime: changes whenever the source file does.
+static NSString *RU_SourceKey(NSURL *sourceURL, const struct stat &st) {
+    return [NSString stringWithFormat:@"%@|%lld|%lld.%09ld", sourceURL.standardizedURL.path,
+            (long long)st.st_size, (long long)st.st_mtimespec.tv_sec, (long)st.st_mtimespec.tv_nsec];
+}
+
+- (nullable NSURL *)importFileAtURL:(NSURL *)url sourceURL:(NSURL *)sourceURL error:(NSError **)error {
+    struct stat st {};
+    if (!RU_StatFile(url.path, st) || st.st_size <= 0) {
+        if (error) *error = RU_ImportError(-4, @"Imported file appears empty.");
+        return nil;
+    }
+    struct stat sid {};   // the source's own identity when reachable (`url` may be a snapshot)
+    NSString *const sourceKey = RU_SourceKey(sourceURL, RU_StatFile(sourceURL.path, sid) ? sid : st);
+
+    // ---- same source seen before: no read at all ----
+    __block NSString *known = nil;
+    dispatch_sync(_q, ^{
+        known = [self storedPath:self->_sources[sourceKey] size:st.st_size];
+        if (!known) return;
+        [self markUsed:known.lastPathComponent];
+        [self saveIndex];
+    });
+    if (known) return [NSURL fileURLWithPath:known];
+
+    // ---- copy in, hashing ----
+    NSString *partial = [_dir stringByAppendingPathComponent:
+                         [NSString stringWithFormat:@".partial-%@", [NSUUID UUID].UUIDString]];
+    uint64_t hash = 0;
+    const int64_t copied = RU_CopyHashing(url.path, partial, hash);
+    if (copied <= 0) {
+        unlink(partial.fileSystemRepresentation);
+        if (error) *error = RU_ImportError(copied < 0 ? -2 : -3,
+                                           copied < 0 ? @"Cannot copy file." : @"Copied file has zero size.");
+        return nil;
+    }
+
+    // <key>-<original name>: export and display names come from the file name
+    NSString *const key = [NSString stringWithFormat:@"%016llx", (unsigned long long)hash];
+    __block NSString *stored = nil;
+    __block bool failed = false;
+    dispatch_sync(_q, ^{
+        stored = [self storedPath:self->_contents[key] size:copied];
+        if (stored) {
+            unlink(partial.fileSystemRepresentation);   // same content, from another source
+        } else {
+            NSString *name = [NSString stringWithFormat:@"%@-%@", key, sourceURL.lastPathComponent];
+            stored = [self->_dir stringByAppendingPathComponent:name];
+            if (rename(partial.fileSystemRepresentation, stored.fileSystemRepresentation) != 0) {
+                unlink(partial.fileSystemRepresentation);
+                failed = true;
+                return;
+            }
+            self->_contents[key] = name;
+        }
+        self->_sources[sourceKey] = stored.lastPathComponent;
+        [self markUsed:stored.lastPathComponent];
+        [self saveIndex];
+    });
+    if (failed) {
+        if (error) *error = RU_ImportError(-2, @"Cannot store imported file.");
+        return nil;
+    }
+    return [NSURL fileURLWithPath:stored];
+}
+
+- (nullable NSString *)contentKeyForPath:(NSString *)path {
+    if (![path.stringByDeletingLastPathComponent.stringByStandardizingPath
+          isEqualToString:_dir.stringByStandardizingPath]) return nil;
+    NSString *name = path.lastPathComponent;
+    if (name.length < 18 || [name characterAtIndex:16] != '-') return nil;
+    NSString *key = [name substringToIndex:16];
+    NSCharacterSet *notHex = [NSCharacterSet characterSetWithCharactersInString:@"0123456789abcdef"].invertedSet;
+    return [key rangeOfCharacterFromSet:notHex].location == NSNotFound ? key : nil;
+}
+
+- (nullable NSString *)originalNameForPath:(NSString *)path {
+    NSString *key = [self contentKeyForPath:path];
+    return key ? [path.lastPathComponent substringFromIndex:key.length + 1] : nil;
+}
+
+- (void)pruneOlderThanDays:(NSInteger)days {
+    NSFileManager *fm = [NSFileManager defaultManager];
+    const NSTimeInterval cutoff = [NSDate date].timeIntervalSince1970 - (double)days * 86400.0;
+    dispatch_sync(_q, ^{
+        // Last use from the index; the file's mtime for files it has no stamp for
+        for (NSString *name in [fm contentsOfDirectoryAtPath:self->_dir error:nil]) {
+            if ([name isEqualToString:kRUImportIndexName]) continue;
+            NSString *p = [self->_dir stringByAppendingPathComponent:name];
+            struct stat st {};
+            if (!RU_StatFile(p, st)) continue;
+            NSNumber *used = self->_lastUse[name];
+            const double last = used ? used.doubleValue : (double)st.st_mtimespec.tv_sec;
+            if (last < cutoff) unlink(p.fileSystemRepresentation);
+        }
+        NSUInteger before = self->_sources.count + self->_contents.count + self->_lastUse.count;
+        for (NSMutableDictionary<NSString *, NSString *> *index in @[ self->_sources, self->_contents ]) {
+            NSMutableArray<NSString *> *gone = [NSMutableArray array];
+            [index enumerateKeysAndObjectsUsingBlock:^(NSString *k, NSString *name, BOOL *) {
+                struct stat st {};
+                if (!RU_StatFile([self->_dir stringByAppendingPathComponent:name], st)) [gone addObject:k];
+            }];
+            [index removeObjectsForKeys:gone];
+        }
+        NSMutableArray<NSString *> *unused = [NSMutableArray array];
+        for (NSString *name in self->_lastUse) {
+            struct stat st {};
+            if (!RU_StatFile([self->_dir stringByAppendingPathComponent:name], st)) [unused addObject:name];
+        }
+        [self->_lastUse removeObjectsForKeys:unused];
+        if (self->_sources.count + self->_contents.count + self->_lastUse.count != before) [self saveIndex];
+    });
+}
+
+@end
@@ -0,0 +1,39 @@
+/*
+    RawUnravel - RULibRawStream.h
+    -----------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// LibRaw input without its buffered file stream: LibRaw's buffer datastream
+// over RUMappedBytes. Every read is a memcpy out of the page cache, and any
+// number of LibRaw handles can read the same bytes at once, each with its own
+// stream (the stream holds the read position; the bytes are shared).
+
+#pragma once
+#include <memory>
+#include <libraw/libraw.h>
+#include "RUMappedBytes.h"
+
+class RUMappedDatastream : public LibRaw_buffer_datastream {
+public:
+    explicit RUMappedDatastream(std::shared_ptr<const RUMappedBytes> bytes)
+        : LibRaw_buffer_datastream(bytes->data(), bytes->size()), bytes_(std::move(bytes)) {}
+
+private:
+    std::shared_ptr<const RUMappedBytes> bytes_;   // keeps the bytes alive while LibRaw reads
+};
@@ -0,0 +1,66 @@
+/*
+    RawUnravel - RUMappedBytes.cpp
+    ------------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RUMappedBytes.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::shared_ptr<const RUMappedBytes> RUMappedBytes::mapFile(const char *path) {
+    if (!path || !*path) return nullptr;
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    auto bytes = mapDescriptor(fd);
+    close(fd);
+    return bytes;
+}
+
+std::shared_ptr<const RUMappedBytes> RUMappedBytes::mapDescriptor(int fd) {
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) return nullptr;
+    void *map = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) return nullptr;
+    // LibRaw reads headers scattered over the file, then the sensor data
+    // front to back: let the kernel read ahead.
+    madvise(map, (size_t)st.st_size, MADV_WILLNEED);
+
+    std::shared_ptr<RUMappedBytes> b(new RUMappedBytes());
+    b->data_   = static_cast<const unsigned char *>(map);
+    b->size_   = (size_t)st.st_size;
+    b->mapped_ = true;
+    return b;
+}
+
+std::shared_ptr<const RUMappedBytes> RUMappedBytes::wrap(const void *data, size_t size,
+                                                         std::function<void()> release) {
+    if (!data || size == 0) { if (release) release(); return nullptr; }
+    std::shared_ptr<RUMappedBytes> b(new RUMappedBytes());
+    b->data_    = static_cast<const unsigned char *>(data);
+    b->size_    = size;
+    b->release_ = std::move(release);
+    return b;
+}
+
+RUMappedBytes::~RUMappedBytes() {
+    if (mapped_) munmap(const_cast<unsigned char *>(data_), size_);
+    if (release_) release_();
+}
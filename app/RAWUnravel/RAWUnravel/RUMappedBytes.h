@@ -0,0 +1,55 @@
+/*
+    RawUnravel - RUMappedBytes.h
+    ----------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Immutable byte range: a read-only mmap of a file, or a buffer someone else
+// owns (released through a callback when the last reference goes). Holders
+// share one instance; nothing ever writes through it.
+
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+class RUMappedBytes {
+public:
+    /// Maps `path` read-only; nullptr if it cannot be opened or is empty.
+    static std::shared_ptr<const RUMappedBytes> mapFile(const char *path);
+    /// Same, for an open descriptor (not closed; the mapping outlives it).
+    static std::shared_ptr<const RUMappedBytes> mapDescriptor(int fd);
+    /// Borrows [data, data + size); `release` runs when the last reference
+    /// is dropped (may be empty).
+    static std::shared_ptr<const RUMappedBytes> wrap(const void *data, size_t size,
+                                                     std::function<void()> release);
+
+    const unsigned char *data() const { return data_; }
+    size_t size() const { return size_; }
+
+    RUMappedBytes(const RUMappedBytes &) = delete;
+    RUMappedBytes &operator=(const RUMappedBytes &) = delete;
+    ~RUMappedBytes();
+
+private:
+    RUMappedBytes() = default;
+    const unsigned char  *data_ = nullptr;
+    size_t                size_ = 0;
+    bool                  mapped_ = false;   // munmap on destruction
+    std::function<void()> release_;
+};
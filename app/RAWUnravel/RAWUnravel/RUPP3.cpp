@@ -0,0 +1,268 @@
+/*
+    RawUnravel - RUPP3.cpp
+    ---------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RUPP3.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// MARK: - Parsing
+
+namespace {
+
+enum class RUSection : uint8_t {
+    None, Exposure, HLRecovery, WhiteBalance, Sharpening, Details, RAW, LuminanceCurve, ColorAppearance
+};
+
+constexpr struct { std::string_view name; RUSection id; } kRUSections[] = {
+    { "Exposure",         RUSection::Exposure },
+    { "HLRecovery",       RUSection::HLRecovery },
+    { "White Balance",    RUSection::WhiteBalance },
+    { "Sharpening",       RUSection::Sharpening },
+    { "Details",          RUSection::Details },
+    { "RAW",              RUSection::RAW },
+    { "Luminance Curve",  RUSection::LuminanceCurve },
+    { "Color appearance", RUSection::ColorAppearance },
+};
+
+// Section-level switches; folded into P once the whole text has been read,
+// so key order inside a section does not matter.
+struct RUParseState {
+    RU_PP3 &P;
+    RUSection section = RUSection::None;
+    bool sharpEnabled = true, sharpDeconv = true;
+    bool lumEnabled = true, chromaSeen = false, chromaOn = true;
+    bool caEnabled = true;
+    bool hlSeen = false, hlEnabled = false, hlColor = true;
+};
+
+inline std::string_view ru_trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back()  == ' ' || s.back()  == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+inline bool ru_ieq(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        char x = a[i], y = b[i];
+        if (x >= 'A' && x <= 'Z') x += 'a' - 'A';
+        if (y >= 'A' && y <= 'Z') y += 'a' - 'A';
+        if (x != y) return false;
+    }
+    return true;
+}
+
+// Numbers go through a stack copy (strtof needs a terminator); values that
+// don't parse or aren't finite leave the field untouched.
+inline bool ru_float(std::string_view v, float &out) {
+    char buf[48];
+    if (v.empty() || v.size() >= sizeof buf) return false;
+    memcpy(buf, v.data(), v.size()); buf[v.size()] = 0;
+    char *end = nullptr;
+    const float f = strtof(buf, &end);
+    if (end == buf || !std::isfinite(f)) return false;
+    out = f;
+    return true;
+}
+
+inline bool ru_int(std::string_view v, int lo, int hi, int &out) {
+    char buf[24];
+    if (v.empty() || v.size() >= sizeof buf) return false;
+    memcpy(buf, v.data(), v.size()); buf[v.size()] = 0;
+    char *end = nullptr;
+    const long n = strtol(buf, &end, 10);
+    if (end == buf) return false;
+    out = (int)std::min<long>(hi, std::max<long>(lo, n));
+    return true;
+}
+
+inline bool ru_bool(std::string_view v) { return v == "1" || ru_ieq(v, "true"); }
+
+using RUSetter = void (*)(RUParseState &, std::string_view);
+
+struct RUKey { RUSection section; std::string_view key; RUSetter set; };
+
+#define RU_SET(body) +[](RUParseState &s, std::string_view v) { RU_PP3 &P = s.P; (void)P; body; }
+
+// (section, key) → field. Iterations are capped at 100 (the UI stops at 30)
+// so a hostile profile cannot stall the renderer.
+constexpr RUKey kRUKeys[] = {
+    { RUSection::Exposure, "Compensation",          RU_SET(if (ru_float(v, P.exposureEV)) P.hasExposure = fabsf(P.exposureEV) > 1e-4f) },
+    { RUSection::Exposure, "ExposureCompensation",  RU_SET(if (ru_float(v, P.exposureEV)) P.hasExposure = fabsf(P.exposureEV) > 1e-4f) },
+    { RUSection::Exposure, "Black",                 RU_SET(if (ru_float(v, P.black)) { P.black /= 255.f; P.hasBlack = true; }) },
+    { RUSection::Exposure, "BlackPoint",            RU_SET(if (ru_float(v, P.black)) { P.black /= 255.f; P.hasBlack = true; }) },
+    { RUSection::Exposure, "Shadows",               RU_SET(if (ru_float(v, P.shadows)) P.hasShadows = true) },
+    { RUSection::Exposure, "HighlightReconstruction", RU_SET(P.hlRecovery = ru_bool(v)) },
+    // RawTherapee 5.x: [HLRecovery] Enabled + Method; only the colour
+    // propagation methods map to inpainting.
+    { RUSection::HLRecovery, "Enabled", RU_SET(s.hlSeen = true; s.hlEnabled = ru_bool(v)) },
+    { RUSection::HLRecovery, "Method",  RU_SET(s.hlColor = ru_ieq(v, "Color") || ru_ieq(v, "Coloropp")) },
+
+    { RUSection::WhiteBalance, "Setting",     RU_SET(
+        if (ru_ieq(v, "Camera")) P.wbMode = RUWBCamera;
+        else if (ru_ieq(v, "Custom")) P.wbMode = RUWBCustom;
+        else if (v.size() >= 4 && ru_ieq(v.substr(0, 4), "auto")) P.wbMode = RUWBAuto) },
+    { RUSection::WhiteBalance, "Temperature", RU_SET(ru_float(v, P.wbTemp)) },
+    { RUSection::WhiteBalance, "Green",       RU_SET(ru_float(v, P.wbGreen)) },
+    { RUSection::WhiteBalance, "Equal",       RU_SET(ru_float(v, P.wbEqual)) },
+
+    { RUSection::Sharpening, "Enabled",            RU_SET(s.sharpEnabled = ru_bool(v)) },
+    { RUSection::Sharpening, "Method",             RU_SET(s.sharpDeconv = ru_ieq(v, "deconv") || ru_ieq(v, "rld")) },
+    { RUSection::Sharpening, "DeconvIterations",   RU_SET(ru_int(v, 0, 100, P.deconvIter)) },
+    { RUSection::Sharpening, "RLDeconvIterations", RU_SET(ru_int(v, 0, 100, P.deconvIter)) },
+    { RUSection::Sharpening, "DeconvAmount",       RU_SET(ru_float(v, P.deconvAmount)) },
+    { RUSection::Sharpening, "DeconvRadius",       RU_SET(ru_float(v, P.deconvRadius)) },
+    { RUSection::Sharpening, "DeconvDamping",      RU_SET(ru_float(v, P.deconvDamping)) },
+    { RUSection::Details,    "RLDeconvIterations", RU_SET(ru_int(v, 0, 100, P.deconvIter)) },
+
+    { RUSection::RAW, "CA",                 RU_SET(P.caAuto = ru_bool(v)) },
+    { RUSection::RAW, "CARed",              RU_SET(ru_float(v, P.caRed)) },
+    { RUSection::RAW, "CABlue",             RU_SET(ru_float(v, P.caBlue)) },
+    { RUSection::RAW, "CAAutoIterations",   RU_SET(ru_int(v, 1, 5, P.caAutoIterations)) },
+    { RUSection::RAW, "CAAvoidColourshift", RU_SET(P.caAvoidColourshift = ru_bool(v)) },
+
+    { RUSection::LuminanceCurve, "Enabled",             RU_SET(s.lumEnabled = ru_bool(v)) },
+    { RUSection::LuminanceCurve, "Chromaticity",        RU_SET(if (ru_float(v, P.chromaticity)) s.chromaSeen = true) },
+    { RUSection::LuminanceCurve, "ChromaticityEnabled", RU_SET(s.chromaOn = ru_bool(v)) },
+
+    { RUSection::ColorAppearance, "Enabled",           RU_SET(s.caEnabled = ru_bool(v)) },
+    { RUSection::ColorAppearance, "C-Chroma",          RU_SET(ru_float(v, P.cChroma)) },
+    { RUSection::ColorAppearance, "CChroma",           RU_SET(ru_float(v, P.cChroma)) },
+    { RUSection::ColorAppearance, "C-ChromaEnabled",   RU_SET(P.cChromaEnabled = ru_bool(v)) },
+    { RUSection::ColorAppearance, "CChromaEnabled",    RU_SET(P.cChromaEnabled = ru_bool(v)) },
+    { RUSection::ColorAppearance, "J-Contrast",        RU_SET(ru_float(v, P.jContrast)) },
+    { RUSection::ColorAppearance, "JContrast",         RU_SET(ru_float(v, P.jContrast)) },
+    { RUSection::ColorAppearance, "J-ContrastEnabled", RU_SET(P.jContrastEnabled = ru_bool(v)) },
+    { RUSection::ColorAppearance, "JContrastEnabled",  RU_SET(P.jContrastEnabled = ru_bool(v)) },
+};
+
+#undef RU_SET
+
+void ru_pp3_line(std::string_view line, RUParseState &st) {
+    line = ru_trim(line);
+    if (line.empty() || line[0] == '#' || line[0] == ';') return;
+    if (line[0] == '[') {
+        const size_t close = line.find(']');
+        const std::string_view name = ru_trim(line.substr(1, close == std::string_view::npos ? std::string_view::npos : close - 1));
+        st.section = RUSection::None;
+        for (const auto &sec : kRUSections)
+            if (sec.name == name) { st.section = sec.id; break; }
+        return;
+    }
+    if (st.section == RUSection::None) return;
+    const size_t eq = line.find('=');
+    if (eq == std::string_view::npos) return;
+    const std::string_view k = ru_trim(line.substr(0, eq)), v = ru_trim(line.substr(eq + 1));
+    for (const RUKey &e : kRUKeys)
+        if (e.section == st.section && e.key == k) { e.set(st, v); return; }
+}
+
+} // namespace
+
+void RU_ParsePP3(const char *text, size_t len, RU_PP3 &P) {
+    if (!text) return;
+    RUParseState st { P };
+    std::string_view rest(text, len);
+    if (rest.substr(0, 3) == "\xEF\xBB\xBF") rest.remove_prefix(3);  // UTF-8 BOM
+    // memchr for '\n' does the bulk of the scan; '\r' (CRLF, or CR-only
+    // files) splits within the line.
+    while (!rest.empty()) {
+        const char *nl = static_cast<const char *>(memchr(rest.data(), '\n', rest.size()));
+        std::string_view line = rest.substr(0, nl ? (size_t)(nl - rest.data()) : rest.size());
+        rest.remove_prefix(nl ? line.size() + 1 : rest.size());
+        for (size_t cr; (cr = line.find('\r')) != std::string_view::npos; line.remove_prefix(cr + 1))
+            ru_pp3_line(line.substr(0, cr), st);
+        ru_pp3_line(line, st);
+    }
+    if (st.chromaSeen)                      P.chromaEnabled = st.lumEnabled && st.chromaOn;
+    if (!st.caEnabled)                      P.cChromaEnabled = P.jContrastEnabled = false;
+    if (!st.sharpEnabled || !st.sharpDeconv) P.deconvIter = 0;
+    if (st.hlSeen)                          P.hlRecovery = st.hlEnabled && st.hlColor;
+}
+
+bool RU_LoadPP3(const char *path, RU_PP3 &P) {
+    if (!path || !*path) return false;
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) { close(fd); return false; }
+    if (st.st_size == 0) { close(fd); return true; }
+    void *map = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+    RU_ParsePP3(static_cast<const char *>(map), (size_t)st.st_size, P);
+    munmap(map, (size_t)st.st_size);
+    return true;
+}
+
+// MARK: - Hash / diff
+
+namespace {
+struct RUFNV1a {
+    uint64_t h = 1469598103934665603ull;
+    void bytes(const void *p, size_t n) {
+        const unsigned char *b = static_cast<const unsigned char *>(p);
+        for (size_t i = 0; i < n; ++i) { h ^= b[i]; h *= 1099511628211ull; }
+    }
+    void f(float v)  { if (v == 0.f) v = 0.f; bytes(&v, sizeof v); }  // +0 == -0
+    void i(int v)    { bytes(&v, sizeof v); }
+    void b(bool v)   { const unsigned char c = v; bytes(&c, 1); }
+};
+}
+
+uint64_t RU_PP3Hash(const RU_PP3 &P, uint32_t stages) {
+    RUFNV1a h;
+    h.i((int)stages);
+    if (stages & RUStageRaw) {
+        h.b(P.hlRecovery);
+        h.b(P.caAuto); h.f(P.caRed); h.f(P.caBlue);
+        h.i(P.caAutoIterations); h.b(P.caAvoidColourshift);
+    }
+    if (stages & RUStageRLD) {
+        h.i(P.deconvIter); h.f(P.deconvAmount); h.f(P.deconvRadius); h.f(P.deconvDamping);
+    }
+    if (stages & RUStageTone) {
+        h.b(P.hasExposure); h.f(P.exposureEV);
+        h.b(P.hasBlack);    h.f(P.black);
+        h.b(P.hasShadows);  h.f(P.shadows);
+    }
+    if (stages & RUStageLab) {
+        h.b(P.chromaEnabled);    h.f(P.chromaticity);
+        h.b(P.cChromaEnabled);   h.f(P.cChroma);
+        h.b(P.jContrastEnabled); h.f(P.jContrast);
+    }
+    return h.h;
+}
+
+uint32_t RU_PP3Diff(const RU_PP3 &a, const RU_PP3 &b) {
+    uint32_t mask = 0;
+    for (uint32_t s : { (uint32_t)RUStageRaw, (uint32_t)RUStageRLD, (uint32_t)RUStageTone, (uint32_t)RUStageLab })
+        if (RU_PP3Hash(a, s) != RU_PP3Hash(b, s)) mask |= s;
+    return mask;
+}
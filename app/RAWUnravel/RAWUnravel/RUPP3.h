@@ -0,0 +1,89 @@
+/*
+    RawUnravel - RUPP3.h
+    -------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Develop settings as the renderers consume them, parsed from RawTherapee
+// .pp3 text. Keys are matched per section ([Exposure], [HLRecovery],
+// [White Balance], [Sharpening], [Details], [RAW], [Luminance Curve],
+// [Color appearance]); anything else is skipped. Pure C++; the Obj-C face is RUDevelopSettings.
+//
+// Stages run in order raw (highlight reconstruction) → RLD → tone → Lab; a
+// change in one invalidates it and everything after it (RU_PP3FirstDirtyStage).
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+enum RUWBMode : uint8_t { RUWBCamera = 0, RUWBAuto = 1, RUWBCustom = 2 };
+
+struct RU_PP3 {
+    bool  hasExposure=false;   float exposureEV=0.f;   // stops
+    bool  hasBlack=false;      float black=0.f;        // 0..1 linear
+    bool  hasShadows=false;    float shadows=0.f;      // -100..+100
+
+    bool  chromaEnabled=false; float chromaticity=0.f; // %
+    bool  cChromaEnabled=false;float cChroma=0.f;      // %
+    bool  jContrastEnabled=false; float jContrast=0.f; // %
+
+    int   deconvIter=0;        float deconvAmount=0.f; float deconvRadius=0.8f; float deconvDamping=0.f;
+
+    bool  hlRecovery=false;    // [HLRecovery] Enabled (Method=Color) or [Exposure] HighlightReconstruction
+    bool  caAuto=false;        float caRed=0.f;        float caBlue=0.f;   // [RAW] CA*
+    int   caAutoIterations=2;  bool  caAvoidColourshift=true;
+
+    // Parsed, not yet applied: renderers use the camera's as-shot WB. Not
+    // part of any stage hash.
+    RUWBMode wbMode=RUWBCamera; float wbTemp=6504.f; float wbGreen=1.f; float wbEqual=1.f;
+};
+
+enum RUStage : uint32_t {
+    RUStageRaw  = 1u << 0,   // CA correction (mosaic), highlight reconstruction (before WB)
+    RUStageRLD  = 1u << 1,   // Deconv*
+    RUStageTone = 1u << 2,   // exposure, black, shadows
+    RUStageLab  = 1u << 3,   // chromaticity, C-chroma, J-contrast
+    RUStageAll  = RUStageRaw | RUStageRLD | RUStageTone | RUStageLab,
+};
+
+static inline bool RU_UserSetExposure(const RU_PP3& P) {
+    // treat tiny EV as "no user exposure", keep auto-normalize on
+    return P.hasExposure && fabsf(P.exposureEV) > 1e-4f;
+}
+static inline bool RU_ShouldSharpen(const RU_PP3& P) {
+    return (P.deconvIter > 0) && (P.deconvAmount > 0.f) && (P.deconvRadius > 0.f);
+}
+
+/// Parses .pp3 text (any line endings) into P without allocating; unknown
+/// sections and keys are ignored. [Sharpening] Enabled=false or a Method
+/// other than deconv zeroes deconvIter.
+void RU_ParsePP3(const char *text, size_t len, RU_PP3 &P);
+
+/// Maps a .pp3 file and parses it. false if it cannot be read.
+bool RU_LoadPP3(const char *path, RU_PP3 &P);
+
+/// FNV-1a over the fields of the given stages (cache keys).
+uint64_t RU_PP3Hash(const RU_PP3 &P, uint32_t stages = RUStageAll);
+
+/// Stages whose fields differ between a and b.
+uint32_t RU_PP3Diff(const RU_PP3 &a, const RU_PP3 &b);
+
+/// Lowest stage in `mask` (RUStageRaw < RLD < Tone < Lab), or 0 if none: the first
+/// stage a render has to redo; upstream results can be reused.
+inline uint32_t RU_PP3FirstDirtyStage(uint32_t mask) { return mask & (~mask + 1u); }
@@ -0,0 +1,129 @@
+/*
+    RawUnravel - RUPack.cpp
+    -----------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RUPack.h"
+#include "RUParallel.h"
+#include "RUToneOps.h"
+#include <cmath>
+#include <memory>
+#include <mutex>
+
+// Normalized output-orientation point → normalized sensor point (inverse of
+// ru_oriented_index below).
+static inline void ru_unorient_point(int exif, float ox, float oy, float &sx, float &sy) {
+    switch (exif) {
+        case 2: sx = 1.f-ox; sy = oy;     break;
+        case 3: sx = 1.f-ox; sy = 1.f-oy; break;
+        case 4: sx = ox;     sy = 1.f-oy; break;
+        case 5: sx = oy;     sy = ox;     break;
+        case 6: sx = oy;     sy = 1.f-ox; break;
+        case 7: sx = 1.f-oy; sy = 1.f-ox; break;
+        case 8: sx = 1.f-oy; sy = ox;     break;
+        default: sx = ox;    sy = oy;     break;
+    }
+}
+
+RURegion RUPackTarget::resolveRegion(int W, int H) {
+    if (format == RGB16 && exif == 3 && H > W) exif = 1;
+    const int e = (format == RGB16) ? exif : 1;
+
+    float ax, ay, bx, by;
+    ru_unorient_point(e, std::clamp(crop[0], 0.f, 1.f), std::clamp(crop[1], 0.f, 1.f), ax, ay);
+    ru_unorient_point(e, std::clamp(crop[2], 0.f, 1.f), std::clamp(crop[3], 0.f, 1.f), bx, by);
+
+    RURegion r;
+    const float eps = 1e-3f; // keep exact pixel edges from rounding outward
+    r.x0 = std::clamp((int)floorf(std::min(ax, bx) * W + eps), 0, W);
+    r.y0 = std::clamp((int)floorf(std::min(ay, by) * H + eps), 0, H);
+    r.x1 = std::clamp((int)ceilf (std::max(ax, bx) * W - eps), r.x0, W);
+    r.y1 = std::clamp((int)ceilf (std::max(ay, by) * H - eps), r.y0, H);
+    if (r.width() <= 0 || r.height() <= 0) r = RURegion{0, 0, W, H};
+    return r;
+}
+
+// Source (x, y) of a W×H frame → pixel index in the EXIF-oriented output.
+static inline size_t ru_oriented_index(int exif, int x, int y, int W, int H) {
+    switch (exif) {
+        case 2: return (size_t)y*W + (W-1-x);               // mirror H
+        case 3: return (size_t)(H-1-y)*W + (W-1-x);         // 180
+        case 4: return (size_t)(H-1-y)*W + x;               // mirror V
+        case 5: return (size_t)x*H + y;                     // transpose
+        case 6: return (size_t)x*H + (H-1-y);               // 90 CW
+        case 7: return (size_t)(W-1-x)*H + (H-1-y);         // transverse
+        case 8: return (size_t)(W-1-x)*H + y;               // 90 CCW
+        default: return (size_t)y*W + x;
+    }
+}
+
+void RU_PackRows(RUPackTarget &out, const float *R, const float *G, const float *B,
+                 size_t stride, int y0, int y1, const uint8_t *F)
+{
+    const int W = out.srcW, H = out.srcH;
+    std::mutex histMerge;
+    RU_ParallelFor(y0, y1, 8, [&](int r0, int r1) {
+        // per-chunk histogram of the values just written, merged once at the end
+        std::unique_ptr<RUHistogram> hist(out.histogram ? new RUHistogram(256) : nullptr);
+        for (int y = r0; y < r1; ++y) {
+            const size_t row = (size_t)(y - y0) * stride;
+            if (out.format == RUPackTarget::BGRA8) {
+                uint8_t *o = out.pixels.get() + (size_t)y * W * 4;
+                if (!out.mask) {
+                    for (int x = 0; x < W; ++x) {
+                        o[x*4+0] = (uint8_t)lrintf(std::clamp(ru_linear_to_srgb(std::clamp(B[row+x],0.f,1.f)),0.f,1.f)*255.f);
+                        o[x*4+1] = (uint8_t)lrintf(std::clamp(ru_linear_to_srgb(std::clamp(G[row+x],0.f,1.f)),0.f,1.f)*255.f);
+                        o[x*4+2] = (uint8_t)lrintf(std::clamp(ru_linear_to_srgb(std::clamp(R[row+x],0.f,1.f)),0.f,1.f)*255.f);
+                        o[x*4+3] = 255;
+                    }
+                } else {
+                    // same pack, plus the tone-clip test on the loaded values
+                    RUClipRowWriter mk(out.mask->row(y), out.mask->bits);
+                    for (int x = 0; x < W; ++x) {
+                        const float r = R[row+x], g = G[row+x], b = B[row+x];
+                        o[x*4+0] = (uint8_t)lrintf(std::clamp(ru_linear_to_srgb(std::clamp(b,0.f,1.f)),0.f,1.f)*255.f);
+                        o[x*4+1] = (uint8_t)lrintf(std::clamp(ru_linear_to_srgb(std::clamp(g,0.f,1.f)),0.f,1.f)*255.f);
+                        o[x*4+2] = (uint8_t)lrintf(std::clamp(ru_linear_to_srgb(std::clamp(r,0.f,1.f)),0.f,1.f)*255.f);
+                        o[x*4+3] = 255;
+                        const uint8_t tone = (r >= 1.f || g >= 1.f || b >= 1.f) ? RUClipTone : 0;
+                        mk.put(x, (uint8_t)((F ? F[row+x] : 0) | tone));
+                    }
+                    mk.finish(W);
+                }
+                if (hist) RU_HistogramAddBGRA8(*hist, o, (size_t)W);
+            } else {
+                uint16_t *o = reinterpret_cast<uint16_t *>(out.pixels.get());
+                auto enc = [&](float v) -> uint16_t {
+                    v = std::clamp(v, 0.f, 1.f);
+                    if (!out.linear) v = std::clamp(ru_linear_to_srgb(v), 0.f, 1.f);
+                    return (uint16_t)lrintf(v * 65535.f);
+                };
+                for (int x = 0; x < W; ++x) {
+                    uint16_t *px = o + 3 * ru_oriented_index(out.exif, x, y, W, H);
+                    px[0] = enc(R[row+x]); px[1] = enc(G[row+x]); px[2] = enc(B[row+x]);
+                    if (hist) RU_HistogramAdd16(*hist, px[0], px[1], px[2]);
+                }
+            }
+        }
+        if (hist) {
+            std::lock_guard<std::mutex> lk(histMerge);
+            out.histogram->merge(*hist);
+        }
+    });
+}
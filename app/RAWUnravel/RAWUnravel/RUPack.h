@@ -0,0 +1,79 @@
+/*
+    RawUnravel - RUPack.h
+    ---------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Pack stage: linear sRGB float rows → the output pixel format, with the
+// display histogram and clipping mask accumulated on the way.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "RUBufferPool.h"
+#include "RUClipMask.h"
+#include "RUHistogram.h"
+
+// Half-open pixel rectangle in sensor orientation.
+struct RURegion {
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    int width()  const { return x1 - x0; }
+    int height() const { return y1 - y0; }
+};
+
+// MARK: - Pack targets
+// Where the banded renderer puts finished rows. BGRA8 is the on-screen format
+// (orientation is applied to the finished image afterwards). RGB16 is the export
+// format: 16-bit host-endian RGB straight from the float planes, sRGB TRC or
+// linear light, with the EXIF orientation baked in while packing.
+//
+// crop is normalized (0..1) in the *output* orientation, i.e. what the user
+// framed; only the matching sensor window (plus filter halos) is developed.
+struct RUPackTarget {
+    enum Format : uint8_t { BGRA8, RGB16 };
+    Format format = BGRA8;
+    bool   linear = false;     // RGB16: no sRGB TRC
+    int    exif   = 1;         // RGB16: EXIF orientation 1..8 (0: the file's, see RU_RenderFullRes)
+    float  crop[4] = {0.f, 0.f, 1.f, 1.f}; // x0, y0, x1, y1
+    int    longEdge = 0;       // > 0: downscale (never up) so the long edge fits
+    int    srcW = 0, srcH = 0; // rendered window, sensor orientation (after scaling)
+    RUPooled<uint8_t> pixels;
+    RUHistogram *histogram = nullptr; // 256-bin display histogram, accumulated while packing
+    RUClipMask  *mask = nullptr;      // BGRA8: clipping flags, srcW×srcH, written while packing
+
+    bool swapsAxes() const { return format == RGB16 && exif >= 5 && exif <= 8; }
+    int  outWidth()  const { return swapsAxes() ? srcH : srcW; }
+    int  outHeight() const { return swapsAxes() ? srcW : srcH; }
+
+    // Sensor window of a W×H frame covered by `crop` (after the exif 3 → 1
+    // portrait rule of RUFixPortraitEXIFIfBaked, which needs the full frame).
+    RURegion resolveRegion(int W, int H);
+
+    bool allocate(int W, int H) {
+        srcW = W; srcH = H;
+        pixels = RUPooled<uint8_t>((size_t)W * H * (format == RGB16 ? 6 : 4));
+        if (mask && (format != BGRA8 || !mask->allocate(W, H, mask->bits))) mask = nullptr;
+        return bool(pixels);
+    }
+};
+
+/// Packs window rows [y0, y1) from linear sRGB planes (row y0 first, `stride`
+/// floats per row, window column 0 at R/G/B + 0). F: optional RUClipFlag bytes
+/// from the WB stage, same layout, merged into out.mask.
+void RU_PackRows(RUPackTarget &out, const float *R, const float *G, const float *B,
+                 size_t stride, int y0, int y1, const uint8_t *F = nullptr);
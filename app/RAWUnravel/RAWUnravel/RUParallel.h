@@ -0,0 +1,66 @@
+/*
+    RawUnravel - RUParallel.h
+    -------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Minimal fork-join over an index range. GCD (dispatch_apply) on Apple,
+// plain std::thread elsewhere. fn(lo, hi) is called on disjoint [lo, hi)
+// chunks of at least `grain` indices; returns when all chunks are done.
+
+#pragma once
+#include <algorithm>
+#include <thread>
+#include <vector>
+#if defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#endif
+
+inline int RU_HardwareThreads() {
+    const unsigned n = std::thread::hardware_concurrency();
+    return n ? (int)n : 1;
+}
+
+template <class Fn>
+inline void RU_ParallelFor(int begin, int end, int grain, Fn &&fn) {
+    const int n = end - begin;
+    if (n <= 0) return;
+    grain = std::max(1, grain);
+    const int chunks = std::min(RU_HardwareThreads() * 4, (n + grain - 1) / grain);
+    if (chunks <= 1) { fn(begin, end); return; }
+    const int step = (n + chunks - 1) / chunks;
+
+#if defined(__APPLE__)
+    auto *f = &fn; // blocks would copy a captured C++ reference
+    dispatch_apply((size_t)chunks, DISPATCH_APPLY_AUTO, ^(size_t c) {
+        const int lo = begin + (int)c * step;
+        const int hi = std::min(end, lo + step);
+        if (lo < hi) (*f)(lo, hi);
+    });
+#else
+    std::vector<std::thread> pool;
+    pool.reserve((size_t)chunks - 1);
+    for (int c = 1; c < chunks; ++c) {
+        const int lo = begin + c * step;
+        const int hi = std::min(end, lo + step);
+        if (lo < hi) pool.emplace_back([&fn, lo, hi] { fn(lo, hi); });
+    }
+    fn(begin, std::min(end, begin + step));
+    for (std::thread &t : pool) t.join();
+#endif
+}
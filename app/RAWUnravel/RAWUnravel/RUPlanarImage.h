@@ -0,0 +1,132 @@
+/*
+    RawUnravel - RUPlanarImage.h
+    ----------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Three linear planes (R, G, B), row-major, tightly packed (stride = width).
+// Storage is borrowed from RUBufferPool and returned when the image dies.
+//
+// Precision policy: Float32 planes live in R/G/B, Float16 planes in
+// R16/G16/B16 (only one set is allocated at a time). Stages do their
+// arithmetic in float either way; convertTo() is the stage-boundary switch.
+// Interactive previews may run bandwidth-bound stages in Float16; export
+// renders stay Float32.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "RUBufferPool.h"
+
+// Half-float storage type. Without compiler support it degrades to float,
+// so Float16 requests still work (at Float32 cost).
+#if defined(__FLT16_MAX__)
+typedef _Float16 ru_half;
+#define RU_HAVE_HALF 1
+#elif defined(__aarch64__)
+typedef __fp16 ru_half;
+#define RU_HAVE_HALF 1
+#else
+typedef float ru_half;
+#define RU_HAVE_HALF 0
+#endif
+
+// Half conversions in hardware (ARM FP16, x86 F16C / AVX512-FP16). Elsewhere
+// _Float16 is converted in software and costs more than the bandwidth it saves.
+#if RU_HAVE_HALF && (defined(__aarch64__) || defined(__ARM_FP16_FORMAT_IEEE) || \
+                     defined(__F16C__) || defined(__AVX512FP16__))
+#define RU_NATIVE_HALF 1
+#else
+#define RU_NATIVE_HALF 0
+#endif
+
+enum class RUPrecision : uint8_t { Float32, Float16 };
+
+struct RUPlanarImage {
+    int width  = 0;
+    int height = 0;
+    RUPrecision precision = RUPrecision::Float32;
+    RUPooled<float>   R, G, B;        // Float32 storage
+    RUPooled<ru_half> R16, G16, B16;  // Float16 storage
+
+    std::size_t pixels() const { return (std::size_t)width * (std::size_t)height; }
+    explicit operator bool() const {
+        return precision == RUPrecision::Float32 ? (R && G && B) : (R16 && G16 && B16);
+    }
+
+    /// (Re)allocates all three planes at `p`; contents are uninitialized.
+    bool allocate(int w, int h, RUPrecision p = RUPrecision::Float32) {
+        reset();
+        width = w; height = h; precision = p;
+        const std::size_t n = pixels();
+        if (p == RUPrecision::Float32) { R = RUPooled<float>(n); G = RUPooled<float>(n); B = RUPooled<float>(n); }
+        else { R16 = RUPooled<ru_half>(n); G16 = RUPooled<ru_half>(n); B16 = RUPooled<ru_half>(n); }
+        if (!*this) { reset(); return false; }
+        return true;
+    }
+
+    /// Converts storage to `p` (no-op if already there). The old planes are
+    /// released once all three new ones exist; on allocation failure the image
+    /// is left unchanged and false is returned.
+    bool convertTo(RUPrecision p) {
+        if (!*this) return false;
+        if (p == precision) return true;
+        if (p == RUPrecision::Float16) {
+            if (!convertPlanes(R, G, B, R16, G16, B16)) return false;
+        } else {
+            if (!convertPlanes(R16, G16, B16, R, G, B)) return false;
+        }
+        precision = p;
+        return true;
+    }
+
+    /// Deep copy of `src` (same size and precision). false on allocation failure.
+    bool copyFrom(const RUPlanarImage &src) {
+        if (!src || !allocate(src.width, src.height, src.precision)) return false;
+        const std::size_t bytes = pixels() * (precision == RUPrecision::Float32 ? sizeof(float) : sizeof(ru_half));
+        if (precision == RUPrecision::Float32) {
+            std::memcpy(R.get(), src.R.get(), bytes); std::memcpy(G.get(), src.G.get(), bytes); std::memcpy(B.get(), src.B.get(), bytes);
+        } else {
+            std::memcpy(R16.get(), src.R16.get(), bytes); std::memcpy(G16.get(), src.G16.get(), bytes); std::memcpy(B16.get(), src.B16.get(), bytes);
+        }
+        return true;
+    }
+
+    void reset() {
+        R.reset(); G.reset(); B.reset();
+        R16.reset(); G16.reset(); B16.reset();
+        width = height = 0; precision = RUPrecision::Float32;
+    }
+
+private:
+    template <class A, class Z>
+    bool convertPlanes(RUPooled<A> &r, RUPooled<A> &g, RUPooled<A> &b,
+                       RUPooled<Z> &ro, RUPooled<Z> &go, RUPooled<Z> &bo) {
+        const std::size_t n = pixels();
+        RUPooled<Z> nr(n), ng(n), nb(n);
+        if (!nr || !ng || !nb) return false;
+        const A *src[3] = { r.get(), g.get(), b.get() };
+        Z       *dst[3] = { nr.get(), ng.get(), nb.get() };
+        for (int c = 0; c < 3; ++c)
+            for (std::size_t i = 0; i < n; ++i) dst[c][i] = (Z)src[c][i];
+        r.reset(); g.reset(); b.reset();
+        ro = std::move(nr); go = std::move(ng); bo = std::move(nb);
+        return true;
+    }
+};
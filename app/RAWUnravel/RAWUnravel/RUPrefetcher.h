@@ -0,0 +1,61 @@
+/*
+    RawUnravel - RUPrefetcher.h
+    ---------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Warms the file the user is likely to open next. While the file screen shows
+// a RAW, a utility-QoS queue probes it, fills its thumbnail entry and runs the
+// same half-size decode the develop screen starts with. The decode leaves its
+// planes in the file's render session, so the first preview and the slider
+// renders after it start warm; the preview image itself is held for
+// takePreview(forPath:). Only one file is warmed at a time: prefetching a new
+// path cancels the previous decode at its next stage boundary.
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface RUPrefetcher : NSObject
+
+@property (class, nonatomic, readonly) RUPrefetcher *shared;
+
+/// Upper bound for a warm decode (bin-2 planes + preview) and for the previews
+/// held at once. 0 (default) selects 1/16 of physical memory.
+@property (atomic) NSUInteger memoryBudgetBytes;
+
+/// Starts warming `path` unless it is already warm or in flight.
+- (void)prefetchPath:(NSString *)path
+NS_SWIFT_NAME(prefetch(path:));
+
+/// Stops warming `path` and drops what was kept for it.
+- (void)cancelPath:(NSString *)path
+NS_SWIFT_NAME(cancel(path:));
+
+/// Preview decoded for `path` (as decodeRAWPreview(atPath:settings:nil,
+/// binFactor:2)), waiting for a decode in flight. The image is handed over
+/// once. nil if the path was not prefetched or the decode was skipped.
+/// Blocking; call off the main thread. A decode in flight is raised to the
+/// caller's QoS while it waits.
+- (nullable UIImage *)takePreviewForPath:(NSString *)path
+NS_SWIFT_NAME(takePreview(forPath:));
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,201 @@
+/*
+    RawUnravel - RUPrefetcher.mm
+    ----------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#import "RUPrefetcher.h"
+#import "RTPreviewDecoder.h"
+#import "RUThumbnailStore.h"
+
+// Bytes per sensor pixel of a half-size decode: three float planes at 1/4 the
+// pixel count (the session's base stage) plus the BGRA preview.
+static constexpr double kRUPrefetchBytesPerPixel = 3 * 4 / 4.0 + 4 / 4.0;
+
+// MARK: - Job
+
+@interface RUPrefetchJob : NSObject
+@property (nonatomic, copy)   NSString *path;
+@property (nonatomic, copy)   NSString *jobID;
+@property (nonatomic, strong) dispatch_group_t group;   // left when the job is done
+@property (nonatomic, strong, nullable) UIImage *preview;
+@property (nonatomic) NSUInteger cost;                   // bytes held by `preview`
+@property (atomic) BOOL cancelled;            // read by the running job without the lock
+@property (nonatomic) BOOL done;
+@end
+
+@implementation RUPrefetchJob
+@end
+
+// MARK: - Prefetcher
+
+@implementation RUPrefetcher {
+    dispatch_queue_t _queue;
+    NSMutableDictionary<NSString *, RUPrefetchJob *> *_jobs;   // by path; @synchronized(self)
+    NSMutableArray<RUPrefetchJob *> *_held;                     // finished with a preview, oldest first
+}
+
++ (RUPrefetcher *)shared {
+    static RUPrefetcher *s;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{ s = [RUPrefetcher new]; });
+    return s;
+}
+
+- (instancetype)init {
+    if ((self = [super init])) {
+        _queue = dispatch_queue_create("rawunravel.prefetch",
+                                       dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0));
+        _jobs = [NSMutableDictionary dictionary];
+        _held = [NSMutableArray array];
+        __weak RUPrefetcher *weakSelf = self;
+        [[NSNotificationCenter defaultCenter] addObserverForName:UIApplicationDidReceiveMemoryWarningNotification
+                                                          object:nil queue:nil usingBlock:^(NSNotification *) {
+            [weakSelf dropAll];
+        }];
+    }
+    return self;
+}
+
+- (NSUInteger)budget {
+    const NSUInteger b = self.memoryBudgetBytes;
+    return b ? b : (NSUInteger)(NSProcessInfo.processInfo.physicalMemory / 16);
+}
+
+// Caller holds @synchronized(self).
+- (void)cancelJob:(RUPrefetchJob *)job {
+    job.cancelled = YES;
+    if (!job.done) [RTPreviewDecoder cancelJob:job.jobID];
+    [_held removeObject:job];
+    [_jobs removeObjectForKey:job.path];
+}
+
+- (void)dropAll {
+    @synchronized (self) {
+        for (RUPrefetchJob *job in _jobs.allValues) [self cancelJob:job];
+    }
+}
+
+// Oldest held previews go first; `keep` is never evicted. Returns the evicted
+// paths, whose sessions the caller ends outside the lock. Caller holds @synchronized(self).
+- (NSArray<NSString *> *)trimKeeping:(RUPrefetchJob *)keep {
+    NSMutableArray<NSString *> *evicted = [NSMutableArray array];
+    NSUInteger total = 0;
+    for (RUPrefetchJob *j in _held) total += j.cost;
+    const NSUInteger budget = [self budget];
+    for (NSUInteger i = 0; total > budget && i < _held.count; ) {
+        RUPrefetchJob *j = _held[i];
+        if (j == keep) { ++i; continue; }
+        total -= j.cost;
+        [_held removeObjectAtIndex:i];
+        [_jobs removeObjectForKey:j.path];
+        [evicted addObject:j.path];
+    }
+    return evicted;
+}
+
+- (void)prefetchPath:(NSString *)path {
+    if (!path.length) return;
+    RUPrefetchJob *job = [RUPrefetchJob new];
+    @synchronized (self) {
+        if (_jobs[path]) return;
+        // only the likely-next file is worth the CPU; stop warming the others
+        for (RUPrefetchJob *other in _jobs.allValues)
+            if (!other.done) [self cancelJob:other];
+        job.path  = path;
+        job.jobID = [@"prefetch-" stringByAppendingString:NSUUID.UUID.UUIDString];
+        job.group = dispatch_group_create();
+        _jobs[path] = job;
+    }
+    dispatch_group_enter(job.group);
+    dispatch_async(_queue, ^{
+        @autoreleasepool { [self runJob:job]; }
+        dispatch_group_leave(job.group);
+    });
+}
+
+- (void)runJob:(RUPrefetchJob *)job {
+    NSString *path = job.path;
+    if (job.cancelled) return;
+
+    // ---- probe + thumbnail / metadata entry ----
+    const CGSize active = [RTPreviewDecoder rawActiveSizeAtPath:path];
+    [RUThumbnailStore.shared loadEntryForURL:[NSURL fileURLWithPath:path]];
+    const NSUInteger cost = (NSUInteger)(active.width * active.height * kRUPrefetchBytesPerPixel);
+    if (job.cancelled || cost == 0 || cost > [self budget]) {
+        @synchronized (self) { job.done = YES; }
+        return;
+    }
+
+    // ---- warm decode: same settings as DevelopScreen's first render ----
+    UIImage *ui = [RTPreviewDecoder decodeRAWPreviewAtPath:path settings:nil binFactor:2 jobID:job.jobID];
+    BOOL orphaned = NO;
+    NSArray<NSString *> *evicted = nil;
+    @synchronized (self) {
+        job.done = YES;
+        if (job.cancelled || !ui) {
+            orphaned = job.cancelled && !_jobs[path];
+        } else {
+            job.preview = ui;
+            job.cost    = cost;
+            [_held addObject:job];
+            evicted = [self trimKeeping:job];
+        }
+    }
+    // cancelled part way: the stages built so far are of no use to anyone
+    if (orphaned) [RTPreviewDecoder endSessionForPath:path];
+    // evicted previews: their warm planes go with them
+    for (NSString *p in evicted) [RTPreviewDecoder endSessionForPath:p];
+}
+
+- (void)cancelPath:(NSString *)path {
+    BOOL drop = NO;
+    @synchronized (self) {
+        RUPrefetchJob *job = _jobs[path];
+        if (!job) return;
+        drop = job.done;
+        [self cancelJob:job];
+    }
+    // a finished warm decode left planes in the session; nobody is going to use them
+    if (drop) [RTPreviewDecoder endSessionForPath:path];
+}
+
+- (nullable UIImage *)takePreviewForPath:(NSString *)path {
+    RUPrefetchJob *job;
+    BOOL running;
+    @synchronized (self) {
+        job = _jobs[path];
+        running = job && !job.done;
+    }
+    if (!job) return nil;
+    if (running) {
+        // A group wait donates no priority: queue an empty block at the caller's
+        // QoS behind the job so the serial queue runs the job at that QoS too.
+        dispatch_async(_queue, dispatch_block_create_with_qos_class(DISPATCH_BLOCK_ENFORCE_QOS_CLASS,
+                                                                    qos_class_self(), 0, ^{}));
+    }
+    dispatch_group_wait(job.group, DISPATCH_TIME_FOREVER);
+    @synchronized (self) {
+        if (_jobs[path] != job) return nil;   // cancelled or evicted meanwhile
+        [_held removeObject:job];
+        [_jobs removeObjectForKey:path];
+    }
+    return job.preview;
+}
+
+@end
@@ -0,0 +1,119 @@
+/*
+    RawUnravel - RUProgress.cpp
+    ---------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RUProgress.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// MARK: - Names
+// id 0 is ""; ids are never reused, so a word read back always names the
+// strings it was written with.
+
+namespace {
+constexpr int kRU_MaxNames = 256;
+std::atomic<const char *> gRU_Names[kRU_MaxNames] = { {""} };
+std::atomic<int>          gRU_NameCount { 1 };
+std::mutex                gRU_NamesWrite;
+
+uint64_t ru_name_id(const char *name) {
+    if (!name || !*name) return 0;
+    const int n = gRU_NameCount.load(std::memory_order_acquire);
+    for (int i = 1; i < n; ++i)
+        if (!strcmp(gRU_Names[i].load(std::memory_order_relaxed), name)) return (uint64_t)i;
+
+    std::lock_guard<std::mutex> lk(gRU_NamesWrite);
+    const int m = gRU_NameCount.load(std::memory_order_relaxed);
+    for (int i = n; i < m; ++i)   // added since the scan above
+        if (!strcmp(gRU_Names[i].load(std::memory_order_relaxed), name)) return (uint64_t)i;
+    if (m == kRU_MaxNames) return 0;
+    gRU_Names[m].store(strdup(name), std::memory_order_relaxed);   // interned for good
+    gRU_NameCount.store(m + 1, std::memory_order_release);
+    return (uint64_t)m;
+}
+
+const char *ru_name(uint64_t id) {
+    const char *s = gRU_Names[id & 0xFF].load(std::memory_order_relaxed);
+    return s ? s : "";
+}
+
+uint64_t ru_count(int v) { return (uint64_t)std::min(std::max(v, 0), 0xFFFFFF); }
+}
+
+// MARK: - Record
+
+bool RUProgressRecord::update(const char *phase, const char *step, int iter, int total) {
+    const uint64_t w = ru_name_id(phase) << 56 | ru_name_id(step) << 48 | ru_count(iter) << 24 | ru_count(total);
+    const uint64_t prev = word_.exchange(w, std::memory_order_acq_rel);
+    return (prev >> 48) != (w >> 48);
+}
+
+RUProgressSample RUProgressRecord::sample() const {
+    const uint64_t w = word_.load(std::memory_order_acquire);
+    RUProgressSample s;
+    s.phase = ru_name(w >> 56);
+    s.step  = ru_name(w >> 48);
+    s.iter  = (int)(w >> 24 & 0xFFFFFF);
+    s.total = (int)(w & 0xFFFFFF);
+    return s;
+}
+
+// MARK: - Registry
+// Copy-on-write map like the session registry: lookups read a snapshot,
+// creating a record copies the map.
+
+namespace {
+using RUProgressMap = std::unordered_map<std::string, std::shared_ptr<RUProgressRecord>>;
+
+constexpr size_t kRU_MaxJobs = 256;
+
+std::shared_ptr<const RUProgressMap> gRU_Progress = std::make_shared<RUProgressMap>();
+std::mutex                           gRU_ProgressWrite;   // serializes copy-on-write updates
+std::deque<std::string>              gRU_ProgressOrder;   // creation order (guarded by gRU_ProgressWrite)
+}
+
+std::shared_ptr<RUProgressRecord> RU_FindProgress(const char *jobID) {
+    if (!jobID) return nullptr;
+    const auto snap = std::atomic_load(&gRU_Progress);
+    const auto it = snap->find(jobID);
+    return it != snap->end() ? it->second : nullptr;
+}
+
+std::shared_ptr<RUProgressRecord> RU_ProgressForJob(const char *jobID) {
+    if (!jobID) jobID = "";
+    if (auto r = RU_FindProgress(jobID)) return r;
+
+    std::lock_guard<std::mutex> lk(gRU_ProgressWrite);
+    if (auto r = RU_FindProgress(jobID)) return r;   // raced with another creator
+    auto next = std::make_shared<RUProgressMap>(*std::atomic_load(&gRU_Progress));
+    while (next->size() >= kRU_MaxJobs && !gRU_ProgressOrder.empty()) {
+        next->erase(gRU_ProgressOrder.front());
+        gRU_ProgressOrder.pop_front();
+    }
+    auto r = std::make_shared<RUProgressRecord>();
+    (*next)[jobID] = r;
+    gRU_ProgressOrder.emplace_back(jobID);
+    std::atomic_store(&gRU_Progress, std::shared_ptr<const RUProgressMap>(std::move(next)));
+    return r;
+}
@@ -0,0 +1,58 @@
+/*
+    RawUnravel - RUProgress.h
+    -------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Per-job progress channel. Workers store their latest phase/step/iter/total
+// in the job's record (one atomic word, no allocation); the UI samples the
+// record at display rate. update() reports phase/step transitions, the only
+// events worth a notification.
+//
+// Phase and step names are interned once (at most 255 distinct names; later
+// ones read back as ""). iter and total saturate at 2^24 - 1.
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+struct RUProgressSample {
+    const char *phase = "";
+    const char *step  = "";
+    int iter  = 0;
+    int total = 0;
+};
+
+class RUProgressRecord {
+public:
+    /// Stores the job's latest progress. True if phase or step differ from
+    /// the previous update (exactly one of several racing writers sees it).
+    bool update(const char *phase, const char *step, int iter, int total);
+    /// Latest progress; all four fields come from the same update.
+    RUProgressSample sample() const;
+
+private:
+    std::atomic<uint64_t> word_ { 0 };   // phase:8 step:8 iter:24 total:24
+};
+
+/// Record of `jobID`, created on first use. The registry keeps the most
+/// recent 256 jobs; older records live on only while someone holds them.
+std::shared_ptr<RUProgressRecord> RU_ProgressForJob(const char *jobID);
+/// Record of `jobID` if one exists (never creates; lock-free).
+std::shared_ptr<RUProgressRecord> RU_FindProgress(const char *jobID);
@@ -0,0 +1,165 @@
+/*
+    RawUnravel - RURLD.cpp
+    ----------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RURLD.h"
+#include "RUParallel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// MARK: - Box / Gaussian blur
+// Horizontal: running sum along each row. Vertical: running sums for a strip
+// of columns at once, walking down the rows (cache-friendly, same arithmetic
+// as a per-column walk). Edges clamp.
+
+template <class S>
+static void ru_box_rows(S *dst, const S *src, int W, int H, int r) {
+    const float invWin = 1.f / (2*r+1);
+    RU_ParallelFor(0, H, 32, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            const S *s = src + (size_t)y*W;
+            S *d = dst + (size_t)y*W;
+            float acc = 0.f;
+            for (int k=-r; k<=r; ++k) acc += (float)s[k<0?0:(k>=W?W-1:k)];
+            for (int x=0; x<W; ++x) {
+                d[x] = (S)(acc * invWin);
+                int x_add = x+r+1; if (x_add>=W) x_add = W-1;
+                int x_sub = x-r;   if (x_sub<0)  x_sub = 0;
+                acc += (float)s[x_add] - (float)s[x_sub];
+            }
+        }
+    });
+}
+
+template <class S>
+static void ru_box_cols(S *dst, const S *src, int W, int H, int r) {
+    const float invWin = 1.f / (2*r+1);
+    RU_ParallelFor(0, W, 256, [&](int x0, int x1) {
+        const int n = x1 - x0;
+        std::vector<float> acc((size_t)n, 0.f);
+        for (int k=-r; k<=r; ++k) {
+            const S *s = src + (size_t)(k<0?0:(k>=H?H-1:k))*W + x0;
+            for (int i=0; i<n; ++i) acc[i] += (float)s[i];
+        }
+        for (int y=0; y<H; ++y) {
+            S *d = dst + (size_t)y*W + x0;
+            int y_add = y+r+1; if (y_add>=H) y_add = H-1;
+            int y_sub = y-r;   if (y_sub<0)  y_sub = 0;
+            const S *a = src + (size_t)y_add*W + x0;
+            const S *b = src + (size_t)y_sub*W + x0;
+            for (int i=0; i<n; ++i) {
+                d[i] = (S)(acc[i] * invWin);
+                acc[i] += (float)a[i] - (float)b[i];
+            }
+        }
+    });
+}
+
+template <class S>
+void RU_GaussBlur(S *buf, S *tmp, int W, int H, float radius) {
+    if (radius <= 0.05f || W <= 0 || H <= 0) return;
+    const int r = (int)std::lrint(std::max(1.f, radius));
+    for (int pass = 0; pass < 3; ++pass) {
+        ru_box_rows(tmp, buf, W, H, r);
+        ru_box_cols(buf, tmp, W, H, r);
+    }
+}
+
+// MARK: - RLD
+
+template <class S>
+void RU_RLDLuma(S *R, S *G, S *B, int W, int H, const RURLDParams &p, const RURLDProgress &progress)
+{
+    if (p.iterations <= 0 || p.amountPct <= 0.f || p.radius <= 0.05f || W <= 0 || H <= 0) return;
+
+    const size_t N = (size_t)W*H;
+    RUPooled<S> Y(N), E(N), tmp(N), buf(N);
+    if (!Y || !E || !tmp || !buf) return;
+
+    const float eps  = 1e-6f;
+    const float damp = std::clamp(p.dampingPct/100.f, 0.f, 0.99f);
+    const float rMin = 1.f - damp, rMax = 1.f + damp;
+    const float kAmt = std::min(2.f, p.amountPct/100.f); // 0..2
+    // Values over 1 are image data when highlights were reconstructed (WB
+    // keepOver), so only negatives are clipped; the ceiling keeps FP16 finite.
+    const float top  = kRU_RLDMaxValue;
+
+    // per-pixel passes, split by rows
+    auto rows = [&](auto &&fn) {
+        RU_ParallelFor(0, H, 32, [&](int y0, int y1) {
+            for (size_t i = (size_t)y0*W, e = (size_t)y1*W; i < e; ++i) fn(i);
+        });
+    };
+
+    // initial luminance (linear)
+    rows([&](size_t i) {
+        const float y = std::clamp(0.2126f*(float)R[i] + 0.7152f*(float)G[i] + 0.0722f*(float)B[i], 0.f, top);
+        Y[i] = (S)y; E[i] = (S)y;
+    });
+
+    for (int t=0; t<p.iterations; ++t) {
+        // blurred = PSF * E
+        std::memcpy(buf.get(), E.get(), N*sizeof(S));
+        RU_GaussBlur(buf.get(), tmp.get(), W, H, p.radius);
+
+        // ratio = Y / blurred (damped)
+        rows([&](size_t i) {
+            float ratio = (float)Y[i] / ((float)buf[i] + eps);
+            if (damp>0.f) ratio = std::clamp(ratio, rMin, rMax);
+            tmp[i] = (S)ratio;
+        });
+
+        // correction = PSF^T * ratio (PSF symmetric)
+        std::memcpy(buf.get(), tmp.get(), N*sizeof(S));
+        RU_GaussBlur(buf.get(), tmp.get(), W, H, p.radius);
+
+        // E *= correction
+        rows([&](size_t i) { E[i] = (S)std::clamp((float)E[i] * (float)buf[i], 0.f, top); });
+
+        if (progress) progress(t+1, p.iterations);
+    }
+
+    // reinject sharpened luma via gain = E/Y (blend by amount)
+    rows([&](size_t i) {
+        float gain = (float)E[i] / ((float)Y[i] + eps);
+        gain = 1.f + (gain - 1.f) * kAmt;
+        R[i] = (S)std::clamp((float)R[i]*gain, 0.f, top);
+        G[i] = (S)std::clamp((float)G[i]*gain, 0.f, top);
+        B[i] = (S)std::clamp((float)B[i]*gain, 0.f, top);
+    });
+}
+
+void RU_RLDLuma(RUPlanarImage &img, const RURLDParams &p, const RURLDProgress &progress)
+{
+    if (!img) return;
+    if (img.precision == RUPrecision::Float16)
+        RU_RLDLuma(img.R16.get(), img.G16.get(), img.B16.get(), img.width, img.height, p, progress);
+    else
+        RU_RLDLuma(img.R.get(), img.G.get(), img.B.get(), img.width, img.height, p, progress);
+}
+
+template void RU_GaussBlur<float>(float *, float *, int, int, float);
+template void RU_RLDLuma<float>(float *, float *, float *, int, int, const RURLDParams &, const RURLDProgress &);
+#if RU_HAVE_HALF
+template void RU_GaussBlur<ru_half>(ru_half *, ru_half *, int, int, float);
+template void RU_RLDLuma<ru_half>(ru_half *, ru_half *, ru_half *, int, int, const RURLDParams &, const RURLDProgress &);
+#endif
@@ -0,0 +1,62 @@
+/*
+    RawUnravel - RURLD.h
+    --------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Richardson–Lucy deconvolution on linear luminance: PSF ≈ Gaussian built
+// from three box passes, damped ratio, and the sharpened luma reinjected into
+// R/G/B as a gain blended by `amountPct`.
+//
+// Templated on plane storage (float or ru_half); arithmetic is always float,
+// and the Y/E/scratch planes use the same storage type as the image.
+
+#pragma once
+#include <cmath>
+#include <functional>
+#include "RUPlanarImage.h"
+
+/// Ceiling of the planes RLD writes. Input may exceed 1.0 (reconstructed
+/// highlights); those values pass through sharpened instead of clipped.
+constexpr float kRU_RLDMaxValue = 64.f;
+
+struct RURLDParams {
+    int   iterations = 0;
+    float radius     = 0.f;   // PSF radius in pixels (box radius = round(max(1, radius)))
+    float amountPct  = 0.f;   // 0..200
+    float dampingPct = 0.f;   // ratio clamp ±damping, 0..99
+};
+
+/// Called after each iteration (1-based) from the calling thread.
+using RURLDProgress = std::function<void(int iter, int total)>;
+
+/// In-place 3-pass box approximation of a Gaussian; `tmp` is W×H scratch.
+template <class S>
+void RU_GaussBlur(S *buf, S *tmp, int W, int H, float radius);
+
+/// Rows above/below a pixel that its RLD output depends on (banded rendering).
+inline int RU_RLDHaloRows(int iterations, float radius) {
+    return iterations * 6 * (int)std::lrint(radius < 1.f ? 1.f : radius);
+}
+
+template <class S>
+void RU_RLDLuma(S *R, S *G, S *B, int W, int H, const RURLDParams &p,
+                const RURLDProgress &progress = {});
+
+/// Runs at the image's current precision.
+void RU_RLDLuma(RUPlanarImage &img, const RURLDParams &p, const RURLDProgress &progress = {});
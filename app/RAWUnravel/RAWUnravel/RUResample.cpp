@@ -0,0 +1,129 @@
+/*
+    RawUnravel - RUResample.cpp
+    ---------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RUResample.h"
+#include "RUBufferPool.h"
+#include "RUParallel.h"
+#include <algorithm>
+#include <cmath>
+
+// MARK: - Kernel
+
+static constexpr double kRU_LanczosA = 3.0;
+
+static inline double ru_sinc(double x) {
+    if (x == 0.0) return 1.0;
+    x *= 3.14159265358979323846;
+    return std::sin(x) / x;
+}
+
+static inline double ru_lanczos3(double x) {
+    x = std::fabs(x);
+    return x < kRU_LanczosA ? ru_sinc(x) * ru_sinc(x / kRU_LanczosA) : 0.0;
+}
+
+bool RU_LanczosTaps(int dstN, double origin, double step, int lo, int hi, RUResampleTaps &t) {
+    if (dstN <= 0 || hi <= lo || !(step > 0.0)) return false;
+    const double stretch = std::max(1.0, step);      // widen when downscaling
+    const double support = kRU_LanczosA * stretch;
+
+    t.dstN = dstN;
+    t.first.assign((size_t)dstN, 0);
+    t.count.assign((size_t)dstN, 0);
+    t.offset.assign((size_t)dstN, 0);
+    t.w.clear();
+    t.w.reserve((size_t)dstN * (size_t)(2 * support + 2));
+
+    std::vector<double> acc;
+    for (int i = 0; i < dstN; ++i) {
+        const double c = origin + (i + 0.5) * step - 0.5;
+        const int a = (int)std::floor(c - support) + 1;
+        const int b = (int)std::ceil (c + support) - 1;
+        const int f = std::clamp(a, lo, hi - 1);
+        const int l = std::clamp(b, lo, hi - 1);
+        acc.assign((size_t)(l - f + 1), 0.0);
+        double sum = 0.0;
+        for (int k = a; k <= b; ++k) {
+            const double wk = ru_lanczos3((k - c) / stretch);
+            acc[(size_t)(std::clamp(k, lo, hi - 1) - f)] += wk;
+            sum += wk;
+        }
+        const double inv = (sum != 0.0) ? 1.0 / sum : 0.0;
+        t.first[(size_t)i]  = f;
+        t.count[(size_t)i]  = l - f + 1;
+        t.offset[(size_t)i] = t.w.size();
+        for (double v : acc) t.w.push_back((float)(v * inv));
+    }
+    return true;
+}
+
+// MARK: - Passes
+
+void RU_ResampleH(const float *src, size_t srcStride, int rows,
+                  const RUResampleTaps &t, float *dst, size_t dstStride) {
+    RU_ParallelFor(0, rows, 8, [&](int r0, int r1) {
+        for (int y = r0; y < r1; ++y) {
+            const float *s = src + (size_t)y * srcStride;
+            float *d = dst + (size_t)y * dstStride;
+            for (int i = 0; i < t.dstN; ++i) {
+                const float *sp = s + t.first[(size_t)i];
+                const float *wp = t.w.data() + t.offset[(size_t)i];
+                const int n = t.count[(size_t)i];
+                float v = 0.f;
+                for (int k = 0; k < n; ++k) v += wp[k] * sp[k];
+                d[i] = v;
+            }
+        }
+    });
+}
+
+void RU_ResampleV(const float *src, size_t srcStride, int width,
+                  const RUResampleTaps &t, float *dst, size_t dstStride) {
+    RU_ParallelFor(0, t.dstN, 4, [&](int i0, int i1) {
+        for (int i = i0; i < i1; ++i) {
+            float *__restrict d = dst + (size_t)i * dstStride;
+            const float *wp = t.w.data() + t.offset[(size_t)i];
+            const int n = t.count[(size_t)i];
+            const float *s0 = src + (size_t)t.first[(size_t)i] * srcStride;
+            {
+                const float w0 = wp[0];
+                for (int x = 0; x < width; ++x) d[x] = w0 * s0[x];
+            }
+            for (int k = 1; k < n; ++k) {
+                const float *__restrict s = s0 + (size_t)k * srcStride;
+                const float wk = wp[k];
+                for (int x = 0; x < width; ++x) d[x] += wk * s[x];
+            }
+        }
+    });
+}
+
+bool RU_ResamplePlane(const float *src, int sw, int sh, float *dst, int dw, int dh) {
+    if (!src || !dst || sw <= 0 || sh <= 0 || dw <= 0 || dh <= 0) return false;
+    RUResampleTaps th, tv;
+    if (!RU_LanczosTaps(dw, 0.0, (double)sw / dw, 0, sw, th)) return false;
+    if (!RU_LanczosTaps(dh, 0.0, (double)sh / dh, 0, sh, tv)) return false;
+    RUPooled<float> tmp((size_t)dw * sh);
+    if (!tmp) return false;
+    RU_ResampleH(src, (size_t)sw, sh, th, tmp.get(), (size_t)dw);
+    RU_ResampleV(tmp.get(), (size_t)dw, dw, tv, dst, (size_t)dw);
+    return true;
+}
@@ -0,0 +1,57 @@
+/*
+    RawUnravel - RUResample.h
+    -------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Separable Lanczos-3 resampling of float planes. Meant for linear-light data
+// (right after demosaic), where averaging is physically meaningful; negative
+// lobes are kept, clamping is the packer's job.
+//
+// Coordinates follow pixel centres: destination i samples source position
+// origin + (i + 0.5) * step - 0.5. When downscaling (step > 1) the kernel is
+// stretched by `step` so it also acts as the anti-alias filter.
+
+#pragma once
+#include <cstddef>
+#include <vector>
+
+struct RUResampleTaps {
+    int dstN = 0;
+    std::vector<int>   first;   // per destination: first source index
+    std::vector<int>   count;   // per destination: taps used
+    std::vector<size_t> offset; // per destination: start in `w`
+    std::vector<float> w;       // weights, normalized to sum 1 per destination
+};
+
+/// Builds taps for `dstN` outputs. Source indices are clamped to [lo, hi)
+/// (edge replication: out-of-range weight lands on the border sample).
+bool RU_LanczosTaps(int dstN, double origin, double step, int lo, int hi, RUResampleTaps &t);
+
+/// Horizontal pass: each of `rows` rows of `src` (stride `srcStride`) is
+/// resampled into t.dstN samples of `dst` (stride `dstStride`). Multithreaded.
+void RU_ResampleH(const float *src, size_t srcStride, int rows,
+                  const RUResampleTaps &t, float *dst, size_t dstStride);
+
+/// Vertical pass: output row i = Σ w · src row (first + k), `width` samples per
+/// row. Inner loop runs over contiguous x (vectorizes). Multithreaded.
+void RU_ResampleV(const float *src, size_t srcStride, int width,
+                  const RUResampleTaps &t, float *dst, size_t dstStride);
+
+/// Whole plane sw×sh → dw×dh (H pass into scratch, then V pass).
+bool RU_ResamplePlane(const float *src, int sw, int sh, float *dst, int dw, int dh);
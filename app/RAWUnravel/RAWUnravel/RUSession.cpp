@@ -0,0 +1,188 @@
+/*
+    RawUnravel - RUSession.cpp
+    --------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RUSession.h"
+#include <cmath>
+#include <deque>
+#include <unordered_map>
+#include <sys/stat.h>
+
+// MARK: - Session
+
+float RUSession::stickyEV(float candidate) {
+    float cur = stickyEV_.load(std::memory_order_acquire);
+    if (!std::isnan(cur)) return cur;
+    if (stickyEV_.compare_exchange_strong(cur, candidate, std::memory_order_acq_rel)) return candidate;
+    return cur;  // another render got there first
+}
+
+bool RUSession::hasStickyEV(float &ev) const {
+    const float cur = stickyEV_.load(std::memory_order_acquire);
+    if (std::isnan(cur)) return false;
+    ev = cur;
+    return true;
+}
+
+bool RUSession::rawSize(int &w, int &h) const {
+    const uint64_t v = rawSize_.load(std::memory_order_acquire);
+    if (!v) return false;
+    w = (int)(v >> 32); h = (int)(v & 0xffffffffu);
+    return true;
+}
+
+void RUSession::setRawSize(int w, int h) {
+    if (w <= 0 || h <= 0) return;
+    rawSize_.store((uint64_t)(uint32_t)w << 32 | (uint32_t)h, std::memory_order_release);
+}
+
+void RUSession::purgeBuffers() {
+    std::lock_guard<std::mutex> lk(stageMutex);
+    stages.bin = 0;
+    ++stages.generation;
+    stages.base.reset();
+    stages.sharpened.reset();
+    stages.flags.reset();
+}
+
+// MARK: - Mappings
+
+namespace {
+// Most recently used mappings, kept alive so sequential re-renders of a file
+// reuse one mapping; bounded so batch runs don't pile up address space.
+constexpr size_t kRU_RecentMappings = 4;
+std::mutex                                       gRU_RecentMutex;
+std::deque<std::shared_ptr<const RUMappedBytes>> gRU_Recent;
+
+void ru_touch_mapping(const std::shared_ptr<const RUMappedBytes> &m) {
+    std::lock_guard<std::mutex> lk(gRU_RecentMutex);
+    for (auto it = gRU_Recent.begin(); it != gRU_Recent.end(); ++it)
+        if (*it == m) { gRU_Recent.erase(it); break; }
+    gRU_Recent.push_front(m);
+    if (gRU_Recent.size() > kRU_RecentMappings) gRU_Recent.pop_back();
+}
+}
+
+std::shared_ptr<const RUMappedBytes> RUSession::mapping() {
+    if (pinned_) return pinned_;
+    std::shared_ptr<const RUMappedBytes> m;
+    {
+        std::lock_guard<std::mutex> lk(mappingMutex_);
+        m = mapping_.lock();
+        if (!m) {
+            m = RUMappedBytes::mapFile(path.c_str());
+            if (m && (int64_t)m->size() != size) m.reset();   // rewritten since the session began
+            mapping_ = m;
+        }
+    }
+    if (m) ru_touch_mapping(m);
+    return m;
+}
+
+// MARK: - Registry
+
+namespace {
+using RUSessionMap = std::unordered_map<std::string, std::shared_ptr<RUSession>>;
+
+constexpr int64_t kRU_NoFile = -1;   // mtime of attached sessions with nothing at their path
+
+std::shared_ptr<const RUSessionMap> gRU_Sessions = std::make_shared<RUSessionMap>();
+std::mutex                          gRU_SessionsWrite;  // serializes copy-on-write updates
+
+std::shared_ptr<const RUSessionMap> ru_snapshot() { return std::atomic_load(&gRU_Sessions); }
+
+bool ru_file_identity(const char *path, int64_t &size, int64_t &mtimeNs) {
+    struct stat st {};
+    if (!path || stat(path, &st) != 0) return false;
+    size = (int64_t)st.st_size;
+#if defined(__APPLE__)
+    mtimeNs = (int64_t)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    mtimeNs = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    return true;
+}
+
+void ru_publish(const std::string &key, std::shared_ptr<RUSession> s) {
+    // caller holds gRU_SessionsWrite
+    auto next = std::make_shared<RUSessionMap>(*ru_snapshot());
+    (*next)[key] = std::move(s);
+    std::atomic_store(&gRU_Sessions, std::shared_ptr<const RUSessionMap>(std::move(next)));
+}
+}
+
+std::shared_ptr<RUSession> RU_SessionForPath(const char *path) {
+    if (!path) return nullptr;
+    const std::string key(path);
+    int64_t size = 0, mtimeNs = 0;
+    const bool onDisk = ru_file_identity(path, size, mtimeNs);
+    auto same = [&](const std::shared_ptr<RUSession> &s) {
+        if (s->mtimeNs == kRU_NoFile) return true;   // attached, named only
+        return onDisk && s->size == size && s->mtimeNs == mtimeNs;
+    };
+
+    {
+        const auto snap = ru_snapshot();
+        const auto it = snap->find(key);
+        if (it != snap->end() && same(it->second)) return it->second;
+    }
+    if (!onDisk) return nullptr;
+
+    std::lock_guard<std::mutex> lk(gRU_SessionsWrite);
+    const auto snap = ru_snapshot();
+    const auto it = snap->find(key);
+    if (it != snap->end() && same(it->second)) return it->second;  // raced with another creator
+
+    auto s = std::make_shared<RUSession>(key, size, mtimeNs);
+    ru_publish(key, s);
+    return s;
+}
+
+std::shared_ptr<RUSession> RU_AttachSessionBytes(const char *path, std::shared_ptr<const RUMappedBytes> bytes) {
+    if (!path || !bytes) return nullptr;
+    int64_t size = 0, mtimeNs = 0;
+    if (ru_file_identity(path, size, mtimeNs)) {
+        if (size != (int64_t)bytes->size()) return nullptr;
+    } else {
+        mtimeNs = kRU_NoFile;
+    }
+    const std::string key(path);
+    auto s = std::make_shared<RUSession>(key, mtimeNs, std::move(bytes));
+    std::lock_guard<std::mutex> lk(gRU_SessionsWrite);
+    ru_publish(key, s);
+    return s;
+}
+
+void RU_EndSession(const char *path) {
+    if (!path) return;
+    std::lock_guard<std::mutex> lk(gRU_SessionsWrite);
+    const auto snap = ru_snapshot();
+    if (!snap->count(path)) return;
+    auto next = std::make_shared<RUSessionMap>(*snap);
+    next->erase(path);
+    std::atomic_store(&gRU_Sessions, std::shared_ptr<const RUSessionMap>(std::move(next)));
+}
+
+void RU_PurgeSessionBuffers() {
+    const auto snap = ru_snapshot();
+    for (const auto &kv : *snap) kv.second->purgeBuffers();
+    std::lock_guard<std::mutex> lk(gRU_RecentMutex);
+    gRU_Recent.clear();
+}
@@ -0,0 +1,152 @@
+/*
+    RawUnravel - RUSession.h
+    ------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Per-file render state shared by every decode of the same RAW: sticky
+// auto-EV, metadata that is costly to re-read, the last display histogram,
+// the preview stage planes and a read-only mapping of the file itself.
+//
+// Sessions live in a registry keyed by path. Lookups read an immutable
+// snapshot (copy-on-write map behind atomic_load) and never wait on the
+// writer mutex; creating or ending a session copies the map. A session is tied
+// to the file's size and mtime: if the file changes, the next lookup starts a
+// fresh one. Renders hold a shared_ptr, so ending a session mid-render only
+// detaches it from the registry.
+//
+// A session can also be given its bytes (RU_AttachSessionBytes): imports that
+// arrive as data or a descriptor decode from those, and the path is then only
+// the session's name; it need not exist on disk.
+
+#pragma once
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "RUCACorrect.h"
+#include "RUClipMask.h"
+#include "RUHistogram.h"
+#include "RUMappedBytes.h"
+#include "RUPlanarImage.h"
+#include "RUPP3.h"
+#include "RUTrace.h"
+
+class RUSession {
+public:
+    RUSession(std::string p, int64_t sz, int64_t mt) : path(std::move(p)), size(sz), mtimeNs(mt) {}
+    /// Session over attached bytes (see RU_AttachSessionBytes).
+    RUSession(std::string p, int64_t mt, std::shared_ptr<const RUMappedBytes> bytes)
+        : path(std::move(p)), size((int64_t)bytes->size()), mtimeNs(mt),
+          attached_(true), pinned_(std::move(bytes)) {}
+
+    const std::string path;
+    const int64_t     size;
+    const int64_t     mtimeNs;
+
+    /// Auto-EV baseline of this file. The first render to get here stores
+    /// `candidate`; every render after that (any thread) gets the same value.
+    float stickyEV(float candidate);
+    /// The stored baseline, if any (so callers can skip measuring).
+    bool  hasStickyEV(float &ev) const;
+
+    /// EXIF orientation (1...8); 0 until set.
+    int  exifOrientation() const { return exif_.load(std::memory_order_acquire); }
+    void setExifOrientation(int exif) { exif_.store(exif, std::memory_order_release); }
+
+    /// Raw sensor size; false until set.
+    bool rawSize(int &w, int &h) const;
+    void setRawSize(int w, int h);
+
+    /// Display histogram of the last preview render of this file; nullptr
+    /// until one has finished. Readers get an immutable snapshot.
+    std::shared_ptr<const RUHistogram> histogram() const { return std::atomic_load(&histogram_); }
+    void setHistogram(std::shared_ptr<const RUHistogram> h) { std::atomic_store(&histogram_, std::move(h)); }
+
+    /// Clipping mask of the last preview render, when the mask was on.
+    std::shared_ptr<const RUClipMask> clipMask() const { return std::atomic_load(&clipMask_); }
+    void setClipMask(std::shared_ptr<const RUClipMask> m) { std::atomic_store(&clipMask_, std::move(m)); }
+
+    /// Stage events (RUTrace) of the last render of this file, preview or
+    /// full-res; nullptr before the first one or with tracing off.
+    using Timings = std::vector<RUTraceEvent>;
+    std::shared_ptr<const Timings> timings() const { return std::atomic_load(&timings_); }
+    void setTimings(std::shared_ptr<const Timings> t) { std::atomic_store(&timings_, std::move(t)); }
+
+    // MARK: - Preview stages
+    // Slider drags re-render the same file with one setting changed. The
+    // binned preview keeps its last bin + WB planes and, when RLD ran, the
+    // sharpened planes; RU_PP3Diff against the settings they were made with
+    // decides which stage the next render starts from.
+    struct PreviewStages {
+        int           bin = 0;      // bin factor of the planes (0 = empty)
+        RU_PP3        P;            // settings the planes were made with
+        RUPlanarImage base;         // binned, WB/cam→sRGB, linear
+        RUPlanarImage sharpened;    // after RLD (empty when RLD was off)
+        RUPooled<uint8_t> flags;    // RUClipRaw/RUClipGamut of `base` (empty unless the mask was on)
+        uint64_t      generation = 0;   // bumped whenever `base` is replaced or dropped
+    };
+    std::mutex    stageMutex;
+    PreviewStages stages;           // guarded by stageMutex
+
+    /// Drops the preview planes.
+    void purgeBuffers();
+
+    /// Auto-CA fits of this file's full-res renders.
+    RUCAFitCache caFits;
+
+    /// The file mapped read-only, shared by every LibRaw open of it; mapped
+    /// on first use. The registry keeps the few most recently used mappings
+    /// alive between renders, older ones go with their last reader. nullptr
+    /// if the file cannot be mapped (or no longer matches this session).
+    std::shared_ptr<const RUMappedBytes> mapping();
+    /// True if the bytes were attached rather than mapped from `path`.
+    bool attached() const { return attached_; }
+
+private:
+    std::atomic<float>    stickyEV_ { NAN };
+    std::atomic<int>      exif_ { 0 };
+    std::atomic<uint64_t> rawSize_ { 0 };   // w << 32 | h
+    std::shared_ptr<const RUHistogram> histogram_;
+    std::shared_ptr<const RUClipMask>  clipMask_;
+    std::shared_ptr<const Timings>     timings_;
+    std::mutex                         mappingMutex_;
+    std::weak_ptr<const RUMappedBytes> mapping_;
+    const bool                                 attached_ = false;
+    const std::shared_ptr<const RUMappedBytes> pinned_;   // attached bytes, held for the session's life
+};
+
+/// Session for `path`, created on first use or when the file changed since
+/// the last one. nullptr if the file cannot be stat'ed.
+std::shared_ptr<RUSession> RU_SessionForPath(const char *path);
+
+/// Starts a session for `path` that decodes from `bytes` instead of the file.
+/// If `path` exists it must be the same size (nullptr otherwise); if not, the
+/// session is found by name until RU_EndSession. Replaces any earlier session
+/// for `path`.
+std::shared_ptr<RUSession> RU_AttachSessionBytes(const char *path, std::shared_ptr<const RUMappedBytes> bytes);
+
+/// Removes the session for `path` from the registry; renders still holding it
+/// finish normally and its buffers go with the last reference.
+void RU_EndSession(const char *path);
+
+/// Drops the preview planes of every live session and the mappings kept
+/// alive between renders (memory warnings).
+void RU_PurgeSessionBuffers();
@@ -25,15 +25,25 @@ int RUExifOrientationFromLargestPreview(NSString *path);
 
 // MARK: - Progress notifications
 
-/// Posts a NSNotification named "RawUnravelProgress" with payload:
-/// { job:String, phase:String, step:String, iter:Int, total:Int }.
-/// Ensures delivery on the main thread.
+/// Stores the job's progress in its record (RUProgress.h), which the UI
+/// samples with +[RTPreviewDecoder progressForJob:]. When phase or step
+/// changed, also posts a NSNotification named "RawUnravelProgress" with
+/// payload { job:String, phase:String, step:String, iter:Int, total:Int },
+/// delivered on the main thread. iter/total updates within a step post nothing.
 void PostProgress(NSString *jobID,
                   NSString *phase,
                   NSString *step,
                   NSInteger iter,
                   NSInteger total);
 
+/// Posts the "RawUnravelProgress" notification without touching the record
+/// (for callers that already updated it and saw a transition).
+void PostProgressNotification(NSString *jobID,
+                              NSString *phase,
+                              NSString *step,
+                              NSInteger iter,
+                              NSInteger total);
+
 // MARK: - LibRaw flip → EXIF
 
 /// Maps LibRaw sizes.flip (0…7) to EXIF orientation (1…8).
@@ -20,9 +20,12 @@
 */
 
 #import "RUShared.h"
+#import "RUProgress.h"
 #import <Foundation/Foundation.h>
 #import <ImageIO/ImageIO.h>
 #import <CoreGraphics/CoreGraphics.h>
+#import <algorithm>
+#import <climits>
 
 #pragma mark - Internal helpers (pure functions)
 
@@ -157,10 +160,20 @@ int RUExifOrientationFromLargestPreview(NSString *path) {
 }
 
 // MARK: PostProgress
-// Posts a main-thread NSNotification with a progress payload:
+// Updates the job's progress record; phase/step transitions also post a
+// main-thread NSNotification with a progress payload:
 //   userInfo = { job:String, phase:String, step:String, iter:Int, total:Int }.
 void PostProgress(NSString *jobID, NSString *phase, NSString *step,
                   NSInteger iter, NSInteger total)
+{
+    const int i = (int)std::min<NSInteger>(iter, INT_MAX), t = (int)std::min<NSInteger>(total, INT_MAX);
+    if (!RU_ProgressForJob(jobID.UTF8String ?: "")->update(phase.UTF8String, step.UTF8String, i, t))
+        return;   // same step: the record has it, nothing to post
+    PostProgressNotification(jobID, phase, step, iter, total);
+}
+
+void PostProgressNotification(NSString *jobID, NSString *phase, NSString *step,
+                              NSInteger iter, NSInteger total)
 {
     NSDictionary *info = @{
         @"job"   : jobID  ?: @"",
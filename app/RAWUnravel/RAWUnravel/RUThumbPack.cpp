@@ -0,0 +1,170 @@
+/*
+    RawUnravel - RUThumbPack.cpp
+    ----------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RUThumbPack.h"
+#include "RUHash.h"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr char     kMagic[8]  = { 'R', 'U', 'T', 'P', 'A', 'C', 'K', '1' };
+constexpr uint32_t kRecMagic  = 0x52545552u;   // "RUTR"
+
+struct RecHead {
+    uint32_t magic;
+    uint32_t check;      // low half of XXH64(meta + image, seed = key)
+    uint64_t key;
+    uint32_t metaLen;
+    uint32_t imageLen;
+};
+static_assert(sizeof(RecHead) == 24, "pack record header is 24 bytes");
+
+uint32_t ru_check(uint64_t key, const void *meta, size_t metaLen, const void *image, size_t imageLen) {
+    RUXXH64 h(key);
+    h.update(meta, metaLen);
+    h.update(image, imageLen);
+    return (uint32_t)h.digest();
+}
+
+bool ru_write_all(int fd, const void *p, size_t n, uint64_t off) {
+    const unsigned char *b = static_cast<const unsigned char *>(p);
+    while (n) {
+        const ssize_t k = pwrite(fd, b, n, (off_t)off);
+        if (k <= 0) return false;
+        b += k; n -= (size_t)k; off += (uint64_t)k;
+    }
+    return true;
+}
+
+} // namespace
+
+RUThumbPack::~RUThumbPack() {
+    if (fd_ >= 0) close(fd_);
+}
+
+bool RUThumbPack::open(const std::string &path, size_t maxBytes) {
+    std::lock_guard<std::mutex> lk(m_);
+    if (fd_ >= 0) { close(fd_); fd_ = -1; }
+    path_ = path;
+    max_  = maxBytes;
+    index_.clear();
+    map_.reset();
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) return false;
+    struct stat st {};
+    if (fstat(fd_, &st) != 0) return false;
+    const uint64_t size = (uint64_t)st.st_size;
+    std::shared_ptr<const RUMappedBytes> m = size >= sizeof kMagic ? RUMappedBytes::mapDescriptor(fd_) : nullptr;
+    if (!m || memcmp(m->data(), kMagic, sizeof kMagic) != 0 || size > max_) return reset();
+
+    // ---- rebuild the index; stop at the first damaged record ----
+    const unsigned char *base = m->data();
+    uint64_t pos = sizeof kMagic;
+    while (pos + sizeof(RecHead) <= size) {
+        RecHead h;
+        memcpy(&h, base + pos, sizeof h);
+        const uint64_t body = (uint64_t)h.metaLen + h.imageLen;
+        if (h.magic != kRecMagic || pos + sizeof h + body > size) break;
+        const unsigned char *meta = base + pos + sizeof h;
+        if (ru_check(h.key, meta, h.metaLen, meta + h.metaLen, h.imageLen) != h.check) break;
+        index_[h.key] = Slot { pos, h.metaLen, h.imageLen };
+        pos += sizeof h + body;
+    }
+    end_ = pos;
+    if (end_ < size) {                  // torn tail; nobody maps this file yet
+        m.reset();
+        if (ftruncate(fd_, (off_t)end_) != 0) return reset();
+    }
+    map_ = m ? std::move(m) : RUMappedBytes::mapDescriptor(fd_);
+    return true;
+}
+
+bool RUThumbPack::reset() {
+    index_.clear();
+    map_.reset();
+    end_ = 0;
+    const std::string tmp = path_ + ".new";
+    const int fd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    if (!ru_write_all(fd, kMagic, sizeof kMagic, 0) || rename(tmp.c_str(), path_.c_str()) != 0) {
+        close(fd);
+        unlink(tmp.c_str());
+        return false;
+    }
+    if (fd_ >= 0) close(fd_);          // old mappings keep the old inode alive
+    fd_  = fd;
+    end_ = sizeof kMagic;
+    return true;
+}
+
+bool RUThumbPack::find(uint64_t key, Entry &e) const {
+    std::lock_guard<std::mutex> lk(m_);
+    const auto it = index_.find(key);
+    if (it == index_.end()) return false;
+    const Slot &s = it->second;
+    const uint64_t recEnd = s.offset + sizeof(RecHead) + s.metaLen + s.imageLen;
+    if (!map_ || map_->size() < recEnd) {
+        map_ = RUMappedBytes::mapDescriptor(fd_);
+        if (!map_ || map_->size() < recEnd) return false;
+    }
+    e.pack     = map_;
+    e.meta     = map_->data() + s.offset + sizeof(RecHead);
+    e.metaLen  = s.metaLen;
+    e.image    = e.meta + s.metaLen;
+    e.imageLen = s.imageLen;
+    return true;
+}
+
+bool RUThumbPack::put(uint64_t key, const void *meta, size_t metaLen, const void *image, size_t imageLen) {
+    if (metaLen > UINT32_MAX || imageLen > UINT32_MAX) return false;
+    const size_t rec = sizeof(RecHead) + metaLen + imageLen;
+    std::lock_guard<std::mutex> lk(m_);
+    if (fd_ < 0 || rec + sizeof kMagic > max_) return false;
+    if (end_ + rec > max_ && !reset()) return false;
+
+    std::vector<unsigned char> buf(rec);
+    const RecHead h { kRecMagic, ru_check(key, meta, metaLen, image, imageLen),
+                      key, (uint32_t)metaLen, (uint32_t)imageLen };
+    memcpy(buf.data(), &h, sizeof h);
+    if (metaLen)  memcpy(buf.data() + sizeof h, meta, metaLen);
+    if (imageLen) memcpy(buf.data() + sizeof h + metaLen, image, imageLen);
+    if (!ru_write_all(fd_, buf.data(), rec, end_)) return false;   // a partial record past end_ is overwritten next time
+
+    index_[key] = Slot { end_, (uint32_t)metaLen, (uint32_t)imageLen };
+    end_ += rec;
+    return true;
+}
+
+size_t RUThumbPack::count() const {
+    std::lock_guard<std::mutex> lk(m_);
+    return index_.size();
+}
+
+size_t RUThumbPack::bytes() const {
+    std::lock_guard<std::mutex> lk(m_);
+    return (size_t)end_;
+}
@@ -0,0 +1,78 @@
+/*
+    RawUnravel - RUThumbPack.h
+    --------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Append-only pack file of (key, metadata, image) records, read through one
+// read-only mapping. The index (key → record) lives in memory and is rebuilt
+// from the pack on open; records are self-delimiting and checksummed, so a
+// torn write at the tail is simply cut off. A later record for a key replaces
+// the earlier one. When an append would pass the size cap the pack starts
+// over (a new file renamed into place, so readers of the old mapping are
+// never cut short).
+//
+// Lookups take an uncontended mutex and a hash probe and return pointers into
+// the mapping; the Entry keeps that mapping alive.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "RUMappedBytes.h"
+
+class RUThumbPack {
+public:
+    struct Entry {
+        std::shared_ptr<const RUMappedBytes> pack;   // keeps the bytes below valid
+        const unsigned char *meta = nullptr;
+        size_t               metaLen = 0;
+        const unsigned char *image = nullptr;
+        size_t               imageLen = 0;
+    };
+
+    RUThumbPack() = default;
+    ~RUThumbPack();
+    RUThumbPack(const RUThumbPack &) = delete;
+    RUThumbPack &operator=(const RUThumbPack &) = delete;
+
+    /// Opens (or creates) the pack at `path`, capped at `maxBytes`.
+    bool open(const std::string &path, size_t maxBytes);
+
+    bool find(uint64_t key, Entry &e) const;
+    bool put(uint64_t key, const void *meta, size_t metaLen, const void *image, size_t imageLen);
+
+    size_t count() const;
+    size_t bytes() const;
+
+private:
+    struct Slot { uint64_t offset; uint32_t metaLen, imageLen; };
+
+    bool reset();   // m_ held
+
+    mutable std::mutex m_;
+    int         fd_ = -1;
+    std::string path_;
+    size_t      max_ = 0;
+    uint64_t    end_ = 0;                                  // end of the last complete record
+    std::unordered_map<uint64_t, Slot> index_;
+    mutable std::shared_ptr<const RUMappedBytes> map_;     // remapped when a record lies past it
+};
@@ -0,0 +1,68 @@
+/*
+    RawUnravel - RUThumbnailStore.h
+    -------------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Persistent thumbnail + metadata cache for the file screen: one pack file
+// (RUThumbPack) in Caches holding a JPEG thumbnail (800 px long edge) and the
+// file's ImageIO properties (binary plist) per file. Files in the import
+// store are keyed by their content key; others by path, size and mtime.
+// A background prefetcher fills entries for files about to be shown.
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface RUThumbnailEntry : NSObject
+@property (nonatomic, readonly) UIImage *thumbnail;
+/// ImageIO properties of the primary image (as CGImageSourceCopyPropertiesAtIndex).
+@property (nonatomic, readonly) NSDictionary<NSString *, id> *metadata;
+/// Size of the embedded preview the file carries; CGSizeZero if none.
+@property (nonatomic, readonly) CGSize previewSize;
+@end
+
+@interface RUThumbnailStore : NSObject
+
+@property (class, nonatomic, readonly) RUThumbnailStore *shared;
+
+/// Cached entry, or nil. Never touches the file's pixels; cheap enough for
+/// the main thread.
+- (nullable RUThumbnailEntry *)entryForURL:(NSURL *)url
+NS_SWIFT_NAME(entry(for:));
+
+/// Stores what the caller already extracted for `url`.
+- (void)storeThumbnail:(UIImage *)thumbnail
+              metadata:(NSDictionary<NSString *, id> *)metadata
+           previewSize:(CGSize)previewSize
+                forURL:(NSURL *)url
+NS_SWIFT_NAME(store(thumbnail:metadata:previewSize:for:));
+
+/// Cached entry, else reads the file (ImageIO thumbnail + properties), stores
+/// and returns it. Blocking; nil if ImageIO cannot read the file.
+- (nullable RUThumbnailEntry *)loadEntryForURL:(NSURL *)url
+NS_SWIFT_NAME(loadEntry(for:));
+
+/// Fills missing entries for `urls` on a background queue, in order.
+- (void)prefetchURLs:(NSArray<NSURL *> *)urls
+NS_SWIFT_NAME(prefetch(_:));
+
+@end
+
+NS_ASSUME_NONNULL_END
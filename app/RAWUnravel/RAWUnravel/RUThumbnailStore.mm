@@ -0,0 +1,199 @@
+/*
+    RawUnravel - RUThumbnailStore.mm
+    --------------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#import "RUThumbnailStore.h"
+#import "RUImportCache.h"
+#import "RUHash.h"
+#import "RUThumbPack.h"
+#import <ImageIO/ImageIO.h>
+#import <algorithm>
+#import <cstdlib>
+#import <cstring>
+#import <sys/stat.h>
+
+static constexpr size_t   kRUThumbPackMax   = 64u << 20;
+static constexpr uint64_t kRUThumbVersion   = 1;      // bump when the thumbnail or metadata format changes
+static constexpr int      kRUThumbMaxPixels = 800;    // FileView's thumbnail size
+static constexpr long     kRUThumbMinPreviewArea = 200 * 200;
+static NSString *const    kRUThumbPreviewKey = @"RUPreviewSize";   // [w, h], stored with the metadata
+
+// MARK: - Entry
+
+@implementation RUThumbnailEntry
+
+- (instancetype)initWithThumbnail:(UIImage *)thumbnail metadata:(NSDictionary *)metadata previewSize:(CGSize)previewSize {
+    if ((self = [super init])) {
+        _thumbnail   = thumbnail;
+        _metadata    = [metadata copy];
+        _previewSize = previewSize;
+    }
+    return self;
+}
+
+@end
+
+// MARK: - Keys
+
+// Content key for import-store files (same bytes, same thumbnail, whatever
+// the path); path + size + mtime otherwise. 0 if the file cannot be stat'ed.
+static uint64_t RU_ThumbKey(NSURL *url) {
+    if (NSString *ck = [RUImportCache.shared contentKeyForPath:url.path]) {
+        const unsigned long long v = strtoull(ck.UTF8String, NULL, 16);
+        return RU_XXH64(&v, sizeof v, kRUThumbVersion);
+    }
+    struct stat st {};
+    if (stat(url.fileSystemRepresentation, &st) != 0) return 0;
+    NSString *ident = [NSString stringWithFormat:@"%@|%lld|%lld.%09ld", url.path, (long long)st.st_size,
+                       (long long)st.st_mtimespec.tv_sec, (long)st.st_mtimespec.tv_nsec];
+    const char *s = ident.UTF8String;
+    return RU_XXH64(s, strlen(s), kRUThumbVersion);
+}
+
+// MARK: - Probe
+
+// Embedded preview size as FileView reports it: the largest image smaller than
+// the primary and at least 200×200, else (RAW) the largest non-primary one.
+static CGSize RU_EmbeddedPreviewSize(CGImageSourceRef src) {
+    const size_t count = CGImageSourceGetCount(src);
+    long w[64] = {}, h[64] = {};
+    long largest = -1, biggestSecondary = -1;
+    CGSize secondary = CGSizeZero;
+    const size_t n = std::min<size_t>(count, 64);
+    for (size_t i = 0; i < n; ++i) {
+        NSDictionary *p = CFBridgingRelease(CGImageSourceCopyPropertiesAtIndex(src, i, NULL));
+        w[i] = [p[(id)kCGImagePropertyPixelWidth] longValue];
+        h[i] = [p[(id)kCGImagePropertyPixelHeight] longValue];
+        if (w[i] <= 0 || h[i] <= 0) continue;
+        largest = std::max(largest, w[i] * h[i]);
+        if (i > 0 && w[i] * h[i] > biggestSecondary) { biggestSecondary = w[i] * h[i]; secondary = CGSizeMake(w[i], h[i]); }
+    }
+    long best = -1;
+    CGSize size = CGSizeZero;
+    for (size_t i = 0; i < n; ++i) {
+        const long a = w[i] * h[i];
+        if (a < largest && a >= kRUThumbMinPreviewArea && a > best) { best = a; size = CGSizeMake(w[i], h[i]); }
+    }
+    return best > 0 ? size : secondary;
+}
+
+// MARK: - Store
+
+@implementation RUThumbnailStore {
+    RUThumbPack       _pack;
+    dispatch_queue_t  _prefetchQ;
+    NSMutableSet<NSString *> *_pending;   // paths queued for prefetch; @synchronized(self)
+}
+
++ (RUThumbnailStore *)shared {
+    static RUThumbnailStore *s;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{ s = [RUThumbnailStore new]; });
+    return s;
+}
+
+- (instancetype)init {
+    if ((self = [super init])) {
+        NSString *caches = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES).firstObject;
+        NSString *dir = [caches stringByAppendingPathComponent:@"RAWUnravel"];
+        [[NSFileManager defaultManager] createDirectoryAtPath:dir withIntermediateDirectories:YES attributes:nil error:nil];
+        _pack.open([dir stringByAppendingPathComponent:@"thumbs.pack"].fileSystemRepresentation, kRUThumbPackMax);
+        _prefetchQ = dispatch_queue_create("rawunravel.thumb-prefetch",
+                                           dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0));
+        _pending = [NSMutableSet set];
+    }
+    return self;
+}
+
+- (nullable RUThumbnailEntry *)entryForURL:(NSURL *)url {
+    const uint64_t key = RU_ThumbKey(url);
+    RUThumbPack::Entry e;
+    if (!key || !_pack.find(key, e)) return nil;
+
+    // both views borrow the mapping; the blocks keep it alive
+    std::shared_ptr<const RUMappedBytes> pack = e.pack;
+    NSData *meta  = [[NSData alloc] initWithBytesNoCopy:(void *)e.meta length:e.metaLen
+                                            deallocator:^(void *, NSUInteger) { (void)pack; }];
+    NSData *image = [[NSData alloc] initWithBytesNoCopy:(void *)e.image length:e.imageLen
+                                            deallocator:^(void *, NSUInteger) { (void)pack; }];
+    NSMutableDictionary *md = [NSPropertyListSerialization propertyListWithData:meta
+                                                                        options:NSPropertyListMutableContainers
+                                                                         format:NULL error:NULL];
+    UIImage *thumb = [UIImage imageWithData:image];
+    if (![md isKindOfClass:NSMutableDictionary.class] || !thumb) return nil;
+
+    CGSize preview = CGSizeZero;
+    NSArray *ps = md[kRUThumbPreviewKey];
+    if ([ps isKindOfClass:NSArray.class] && ps.count == 2) preview = CGSizeMake([ps[0] doubleValue], [ps[1] doubleValue]);
+    [md removeObjectForKey:kRUThumbPreviewKey];
+    return [[RUThumbnailEntry alloc] initWithThumbnail:thumb metadata:md previewSize:preview];
+}
+
+- (void)storeThumbnail:(UIImage *)thumbnail metadata:(NSDictionary<NSString *, id> *)metadata
+           previewSize:(CGSize)previewSize forURL:(NSURL *)url
+{
+    const uint64_t key = RU_ThumbKey(url);
+    if (!key) return;
+    NSMutableDictionary *md = [metadata mutableCopy];
+    md[kRUThumbPreviewKey] = @[ @(previewSize.width), @(previewSize.height) ];
+    NSData *meta = [NSPropertyListSerialization dataWithPropertyList:md format:NSPropertyListBinaryFormat_v1_0
+                                                             options:0 error:NULL];
+    NSData *jpeg = UIImageJPEGRepresentation(thumbnail, 0.8);
+    if (!meta || !jpeg) return;
+    _pack.put(key, meta.bytes, meta.length, jpeg.bytes, jpeg.length);
+}
+
+- (nullable RUThumbnailEntry *)loadEntryForURL:(NSURL *)url {
+    if (RUThumbnailEntry *e = [self entryForURL:url]) return e;
+
+    CGImageSourceRef src = CGImageSourceCreateWithURL((__bridge CFURLRef)url,
+                                                      (__bridge CFDictionaryRef)@{(id)kCGImageSourceShouldCache: @NO});
+    if (!src) return nil;
+    NSDictionary *props = CFBridgingRelease(CGImageSourceCopyPropertiesAtIndex(src, 0, NULL));
+    NSDictionary *opts = @{ (id)kCGImageSourceCreateThumbnailFromImageIfAbsent: @YES,
+                            (id)kCGImageSourceShouldCache: @NO,
+                            (id)kCGImageSourceThumbnailMaxPixelSize: @(kRUThumbMaxPixels),
+                            (id)kCGImageSourceCreateThumbnailWithTransform: @YES };
+    CGImageRef cg = CGImageSourceCreateThumbnailAtIndex(src, 0, (__bridge CFDictionaryRef)opts);
+    const CGSize preview = RU_EmbeddedPreviewSize(src);
+    CFRelease(src);
+    if (!cg || !props.count) { if (cg) CGImageRelease(cg); return nil; }
+
+    UIImage *thumb = [UIImage imageWithCGImage:cg];
+    CGImageRelease(cg);
+    [self storeThumbnail:thumb metadata:props previewSize:preview forURL:url];
+    return [[RUThumbnailEntry alloc] initWithThumbnail:thumb metadata:props previewSize:preview];
+}
+
+- (void)prefetchURLs:(NSArray<NSURL *> *)urls {
+    for (NSURL *url in urls) {
+        NSString *path = url.path;
+        @synchronized (self) {
+            if ([_pending containsObject:path]) continue;
+            [_pending addObject:path];
+        }
+        dispatch_async(_prefetchQ, ^{
+            @autoreleasepool { [self loadEntryForURL:url]; }
+            @synchronized (self) { [self->_pending removeObject:path]; }
+        });
+    }
+}
+
+@end
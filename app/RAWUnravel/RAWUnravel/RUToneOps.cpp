@@ -0,0 +1,305 @@
+/*
+    RawUnravel - RUToneOps.cpp
+    --------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RUToneOps.h"
+#include "RUClipMask.h"
+#include "RUHistogram.h"
+#include "RUParallel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+// MARK: - Auto-EV
+// Map the p-th luminance percentile to `target` and return the EV needed.
+// Does NOT modify R/G/B; works in linear, on every `rowStep`-th row.
+
+float RU_AutoEVFromPercentile(const float *R, const float *G, const float *B,
+                              int W, int H, int rowStep, float percentile, float target)
+{
+    if (W <= 0 || H <= 0) return 0.f;
+    std::unique_ptr<RUHistogram> hist(new RUHistogram(1024));
+    RU_HistogramLinear(R, G, B, W, H, (size_t)W, rowStep, *hist);
+    const float pY = hist->percentile(RUHistogram::Luma, percentile);
+    if (pY <= 1e-6f) return 0.f;
+
+    float k = std::clamp(target / pY, 0.25f, 8.0f); // same clamps as before
+    return log2f(k); // convert linear gain to EV
+}
+
+// MARK: - sRGB / XYZ / Lab
+static void rgb2xyz(float r,float g,float b,float*X,float*Y,float*Z){
+    r=ru_srgb_to_linear(r); g=ru_srgb_to_linear(g); b=ru_srgb_to_linear(b);
+    *X = r*0.4124564f + g*0.3575761f + b*0.1804375f;
+    *Y = r*0.2126729f + g*0.7151522f + b*0.0721750f;
+    *Z = r*0.0193339f + g*0.1191920f + b*0.9503041f;
+}
+static void xyz2lab(float X,float Y,float Z,float*L,float*a,float*b){
+    float Xr=0.95047f,Yr=1.f,Zr=1.08883f;
+    auto f=[](float t){return t>0.008856f? powf(t,1.f/3.f): (7.787f*t + 16.f/116.f);};
+    float fx=f(X/Xr), fy=f(Y/Yr), fz=f(Z/Zr);
+    *L=116.f*fy-16.f; *a=500.f*(fx-fy); *b=200.f*(fy-fz);
+}
+static void lab2xyz(float L,float a,float b,float*X,float*Y,float*Z){
+    float Xr=0.95047f,Yr=1.f,Zr=1.08883f;
+    float fy=(L+16.f)/116.f, fx=fy + a/500.f, fz=fy - b/200.f;
+    auto f3=[](float t){return t>0.206893f? t*t*t : (t-16.f/116.f)/7.787f;};
+    *X=Xr*f3(fx); *Y=Yr*f3(fy); *Z=Zr*f3(fz);
+}
+static void xyz2rgb(float X,float Y,float Z,float*r,float*g,float*b){
+    float rl =  3.2404542f*X -1.5371385f*Y -0.4985314f*Z;
+    float gl = -0.9692660f*X +1.8760108f*Y +0.0415560f*Z;
+    float bl =  0.0556434f*X -0.2040259f*Y +1.0572252f*Z;
+    *r=ru_linear_to_srgb(rl); *g=ru_linear_to_srgb(gl); *b=ru_linear_to_srgb(bl);
+}
+
+// Same operations as RU_ApplyLabOps_OnBGRA, on linear sRGB float planes
+// (no 8-bit round trip): linear → XYZ → Lab, edit, back, clamp to 0..1.
+void RU_ApplyLabOps_OnPlanes(float *R, float *G, float *B, int N,
+                             bool chromaEnabled, float chromaticity,
+                             bool cChromaEnabled, float cChroma,
+                             bool jContrastEnabled, float jContrast)
+{
+    const bool doChroma = chromaEnabled && fabsf(chromaticity) > 0.01f;
+    const bool doCChroma = cChromaEnabled && fabsf(cChroma) > 0.01f;
+    const bool doJ = jContrastEnabled && fabsf(jContrast) > 0.01f;
+    if (!(doChroma || doCChroma || doJ)) return;
+
+    RU_ParallelFor(0, N, 16384, [&](int i0, int i1) {
+        for (int i=i0;i<i1;++i){
+            const float r=R[i], g=G[i], b=B[i];
+            const float X = r*0.4124564f + g*0.3575761f + b*0.1804375f;
+            const float Y = r*0.2126729f + g*0.7151522f + b*0.0721750f;
+            const float Z = r*0.0193339f + g*0.1191920f + b*0.9503041f;
+            float L,a,b2; xyz2lab(X,Y,Z,&L,&a,&b2);
+
+            if (doChroma){ float m=1.f + chromaticity/100.f; a*=m; b2*=m; }
+            if (doCChroma){
+                float m=1.f + cChroma/100.f; float C=hypotf(a,b2), ang=atan2f(b2,a);
+                C*=m; a=C*cosf(ang); b2=C*sinf(ang);
+            }
+            if (doJ){ float m=1.f + jContrast/100.f; L=std::clamp((L-50.f)*m + 50.f, 0.f, 100.f); }
+
+            float X2,Y2,Z2; lab2xyz(L,a,b2,&X2,&Y2,&Z2);
+            R[i] = std::clamp( 3.2404542f*X2 -1.5371385f*Y2 -0.4985314f*Z2, 0.f, 1.f);
+            G[i] = std::clamp(-0.9692660f*X2 +1.8760108f*Y2 +0.0415560f*Z2, 0.f, 1.f);
+            B[i] = std::clamp( 0.0556434f*X2 -0.2040259f*Y2 +1.0572252f*Z2, 0.f, 1.f);
+        }
+    });
+}
+
+// MARK: - Linear-stage ops + preview sharpen
+
+// The way dcraw_process does it with use_camera_wb.
+void RU_ApplyWBMatrix(float *R, float *G, float *B, size_t N, const float wb[3], const float M[9],
+                      uint8_t *flags, bool keepOver)
+{
+    const float top = keepOver ? std::numeric_limits<float>::max() : 1.f;
+    for (size_t i = 0; i < N; ++i) {
+        const float r = std::min(top, R[i] * wb[0]);
+        const float g = std::min(top, G[i] * wb[1]);
+        const float b = std::min(top, B[i] * wb[2]);
+        const float ro = M[0]*r + M[1]*g + M[2]*b;
+        const float go = M[3]*r + M[4]*g + M[5]*b;
+        const float bo = M[6]*r + M[7]*g + M[8]*b;
+        if (flags) {
+            // planes are normalized to (maximum - black): 1.0 is the white level
+            const bool rawClip = std::max({ R[i], G[i], B[i] }) >= 0.999f;
+            const bool gamut   = std::min({ ro, go, bo }) < 0.f;
+            flags[i] = (rawClip ? RUClipRaw : 0) | (gamut ? RUClipGamut : 0);
+        }
+        R[i] = std::clamp(ro, 0.f, top);
+        G[i] = std::clamp(go, 0.f, top);
+        B[i] = std::clamp(bo, 0.f, top);
+    }
+}
+void RU_ApplyExposureEV(float *R,float *G,float *B,int N,float ev){
+    if (fabsf(ev)<1e-6f) return;
+    float k=powf(2.f,ev);
+    for(int i=0;i<N;++i){ R[i]*=k; G[i]*=k; B[i]*=k; }
+}
+void RU_ApplyBlack(float *R,float *G,float *B,int N,float bp){
+    if (bp<=0.f) return;
+    bp=std::min(bp,0.95f);
+    float s=1.f/(1.f-bp);
+    for(int i=0;i<N;++i){ R[i]=std::max(0.f,(R[i]-bp))*s; G[i]=std::max(0.f,(G[i]-bp))*s; B[i]=std::max(0.f,(B[i]-bp))*s; }
+}
+void RU_ApplyShadows(float *R,float *G,float *B,int N,float sh){
+    if (fabsf(sh)<1e-4f) return;
+    float s=sh/100.f;
+    for(int i=0;i<N;++i){
+        auto op=[&](float x){ x=std::clamp(x,0.f,1.f); float Y=x; float lift=s*(1.f-Y)*Y; return std::clamp(x+lift,0.f,1.f); };
+        R[i]=op(R[i]); G[i]=op(G[i]); B[i]=op(B[i]);
+    }
+}
+
+// Cheap iterative blur/unsharp to preview “RLD”
+void RU_ApplyPreviewSharpen(float *R,float *G,float *B,int W,int H,int iters,float radius,float amount,float dampPct){
+    if (iters<=0 || amount<=0.f || radius<=0.2f) return;
+    const int N=W*H; const float k=amount/100.f; const float damp=std::clamp(dampPct/100.f,0.f,0.95f);
+    std::unique_ptr<float[]> tmp(new float[N]);
+
+    auto blur3 = [&](float *C){
+        int r=std::max(1,(int)lrintf(radius));
+        for(int p=0;p<r;++p){
+            for(int y=0;y<H;++y){ float prev=C[y*W+0];
+                for(int x=0;x<W;++x){ int i=y*W+x; float cur=C[i]; float nxt=(x+1<W)?C[i+1]:cur; tmp[i]=(prev+cur+nxt)/3.f; prev=cur; } }
+            for(int x=0;x<W;++x){ float prev=tmp[0*W+x];
+                for(int y=0;y<H;++y){ int i=y*W+x; float cur=tmp[i]; float nxt=(y+1<H)?tmp[i+W]:cur; C[i]=(prev+cur+nxt)/3.f; prev=cur; } }
+        }
+    };
+    auto iterCh = [&](float *C){
+        std::unique_ptr<float[]> base(new float[N]); memcpy(base.get(),C,N*sizeof(float));
+        for(int t=0;t<iters;++t){
+            std::unique_ptr<float[]> bl(new float[N]); memcpy(bl.get(),C,N*sizeof(float)); blur3(bl.get());
+            for(int i=0;i<N;++i){
+                float edge = base[i]-bl[i];
+                float v = std::clamp(C[i] + k*edge, 0.f, 1.f);
+                C[i] = v*(1.f-damp) + base[i]*damp;
+            }
+        }
+    };
+    iterCh(R); iterCh(G); iterCh(B);
+}
+
+// MARK: - 8-bit buffers (embedded-preview fallbacks)
+void RU_ApplyLabOps_OnBGRA(uint8_t *bgra, int W, int H,
+                           bool chromaEnabled, float chromaticity,
+                           bool cChromaEnabled, float cChroma,
+                           bool jContrastEnabled, float jContrast)
+{
+    
+    if (!(chromaEnabled || cChromaEnabled || jContrastEnabled)) return;
+    const int N=W*H;
+    for (int i=0;i<N;++i){
+        uint8_t B=bgra[i*4+0], G=bgra[i*4+1], R=bgra[i*4+2];
+        float r=R/255.f, g=G/255.f, b=B/255.f;
+        float X,Y,Z,L,a,b2; rgb2xyz(r,g,b,&X,&Y,&Z); xyz2lab(X,Y,Z,&L,&a,&b2);
+
+        if (chromaEnabled && fabsf(chromaticity)>0.01f){
+            float m=1.f + chromaticity/100.f; a*=m; b2*=m;
+        }
+        if (cChromaEnabled && fabsf(cChroma)>0.01f){
+            float m=1.f + cChroma/100.f; float C=hypotf(a,b2), ang=atan2f(b2,a);
+            C*=m; a=C*cosf(ang); b2=C*sinf(ang);
+        }
+        if (jContrastEnabled && fabsf(jContrast)>0.01f){
+            float m=1.f + jContrast/100.f; L=(L-50.f)*m + 50.f; L=std::clamp(L,0.f,100.f);
+        }
+
+        lab2xyz(L,a,b2,&X,&Y,&Z); xyz2rgb(X,Y,Z,&r,&g,&b);
+        r=std::clamp(r,0.f,1.f); g=std::clamp(g,0.f,1.f); b=std::clamp(b,0.f,1.f);
+        bgra[i*4+0]=(uint8_t)lrintf(b*255.f);
+        bgra[i*4+1]=(uint8_t)lrintf(g*255.f);
+        bgra[i*4+2]=(uint8_t)lrintf(r*255.f);
+    }
+}
+
+// Applies PP3 exposure/black/shadows in *linear* space to a BGRA8 buffer
+void RU_ApplyToneOps_OnBGRA(uint8_t *bgra, int W, int H, const RU_PP3 &P)
+{
+    const int N = W * H;
+    if (!(P.hasExposure || P.hasBlack || P.hasShadows)) return;
+
+    // 1) BGRA -> linear float planes
+    std::unique_ptr<float[]> R(new float[N]), G(new float[N]), B(new float[N]);
+    for (int i = 0; i < N; ++i) {
+        const float r = bgra[i*4 + 2] / 255.f;
+        const float g = bgra[i*4 + 1] / 255.f;
+        const float b = bgra[i*4 + 0] / 255.f;
+        R[i] = ru_srgb_to_linear(r);
+        G[i] = ru_srgb_to_linear(g);
+        B[i] = ru_srgb_to_linear(b);
+    }
+
+    // 2) Exposure (in stops)
+    if (P.hasExposure) {
+        const float k = powf(2.f, P.exposureEV);
+        for (int i = 0; i < N; ++i) { R[i] *= k; G[i] *= k; B[i] *= k; }
+    }
+
+    // 3) Black point lift (normalize range)
+    if (P.hasBlack) {
+        float bp = fminf(fmaxf(P.black, 0.f), 0.95f);
+        const float s = 1.f / (1.f - bp);
+        for (int i = 0; i < N; ++i) {
+            R[i] = fmaxf(0.f, R[i] - bp) * s;
+            G[i] = fmaxf(0.f, G[i] - bp) * s;
+            B[i] = fmaxf(0.f, B[i] - bp) * s;
+        }
+    }
+
+    // 4) Shadows lift (simple perceptual lift)
+    if (P.hasShadows) {
+        const float s = P.shadows / 100.f;
+        for (int i = 0; i < N; ++i) {
+            auto lift = [&](float x){
+                x = fminf(fmaxf(x, 0.f), 1.f);
+                const float Y = x;
+                return fminf(fmaxf(x + s * (1.f - Y) * Y, 0.f), 1.f);
+            };
+            R[i] = lift(R[i]); G[i] = lift(G[i]); B[i] = lift(B[i]);
+        }
+    }
+
+    
+    // 5) Back to sRGB into BGRA
+    for (int i = 0; i < N; ++i) {
+        const float r = fminf(fmaxf(ru_linear_to_srgb(R[i]), 0.f), 1.f);
+        const float g = fminf(fmaxf(ru_linear_to_srgb(G[i]), 0.f), 1.f);
+        const float b = fminf(fmaxf(ru_linear_to_srgb(B[i]), 0.f), 1.f);
+        bgra[i*4 + 2] = (uint8_t)lrintf(r * 255.f);
+        bgra[i*4 + 1] = (uint8_t)lrintf(g * 255.f);
+        bgra[i*4 + 0] = (uint8_t)lrintf(b * 255.f);
+        // alpha (i*4+3) untouched
+    }
+}
+
+void RU_ApplyPreviewSharpen_OnBGRA(uint8_t *bgra, int W, int H,
+                                   int iters, float radius, float amount, float dampPct)
+{
+    if (iters <= 0 || amount <= 0.f || radius <= 0.f) return;
+    const int N = W*H;
+    std::unique_ptr<float[]> R(new float[N]), G(new float[N]), B(new float[N]);
+    
+    // sRGB8 -> linear float
+    for (int i=0;i<N;++i){
+        float r = bgra[i*4+2] / 255.f;
+        float g = bgra[i*4+1] / 255.f;
+        float b = bgra[i*4+0] / 255.f;
+        R[i] = ru_srgb_to_linear(r);
+        G[i] = ru_srgb_to_linear(g);
+        B[i] = ru_srgb_to_linear(b);
+    }
+    
+    RU_ApplyPreviewSharpen(R.get(), G.get(), B.get(), W, H, iters, radius, amount, dampPct);
+    
+    // linear -> sRGB8
+    for (int i=0;i<N;++i){
+        float r = std::clamp(ru_linear_to_srgb(std::clamp(R[i],0.f,1.f)), 0.f, 1.f);
+        float g = std::clamp(ru_linear_to_srgb(std::clamp(G[i],0.f,1.f)), 0.f, 1.f);
+        float b = std::clamp(ru_linear_to_srgb(std::clamp(B[i],0.f,1.f)), 0.f, 1.f);
+        bgra[i*4+2] = (uint8_t)lrintf(r*255.f);
+        bgra[i*4+1] = (uint8_t)lrintf(g*255.f);
+        bgra[i*4+0] = (uint8_t)lrintf(b*255.f);
+    }
+}
@@ -0,0 +1,77 @@
+/*
+    RawUnravel - RUToneOps.h
+    ------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Per-pixel develop ops on linear sRGB float planes (tone, Lab, auto-EV,
+// preview sharpen) and their 8-bit BGRA variants for the embedded-preview
+// fallbacks. Pure C++; shared by the app and the command-line developer.
+
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include "RUPP3.h"
+
+inline float ru_srgb_to_linear(float c) { return (c<=0.04045f)? c/12.92f : powf((c+0.055f)/1.055f, 2.4f); }
+inline float ru_linear_to_srgb(float c) {
+    // keep numerically safe and clamp at the end
+    if (c <= 0.0031308f) return 12.92f * c;
+    return 1.055f * powf(fmaxf(c, 0.f), 1.f/2.4f) - 0.055f;
+}
+
+/// EV that maps the p-th luminance percentile to `target` (gain clamped to
+/// 1/4…8); reads every `rowStep`-th row, leaves the planes alone.
+float RU_AutoEVFromPercentile(const float *R, const float *G, const float *B,
+                              int W, int H, int rowStep, float percentile, float target);
+
+// MARK: - Linear planes
+/// Camera RGB (0..1, black-subtracted) → linear sRGB: × wb, clip to 1 (unless
+/// keepOver: reconstructed highlights above 1 are image data), × M (3×3,
+/// row-major camera → sRGB), clamp. `flags` (optional, N bytes): RUClipRaw
+/// where a camera channel sits at the white level, RUClipGamut where the
+/// matrix drives a channel negative.
+void RU_ApplyWBMatrix(float *R, float *G, float *B, size_t N, const float wb[3], const float M[9],
+                      uint8_t *flags = nullptr, bool keepOver = false);
+
+void RU_ApplyExposureEV(float *R, float *G, float *B, int N, float ev);
+void RU_ApplyBlack(float *R, float *G, float *B, int N, float bp);
+void RU_ApplyShadows(float *R, float *G, float *B, int N, float sh);
+
+/// Chromaticity / C-chroma / J-contrast through Lab; clamps to 0..1.
+void RU_ApplyLabOps_OnPlanes(float *R, float *G, float *B, int N,
+                             bool chromaEnabled, float chromaticity,
+                             bool cChromaEnabled, float cChroma,
+                             bool jContrastEnabled, float jContrast);
+
+/// Cheap iterative blur/unsharp standing in for RLD on previews.
+void RU_ApplyPreviewSharpen(float *R, float *G, float *B, int W, int H,
+                            int iters, float radius, float amount, float dampPct);
+
+// MARK: - BGRA8 (sRGB)
+void RU_ApplyLabOps_OnBGRA(uint8_t *bgra, int W, int H,
+                           bool chromaEnabled, float chromaticity,
+                           bool cChromaEnabled, float cChroma,
+                           bool jContrastEnabled, float jContrast);
+
+/// PP3 exposure/black/shadows, applied in linear light.
+void RU_ApplyToneOps_OnBGRA(uint8_t *bgra, int W, int H, const RU_PP3 &P);
+
+void RU_ApplyPreviewSharpen_OnBGRA(uint8_t *bgra, int W, int H,
+                                   int iters, float radius, float amount, float dampPct);
@@ -0,0 +1,225 @@
+/*
+    RawUnravel - RUTrace.cpp
+    ------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RUTrace.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <mutex>
+#if defined(__APPLE__)
+#include <os/signpost.h>
+#endif
+
+std::atomic<bool> gRU_TraceEnabled{true};
+
+uint64_t RU_TraceNowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// MARK: - Rings
+// A slot is the event packed into words, each written and read with relaxed
+// atomics; `seq` is odd while the owner writes slot n (2n+1) and 2n+2 once it
+// is complete, so a reader keeps a copy only if seq was 2n+2 before and after.
+
+static constexpr size_t kRU_TraceWords = 7;
+static constexpr size_t kRU_TraceSlots = 1024;   // per thread; ~64 KB
+
+struct RUTraceSlot {
+    std::atomic<uint64_t> seq{0};
+    std::atomic<uint64_t> w[kRU_TraceWords];
+};
+
+struct RUTraceRing {
+    std::atomic<uint64_t> head{0};      // events ever written
+    std::atomic<bool>     owned{true};  // false once its thread exited: reusable
+    uint32_t              tid = 0;
+    RUTraceSlot           slots[kRU_TraceSlots];
+};
+
+static std::mutex                 gRU_TraceRingsMutex;
+static std::vector<RUTraceRing *> gRU_TraceRings;   // never freed: readers may hold them
+static uint32_t                   gRU_TraceNextTid = 0;
+static std::atomic<uint32_t>      gRU_TraceNextJob{0};
+
+struct RUTraceThread {
+    RUTraceRing *ring = nullptr;
+    uint32_t     job = 0;
+    ~RUTraceThread() { if (ring) ring->owned.store(false, std::memory_order_release); }
+};
+static thread_local RUTraceThread tRU_Trace;
+
+static RUTraceRing *RU_TraceThreadRing() {
+    if (tRU_Trace.ring) return tRU_Trace.ring;
+    std::lock_guard<std::mutex> lk(gRU_TraceRingsMutex);
+    RUTraceRing *ring = nullptr;
+    for (RUTraceRing *r : gRU_TraceRings)
+        if (!r->owned.load(std::memory_order_acquire)) { ring = r; break; }
+    if (!ring) {
+        ring = new RUTraceRing();
+        gRU_TraceRings.push_back(ring);
+    }
+    ring->owned.store(true, std::memory_order_relaxed);
+    ring->tid = ++gRU_TraceNextTid;
+    return tRU_Trace.ring = ring;
+}
+
+void RU_TraceRecord(RUTraceEvent e) {
+    RUTraceRing *ring = RU_TraceThreadRing();
+    e.tid = ring->tid;
+    e.job = tRU_Trace.job;
+    const uint64_t n = ring->head.load(std::memory_order_relaxed);
+    RUTraceSlot &s = ring->slots[n % kRU_TraceSlots];
+    s.seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    const uint64_t w[kRU_TraceWords] = {
+        (uint64_t)(uintptr_t)e.name, (uint64_t)(uintptr_t)e.cat, e.beginNs, e.endNs, e.bytes,
+        (uint64_t)e.tid << 32 | e.job, (uint64_t)e.cache,
+    };
+    for (size_t i = 0; i < kRU_TraceWords; ++i) s.w[i].store(w[i], std::memory_order_relaxed);
+    s.seq.store(2 * n + 2, std::memory_order_release);
+    ring->head.store(n + 1, std::memory_order_release);
+}
+
+// Appends the complete events of `ring` (job 0: all) to `out`.
+static void RU_TraceCopyRing(RUTraceRing &ring, uint32_t job, std::vector<RUTraceEvent> &out) {
+    const uint64_t head = ring.head.load(std::memory_order_acquire);
+    for (uint64_t n = head > kRU_TraceSlots ? head - kRU_TraceSlots : 0; n < head; ++n) {
+        const RUTraceSlot &s = ring.slots[n % kRU_TraceSlots];
+        if (s.seq.load(std::memory_order_acquire) != 2 * n + 2) continue;
+        uint64_t w[kRU_TraceWords];
+        for (size_t i = 0; i < kRU_TraceWords; ++i) w[i] = s.w[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.seq.load(std::memory_order_relaxed) != 2 * n + 2) continue;   // overwritten meanwhile
+
+        RUTraceEvent e;
+        e.job = (uint32_t)w[5];
+        if (job && e.job != job) continue;
+        e.name    = (const char *)(uintptr_t)w[0];
+        e.cat     = (const char *)(uintptr_t)w[1];
+        e.beginNs = w[2];
+        e.endNs   = w[3];
+        e.bytes   = w[4];
+        e.tid     = (uint32_t)(w[5] >> 32);
+        e.cache   = (RUTraceCache)w[6];
+        out.push_back(e);
+    }
+}
+
+static std::vector<RUTraceEvent> RU_TraceCollect(uint32_t job) {
+    std::vector<RUTraceRing *> rings;
+    {
+        std::lock_guard<std::mutex> lk(gRU_TraceRingsMutex);
+        rings = gRU_TraceRings;
+    }
+    std::vector<RUTraceEvent> out;
+    for (RUTraceRing *r : rings) RU_TraceCopyRing(*r, job, out);
+    std::sort(out.begin(), out.end(), [](const RUTraceEvent &a, const RUTraceEvent &b) {
+        return a.beginNs < b.beginNs;
+    });
+    return out;
+}
+
+std::vector<RUTraceEvent> RU_TraceSnapshot() { return RU_TraceCollect(0); }
+
+void RU_TraceClear() {
+    std::lock_guard<std::mutex> lk(gRU_TraceRingsMutex);
+    // Invalidating the slots is enough: readers skip any seq that is not 2n+2.
+    for (RUTraceRing *r : gRU_TraceRings)
+        for (RUTraceSlot &s : r->slots) s.seq.store(0, std::memory_order_relaxed);
+}
+
+// MARK: - Scopes
+
+#if defined(__APPLE__)
+static os_log_t RU_TraceLog() {
+    static os_log_t log = os_log_create("us.r42.rawunravel", "Pipeline");
+    return log;
+}
+#endif
+
+RUTraceScope::RUTraceScope(const char *name, const char *cat, uint64_t bytes)
+    : on_(RU_TraceEnabled())
+{
+    e_.name = name;
+    e_.cat = cat;
+    e_.bytes = bytes;
+#if defined(__APPLE__)
+    if (os_signpost_enabled(RU_TraceLog())) {
+        signpost_ = os_signpost_id_generate(RU_TraceLog());
+        os_signpost_interval_begin(RU_TraceLog(), signpost_, "Stage", "%{public}s", name);
+    }
+#endif
+    if (on_) e_.beginNs = RU_TraceNowNs();
+}
+
+RUTraceScope::~RUTraceScope() {
+    if (on_) {
+        e_.endNs = RU_TraceNowNs();
+        RU_TraceRecord(e_);
+    }
+#if defined(__APPLE__)
+    if (signpost_)
+        os_signpost_interval_end(RU_TraceLog(), signpost_, "Stage", "%{public}s bytes=%llu cache=%d",
+                                 e_.name, (unsigned long long)e_.bytes, (int)e_.cache);
+#endif
+}
+
+RUTraceJob::RUTraceJob()
+    : id_(gRU_TraceNextJob.fetch_add(1, std::memory_order_relaxed) + 1), outer_(tRU_Trace.job) {
+    tRU_Trace.job = id_;
+}
+
+RUTraceJob::~RUTraceJob() { tRU_Trace.job = outer_; }
+
+std::vector<RUTraceEvent> RUTraceJob::events() const { return RU_TraceCollect(id_); }
+
+// MARK: - Chrome trace export
+
+std::string RU_TraceChromeJSON(const std::vector<RUTraceEvent> &events) {
+    const uint64_t t0 = events.empty() ? 0 : events.front().beginNs;
+    std::string s = "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    char buf[256];
+    for (size_t i = 0; i < events.size(); ++i) {
+        const RUTraceEvent &e = events[i];
+        // name/cat are identifiers from the pipeline: nothing to escape
+        snprintf(buf, sizeof buf,
+                 "%s\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, "
+                 "\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"job\": %u, \"bytes\": %" PRIu64 "%s}}",
+                 i ? "," : "", e.name ? e.name : "?", e.cat ? e.cat : "", e.tid,
+                 (e.beginNs - t0) / 1e3, (e.endNs - e.beginNs) / 1e3, e.job, e.bytes,
+                 e.cache == RUTraceCache::Hit ? ", \"cache\": \"hit\""
+                 : e.cache == RUTraceCache::Miss ? ", \"cache\": \"miss\"" : "");
+        s += buf;
+    }
+    s += "\n]}\n";
+    return s;
+}
+
+bool RU_TraceWriteChrome(const char *path) {
+    const std::string json = RU_TraceChromeJSON(RU_TraceSnapshot());
+    FILE *f = path ? fopen(path, "w") : nullptr;
+    if (!f) return false;
+    bool ok = fwrite(json.data(), 1, json.size(), f) == json.size();
+    if (fclose(f) != 0) ok = false;
+    return ok;
+}
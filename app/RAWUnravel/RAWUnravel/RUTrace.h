@@ -0,0 +1,106 @@
+/*
+    RawUnravel - RUTrace.h
+    ----------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Stage tracing for the develop pipeline: begin/end time, bytes touched,
+// thread and cache hit/miss of every stage a render runs.
+//
+// Each thread records into its own fixed ring (no locks, no allocation after
+// the thread's first event); readers copy the rings with a per-slot sequence
+// check, so exporting never blocks a render and a slot overwritten mid-copy
+// is dropped. Recording is two clock reads and a handful of relaxed atomic
+// stores, so it stays on in release builds. Apple builds also emit os_signpost intervals
+// (subsystem us.r42.rawunravel, category Pipeline) for Instruments.
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class RUTraceCache : uint8_t { None, Hit, Miss };
+
+struct RUTraceEvent {
+    const char  *name = nullptr;       // string literal, kept by pointer
+    const char  *cat  = nullptr;       // string literal
+    uint64_t     beginNs = 0, endNs = 0;   // RU_TraceNowNs
+    uint64_t     bytes = 0;            // bytes read + written (estimate); 0 = unknown
+    uint32_t     tid = 0;              // small per-thread id, 1...
+    uint32_t     job = 0;              // RUTraceJob id; 0 outside a job
+    RUTraceCache cache = RUTraceCache::None;
+
+    double seconds() const { return (endNs - beginNs) * 1e-9; }
+};
+
+/// On by default.
+extern std::atomic<bool> gRU_TraceEnabled;
+inline bool RU_TraceEnabled() { return gRU_TraceEnabled.load(std::memory_order_relaxed); }
+inline void RU_TraceSetEnabled(bool on) { gRU_TraceEnabled.store(on, std::memory_order_relaxed); }
+
+/// Monotonic nanoseconds (steady clock).
+uint64_t RU_TraceNowNs();
+
+/// Records a finished event on this thread's ring; tid and job are filled in.
+void RU_TraceRecord(RUTraceEvent e);
+
+/// Times the enclosing block as one event. `name`/`cat` must outlive the
+/// trace (string literals).
+class RUTraceScope {
+public:
+    explicit RUTraceScope(const char *name, const char *cat = "develop", uint64_t bytes = 0);
+    ~RUTraceScope();
+    RUTraceScope(const RUTraceScope &) = delete;
+    RUTraceScope &operator=(const RUTraceScope &) = delete;
+
+    void setBytes(uint64_t bytes) { e_.bytes = bytes; }
+    void setCache(bool hit) { e_.cache = hit ? RUTraceCache::Hit : RUTraceCache::Miss; }
+
+private:
+    RUTraceEvent e_;
+    bool         on_;
+    uint64_t     signpost_ = 0;
+};
+
+/// Tags the events this thread records while it lives with a fresh job id,
+/// so one render's stages can be pulled out of the rings afterwards.
+class RUTraceJob {
+public:
+    RUTraceJob();
+    ~RUTraceJob();
+    RUTraceJob(const RUTraceJob &) = delete;
+    RUTraceJob &operator=(const RUTraceJob &) = delete;
+
+    uint32_t id() const { return id_; }
+    /// This job's events still in the rings, in begin order.
+    std::vector<RUTraceEvent> events() const;
+
+private:
+    uint32_t id_, outer_;
+};
+
+/// Every event still in the rings, in begin order.
+std::vector<RUTraceEvent> RU_TraceSnapshot();
+/// Empties every ring.
+void RU_TraceClear();
+
+/// Chrome trace JSON (chrome://tracing, Perfetto) of `events`.
+std::string RU_TraceChromeJSON(const std::vector<RUTraceEvent> &events);
+/// Writes RU_TraceSnapshot() as Chrome trace JSON. false on I/O errors.
+bool RU_TraceWriteChrome(const char *path);
@@ -32,7 +32,8 @@ import SwiftUI
 /// file imports into the app’s working views. It ensures
 /// that file-provider URLs (iCloud, Files app, AirDrop, etc.)
 /// are safely copied into the app’s tmp directory via `RUImport`
-/// before being opened by the RAW decoder.
+/// (or attached in place when already local) before being opened
+/// by the RAW decoder.
 ///
 /// Use `@EnvironmentObject var router: RawUnravelRouter`
 /// in SwiftUI views to present or dismiss destinations.
@@ -67,10 +68,10 @@ final class RawUnravelRouter: ObservableObject {
     ///   - url: Original file-provider URL (security scoped).
     ///   - displayName: Optional override for display name; defaults to `lastPathComponent`.
     func open(url: URL, displayName: String? = nil) {
-        // Always copy into tmp sandbox before decode (safe, stable path).
+        // Local files are attached in place; provider files are copied into tmp.
         DispatchQueue.global(qos: .userInitiated).async {
             do {
-                let local = try RUImport.copyToTemp(url)
+                let local = try RUImport.prepare(url)
                 DispatchQueue.main.async {
                     // Route to the file screen once safe copy is ready
                     self.destination = .file(local, displayName ?? url.lastPathComponent)
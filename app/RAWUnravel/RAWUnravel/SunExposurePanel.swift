@@ -71,6 +71,7 @@ struct SunExposurePanel: View {
     @Binding var exposure: Float
     @Binding var blackPoint: Float
     @Binding var shadows: Float
+    @Binding var highlightRecovery: Bool
     var onApply: (String) -> Void
 
     // MARK: - Defaults
@@ -85,6 +86,7 @@ struct SunExposurePanel: View {
         Compensation=\(String(format: "%.2f", exposure))
         Black=\(Int(blackPoint))
         Shadows=\(String(format: "%.2f", shadows))
+        HighlightReconstruction=\(highlightRecovery ? "true" : "false")
 
         [RAW]
         """
@@ -172,6 +174,18 @@ struct SunExposurePanel: View {
                 }
             }
 
+            // Highlight reconstruction (inpaints clipped highlights before WB)
+            Toggle(isOn: $highlightRecovery) {
+                ZStack {
+                    Text("Highlight Reconstruction")
+                        .font(.body)
+                        .shadow(color: .white, radius: 0.5, x: 0, y: 0.5)
+                    Text("Highlight Reconstruction")
+                        .foregroundColor(.white)
+                        .offset(x: 1, y: 0.5)
+                }
+            }
+
             // MARK: - Apply Button
             Button("Apply Adjustments") {
                 onApply(currentPP3())
@@ -31,3 +31,6 @@
 // previews from the Objective-C++ implementation.
 
 #import "RTPreviewDecoder.h"
+#import "RUImportCache.h"
+#import "RUThumbnailStore.h"
+#import "RUPrefetcher.h"
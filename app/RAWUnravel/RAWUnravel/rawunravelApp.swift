@@ -39,6 +39,11 @@ import UniformTypeIdentifiers
 struct RawUnravelApp: App {
     @StateObject private var router = RawUnravelRouter()
 
+    init() {
+        // cached planes and pooled buffers go on memory warnings, previews or not
+        RTPreviewDecoder.registerForMemoryWarnings()
+    }
+
     var body: some Scene {
         WindowGroup {
             ContentView()
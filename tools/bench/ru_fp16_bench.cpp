@@ -0,0 +1,126 @@
+/*
+    RawUnravel - ru_fp16_bench.cpp
+    ------------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// FP32 vs FP16 working planes for the preview RLD stage: throughput and the
+// colour error (CIE76 ΔE, sRGB D65) the half-float storage introduces.
+//
+//   cmake --build build --target ru_fp16_bench
+//   build/ru_fp16_bench [width height iterations radius]
+//
+// Run it on the device class you care about: arm64 converts halves in one
+// instruction, x86 needs -mf16c and still pays for every conversion.
+
+#include "RURLD.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+static void fillSynthetic(RUPlanarImage &img) {
+    // smooth gradients + fine detail + noise: something for RLD to sharpen
+    std::mt19937 rng(1234);
+    std::normal_distribution<float> noise(0.f, 0.01f);
+    for (int y = 0; y < img.height; ++y)
+        for (int x = 0; x < img.width; ++x) {
+            const size_t i = (size_t)y * img.width + x;
+            const float gx = (float)x / img.width, gy = (float)y / img.height;
+            const float detail = 0.15f * std::sin(x * 0.7f) * std::sin(y * 0.45f);
+            img.R[i] = std::clamp(0.05f + 0.6f * gx + detail + noise(rng), 0.f, 1.f);
+            img.G[i] = std::clamp(0.05f + 0.5f * gy + detail + noise(rng), 0.f, 1.f);
+            img.B[i] = std::clamp(0.10f + 0.3f * (1.f - gx) + detail + noise(rng), 0.f, 1.f);
+        }
+}
+
+static void copyImage(const RUPlanarImage &src, RUPlanarImage &dst) {
+    dst.allocate(src.width, src.height);
+    std::copy(src.R.get(), src.R.get() + src.pixels(), dst.R.get());
+    std::copy(src.G.get(), src.G.get() + src.pixels(), dst.G.get());
+    std::copy(src.B.get(), src.B.get() + src.pixels(), dst.B.get());
+}
+
+static void linearSRGBToLab(float r, float g, float b, float &L, float &a, float &bb) {
+    const float X = (0.4124f*r + 0.3576f*g + 0.1805f*b) / 0.95047f;
+    const float Y =  0.2126f*r + 0.7152f*g + 0.0722f*b;
+    const float Z = (0.0193f*r + 0.1192f*g + 0.9505f*b) / 1.08883f;
+    auto f = [](float t) { return t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.f / 116.f; };
+    const float fx = f(X), fy = f(Y), fz = f(Z);
+    L = 116.f * fy - 16.f; a = 500.f * (fx - fy); bb = 200.f * (fy - fz);
+}
+
+template <class Fn>
+static double bestOf(int runs, Fn &&fn) {
+    double best = 1e30;
+    for (int k = 0; k < runs; ++k) {
+        const auto t0 = std::chrono::steady_clock::now();
+        fn();
+        const auto t1 = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    const int   W     = argc > 1 ? std::atoi(argv[1]) : 3000;
+    const int   H     = argc > 2 ? std::atoi(argv[2]) : 2000;
+    const int   iters = argc > 3 ? std::atoi(argv[3]) : 20;
+    const float rad   = argc > 4 ? (float)std::atof(argv[4]) : 0.75f;
+    const RURLDParams p { iters, rad, 100.f, 0.f };
+    const double mp = (double)W * H / 1e6;
+
+    RUPlanarImage base;
+    if (!base.allocate(W, H)) { std::fprintf(stderr, "allocation failed\n"); return 1; }
+    fillSynthetic(base);
+
+    RUPlanarImage ref, half;
+    const double t32 = bestOf(3, [&] { copyImage(base, ref); RU_RLDLuma(ref, p); });
+    // FP16 timing includes both stage-boundary conversions, as the preview path pays them
+    const double t16 = bestOf(3, [&] {
+        copyImage(base, half);
+        half.convertTo(RUPrecision::Float16);
+        RU_RLDLuma(half, p);
+        half.convertTo(RUPrecision::Float32);
+    });
+
+    double sum = 0.0, worst = 0.0;
+    std::vector<float> all; all.reserve(ref.pixels());
+    for (size_t i = 0; i < ref.pixels(); ++i) {
+        float L0, a0, b0, L1, a1, b1;
+        linearSRGBToLab(ref.R[i],  ref.G[i],  ref.B[i],  L0, a0, b0);
+        linearSRGBToLab(half.R[i], half.G[i], half.B[i], L1, a1, b1);
+        const float dE = std::sqrt((L0-L1)*(L0-L1) + (a0-a1)*(a0-a1) + (b0-b1)*(b0-b1));
+        sum += dE; worst = std::max(worst, (double)dE); all.push_back(dE);
+    }
+    std::nth_element(all.begin(), all.begin() + all.size() * 99 / 100, all.end());
+    const double p99 = all[all.size() * 99 / 100];
+
+    std::printf("{\"width\":%d,\"height\":%d,\"iterations\":%d,\"radius\":%.2f,\"half_native\":%s,\n"
+                " \"fp32\":{\"seconds\":%.4f,\"mp_per_s\":%.2f},\n"
+                " \"fp16\":{\"seconds\":%.4f,\"mp_per_s\":%.2f},\n"
+                " \"speedup\":%.3f,\n"
+                " \"delta_e76\":{\"mean\":%.4f,\"p99\":%.4f,\"max\":%.4f}}\n",
+                W, H, iters, rad, RU_NATIVE_HALF ? "true" : "false",
+                t32, mp / t32, t16, mp / t16, t32 / t16,
+                sum / (double)ref.pixels(), p99, worst);
+    return 0;
+}
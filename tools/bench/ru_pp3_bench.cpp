@@ -0,0 +1,113 @@
+/*
+    RawUnravel - ru_pp3_bench.cpp
+    -----------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// PP3 parse time for a full RawTherapee-style profile (~40 sections, of
+// which the parser reads seven) and for the snippet the develop screen sends.
+//
+//   cmake --build build --target ru_pp3_bench
+//   build/ru_pp3_bench [profile.pp3]
+
+#include "RUPP3.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+static const char kAppSnippet[] =
+    "[Exposure]\nCompensation=0.70\nBlack=12\nShadows=-20.00\n\n[RAW]\n"
+    "[Color appearance]\nEnabled=true\nAlgorithm=JC\nC-Chroma=10\nC-ChromaEnabled=true\n"
+    "J-Contrast=-5\nJ-ContrastEnabled=true\n\n"
+    "[Luminance Curve]\nEnabled=true\nChromaticity=15\nChromaticityEnabled=true\n\n[RAW]\n"
+    "[Sharpening]\nEnabled=true\nMethod=deconv\nDeconvAmount=75\nDeconvIterations=20\n"
+    "DeconvDamping=0\nDeconvRadius=0.375\n";
+
+// A RawTherapee 5.x neutral profile's shape: many sections, most irrelevant here.
+static std::string fullProfile() {
+    std::string s = "[Version]\nAppVersion=5.11\nVersion=349\n\n[General]\nRank=0\nColorLabel=0\nInTrash=false\n\n";
+    static const char *kOther[] = {
+        "HLRecovery", "Channel Mixer", "Black & White", "Retinex", "Local Contrast", "Vibrance",
+        "Directional Pyramid Equalizer", "Impulse Denoising", "Defringing", "Dehaze",
+        "Directional Pyramid Denoising", "EPD", "FattalToneMapping", "Shadows & Highlights",
+        "Crop", "Coarse Transformation", "Common Properties for Transformations", "Rotation",
+        "Distortion", "LensProfile", "Perspective", "Gradient", "Locallab", "PCVignette",
+        "CACorrection", "Vignetting Correction", "Resize", "PostDemosaicSharpening",
+        "PostResizeSharpening", "Color Management", "Wavelet", "Directional Pyramid Equalizer",
+        "HSV Equalizer", "SoftLight", "Film Simulation", "RGB Curves", "ColorToning",
+        "RAW Bayer", "RAW X-Trans", "MetaData", "Exif", "IPTC",
+    };
+    int n = 0;
+    for (const char *sec : kOther) {
+        s += '['; s += sec; s += "]\n";
+        for (int k = 0; k < 12; ++k) s += "Key" + std::to_string(n++) + "=0;0.5;1;0.25;0.75;\n";
+        s += '\n';
+    }
+    s += "[Exposure]\nAuto=false\nClip=0.02\nCompensation=0.7\nBrightness=0\nContrast=0\n"
+         "Saturation=0\nBlack=12\nHighlightCompr=0\nHighlightComprThreshold=0\nShadowCompr=50\n"
+         "HistogramMatching=false\nCurveFromHistogramMatching=false\nClampOOG=true\n"
+         "CurveMode=Standard\nCurveMode2=Standard\nCurve=0;\nCurve2=0;\n"
+         "HighlightReconstruction=false\nShadows=-20\n\n";
+    s += "[White Balance]\nEnabled=true\nSetting=Camera\nTemperature=6504\nGreen=1\nEqual=1\n"
+         "TemperatureBias=0\nStandard Observer=TWO_DEGREES\nItcwb_green=0\n\n";
+    s += "[Sharpening]\nEnabled=true\nContrast=20\nMethod=rld\nRadius=0.5\nBlurRadius=0.2\n"
+         "Amount=200\nThreshold=20;80;2000;1200;\nOnlyEdges=false\nEdgedetectionRadius=1.9\n"
+         "EdgeTolerance=1800\nHalocontrolEnabled=false\nHalocontrolAmount=85\nDeconvRadius=0.75\n"
+         "DeconvAmount=100\nDeconvDamping=0\nDeconvIterations=30\n\n";
+    s += "[Luminance Curve]\nEnabled=true\nBrightness=0\nContrast=0\nChromaticity=15\n"
+         "Gamutmunse=true\nRedAndSkinTonesProtection=0\nLCredsk=true\nLCurve=0;\naCurve=0;\n\n";
+    s += "[Color appearance]\nEnabled=false\nDegree=90\nAutoDegree=true\nAlgorithm=JC\n"
+         "J-Light=0\nC-Chroma=10\nJ-Contrast=-5\n\n";
+    s += "[RAW]\nDarkFrame=/szeva\nDarkFrameAuto=false\nFlatFieldFile=/szeva\nCA=false\n"
+         "CAAvoidColourshift=true\nCAAutoIterations=2\nCARed=0\nCABlue=0\nHotPixelFilter=false\n"
+         "DeadPixelFilter=false\nHotDeadPixelThresh=100\nPreExposure=1\n";
+    return s;
+}
+
+template <class Fn>
+static double nsPerCall(int calls, Fn &&fn) {
+    double best = 1e30;
+    for (int run = 0; run < 5; ++run) {
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; ++i) fn();
+        const auto t1 = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(t1 - t0).count() / calls);
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    const std::string full = fullProfile();
+    volatile uint64_t sink = 0;
+
+    const double tSnippet = nsPerCall(20000, [&] {
+        RU_PP3 P; RU_ParsePP3(kAppSnippet, sizeof kAppSnippet - 1, P); sink = sink + (uint64_t)P.deconvIter;
+    });
+    const double tFull = nsPerCall(2000, [&] {
+        RU_PP3 P; RU_ParsePP3(full.data(), full.size(), P); sink = sink + (uint64_t)P.deconvIter;
+    });
+    std::printf("app snippet  %6zu B  %8.2f us\n", sizeof kAppSnippet - 1, tSnippet / 1000.0);
+    std::printf("full profile %6zu B  %8.2f us\n", full.size(), tFull / 1000.0);
+
+    if (argc > 1) {
+        const double tFile = nsPerCall(200, [&] { RU_PP3 P; RU_LoadPP3(argv[1], P); sink = sink + (uint64_t)P.deconvIter; });
+        std::printf("%s (mapped)  %8.2f us\n", argv[1], tFile / 1000.0);
+    }
+    return 0;
+}
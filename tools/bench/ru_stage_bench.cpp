@@ -0,0 +1,668 @@
+/*
+    RawUnravel - ru_stage_bench.cpp
+    -------------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Per-stage timings of the develop pipeline as JSON, to diff across commits.
+// Synthetic Bayer and X-Trans mosaics (default 12/24/45/60/100 MP) go through
+// each stage on its own: normalize, demosaic (binning; AMaZE / Markesteijn
+// with the develop library), WB + matrix, RLD (per iteration), tone, pack,
+// Lab and orientation. With the develop library, --corpus also develops real
+// files through RU_RenderFullRes / RU_RenderBinned and splits the time by
+// the phases the render reports.
+//
+// Every stage reports the median of --reps runs as MP/s of its input, its
+// peak RSS (Linux resets VmHWM per run; elsewhere the process peak so far)
+// and the heap (operator new) and RUBufferPool allocations of its first run.
+//
+//   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build -j
+//   build/ru_stage_bench --sizes 12,24 --label "$(git rev-parse --short HEAD)" -o a.json
+//   build/ru_stage_bench --sizes none --corpus ~/raws -o corpus.json
+
+#include "RUBinning.h"
+#include "RUBufferPool.h"
+#include "RUHistogram.h"
+#include "RUPack.h"
+#include "RUPlanarImage.h"
+#include "RURLD.h"
+#include "RUToneOps.h"
+#if defined(RU_BENCH_HAVE_DEVELOP)
+#include "RUDemosaic.h"
+#include "RUDevelop.h"
+#include "RUSession.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+
+using RUClock = std::chrono::steady_clock;
+
+static double RU_Seconds(RUClock::time_point a, RUClock::time_point b) {
+    return std::chrono::duration<double>(b - a).count();
+}
+
+// MARK: - Allocation and memory counters
+
+static std::atomic<uint64_t> gHeapAllocs{0}, gHeapBytes{0};
+
+// The whole replaceable set, so every new has its matching delete: all of
+// them allocate and free through malloc / posix_memalign and free.
+static void *RU_CountedAlloc(std::size_t n, std::size_t align) noexcept {
+    gHeapAllocs.fetch_add(1, std::memory_order_relaxed);
+    gHeapBytes.fetch_add(n, std::memory_order_relaxed);
+    if (n == 0) n = 1;
+    if (align <= alignof(std::max_align_t)) return std::malloc(n);
+    void *p = nullptr;
+    return posix_memalign(&p, align, n) == 0 ? p : nullptr;
+}
+static void *RU_CountedAllocOrThrow(std::size_t n, std::size_t align) {
+    if (void *p = RU_CountedAlloc(n, align)) return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t n) { return RU_CountedAllocOrThrow(n, 0); }
+void *operator new[](std::size_t n) { return RU_CountedAllocOrThrow(n, 0); }
+void *operator new(std::size_t n, std::align_val_t a) { return RU_CountedAllocOrThrow(n, (std::size_t)a); }
+void *operator new[](std::size_t n, std::align_val_t a) { return RU_CountedAllocOrThrow(n, (std::size_t)a); }
+void *operator new(std::size_t n, const std::nothrow_t &) noexcept { return RU_CountedAlloc(n, 0); }
+void *operator new[](std::size_t n, const std::nothrow_t &) noexcept { return RU_CountedAlloc(n, 0); }
+void *operator new(std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept {
+    return RU_CountedAlloc(n, (std::size_t)a);
+}
+void *operator new[](std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept {
+    return RU_CountedAlloc(n, (std::size_t)a);
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+
+struct RUAllocCounts {
+    uint64_t heapAllocs = 0, heapBytes = 0;
+    RUBufferPool::Stats pool;
+};
+
+static RUAllocCounts RU_AllocSnapshot() {
+    RUAllocCounts c;
+    c.heapAllocs = gHeapAllocs.load(std::memory_order_relaxed);
+    c.heapBytes  = gHeapBytes.load(std::memory_order_relaxed);
+    c.pool       = RUBufferPool::shared().stats();
+    return c;
+}
+
+static RUAllocCounts RU_AllocDelta(const RUAllocCounts &a, const RUAllocCounts &b) {
+    RUAllocCounts d;
+    d.heapAllocs = a.heapAllocs - b.heapAllocs;
+    d.heapBytes  = a.heapBytes - b.heapBytes;
+    d.pool.acquires       = a.pool.acquires - b.pool.acquires;
+    d.pool.allocations    = a.pool.allocations - b.pool.allocations;
+    d.pool.allocatedBytes = a.pool.allocatedBytes - b.pool.allocatedBytes;
+    return d;
+}
+
+// Starts a new peak-RSS window where the kernel allows it (Linux: writing 5
+// to clear_refs resets VmHWM).
+static void RU_ResetPeakRSS() {
+    if (FILE *f = fopen("/proc/self/clear_refs", "w")) { fputs("5", f); fclose(f); }
+}
+
+static double RU_PeakRSSMB() {
+    if (FILE *f = fopen("/proc/self/status", "r")) {
+        char line[256];
+        long kb = -1;
+        while (fgets(line, sizeof line, f))
+            if (!strncmp(line, "VmHWM:", 6)) { kb = atol(line + 6); break; }
+        fclose(f);
+        if (kb >= 0) return kb / 1024.0;
+    }
+    struct rusage ru {};
+    getrusage(RUSAGE_SELF, &ru);
+#if defined(__APPLE__)
+    return ru.ru_maxrss / (1024.0 * 1024.0);   // bytes
+#else
+    return ru.ru_maxrss / 1024.0;              // KiB
+#endif
+}
+
+// MARK: - Stage runner
+
+struct RUStageResult {
+    std::string stage;
+    double mp = 0;                    // megapixels the stage consumes
+    bool ok = true;
+    std::vector<double> seconds;      // one per repetition
+    double peakRSSMB = 0;             // max over repetitions
+    RUAllocCounts allocs;             // first repetition
+    std::vector<double> iterSeconds;  // rld: per iteration, last repetition
+};
+
+static double RU_Median(std::vector<double> v) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    const size_t n = v.size();
+    return n % 2 ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+}
+
+// `prepare` (untimed) restores the stage's input before every run.
+static RUStageResult RU_Measure(const char *stage, double mp, int reps,
+                                const std::function<bool()> &run,
+                                const std::function<void()> &prepare = {})
+{
+    RUStageResult r;
+    r.stage = stage;
+    r.mp = mp;
+    r.seconds.reserve(reps);
+    for (int i = 0; i < reps && r.ok; ++i) {
+        if (prepare) prepare();
+        RU_ResetPeakRSS();
+        const RUAllocCounts before = RU_AllocSnapshot();
+        const RUClock::time_point t0 = RUClock::now();
+        r.ok = run();
+        const RUClock::time_point t1 = RUClock::now();
+        if (i == 0) r.allocs = RU_AllocDelta(RU_AllocSnapshot(), before);
+        r.peakRSSMB = std::max(r.peakRSSMB, RU_PeakRSSMB());
+        r.seconds.push_back(RU_Seconds(t0, t1));
+    }
+    fprintf(stderr, "  %-24s %8.3f s\n", stage, RU_Median(r.seconds));
+    return r;
+}
+
+// MARK: - Synthetic input
+
+// LibRaw colours (0=R 1=G 2=B 3=G2).
+static const unsigned char kRU_Bayer[2][2]  = { {0, 1}, {3, 2} };
+static const unsigned char kRU_XTrans[6][6] = {
+    {1, 1, 0, 1, 1, 2}, {1, 1, 2, 1, 1, 0}, {2, 0, 1, 0, 2, 1},
+    {1, 1, 2, 1, 1, 0}, {1, 1, 0, 1, 1, 2}, {0, 2, 1, 2, 0, 1},
+};
+
+// Camera-RGB scene, 0..~1.05: colour gradients, fine detail for RLD, a few
+// clipped highlights, and a cheap LCG for noise.
+struct RUScene {
+    int W, H;
+    std::vector<float> sx, sy;
+    uint32_t seed = 0x9E3779B9u;
+
+    RUScene(int w, int h) : W(w), H(h), sx(w), sy(h) {
+        for (int x = 0; x < W; ++x) sx[x] = std::sin(x * 0.7f);
+        for (int y = 0; y < H; ++y) sy[y] = std::sin(y * 0.45f);
+    }
+    float noise() {
+        seed = seed * 1664525u + 1013904223u;
+        return ((seed >> 9) * (1.f / 8388608.f) - 0.5f) * 0.02f;
+    }
+    float sample(int c, int x, int y) {
+        const float gx = (float)x / W, gy = (float)y / H;
+        const float detail = 0.15f * sx[x] * sy[y];
+        const float base = c == 0 ? 0.05f + 0.6f * gx : c == 2 ? 0.10f + 0.3f * (1.f - gx) : 0.05f + 0.5f * gy;
+        return std::clamp(base + detail + noise(), 0.f, 1.05f);
+    }
+};
+
+struct RUSyntheticMosaic {
+    std::vector<uint16_t> raw;
+    RURawMosaic m;
+};
+
+static void RU_MakeMosaic(bool xtrans, int W, int H, RUSyntheticMosaic &s) {
+    const float black = 512.f, white = 16383.f;
+    RURawMosaic &m = s.m;
+    m.period = xtrans ? 6 : 2;
+    for (int r = 0; r < m.period; ++r)
+        for (int c = 0; c < m.period; ++c)
+            m.cfa[r][c] = xtrans ? kRU_XTrans[r][c] : kRU_Bayer[r][c];
+    for (float &b : m.black) b = black;
+    m.white = white;
+    m.width = m.stride = W;
+    m.height = H;
+
+    s.raw.resize((size_t)W * H);
+    RUScene scene(W, H);
+    for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x) {
+            const int c = m.colorAt(y, x);
+            const float v = scene.sample(c == 3 ? 1 : c, x, y);
+            s.raw[(size_t)y * W + x] = (uint16_t)std::min(65535.f, black + v * (white - black));
+        }
+    m.data = s.raw.data();
+}
+
+// Stand-in for a demosaiced frame when no full-res demosaicer is linked.
+static void RU_FillPlanes(RUPlanarImage &img) {
+    RUScene scene(img.width, img.height);
+    for (int y = 0; y < img.height; ++y)
+        for (int x = 0; x < img.width; ++x) {
+            const size_t i = (size_t)y * img.width + x;
+            img.R[i] = std::min(1.f, scene.sample(0, x, y));
+            img.G[i] = std::min(1.f, scene.sample(1, x, y));
+            img.B[i] = std::min(1.f, scene.sample(2, x, y));
+        }
+}
+
+// MARK: - Options
+
+struct RUBenchOptions {
+    std::vector<double> sizesMP { 12, 24, 45, 60, 100 };
+    bool bayer = true, xtrans = true;
+    int  reps = 3;
+    int  rldIterations = 10;
+    std::string label;
+    std::vector<std::string> corpus;
+    const char *output = nullptr;
+};
+
+static void RU_BenchUsage(FILE *f) {
+    fprintf(f,
+        "usage: ru_stage_bench [options]\n"
+        "  --sizes MP,MP,...|none  synthetic frame sizes (default 12,24,45,60,100)\n"
+        "  --cfa bayer,xtrans      synthetic CFAs (default both)\n"
+        "  --reps N                runs per stage, median reported (default 3)\n"
+        "  --rld-iter N            RLD iterations (default 10)\n"
+        "  --corpus PATH           RAW file or directory (repeatable; develop builds)\n"
+        "  --label TEXT            stored in the JSON, e.g. the commit\n"
+        "  -o FILE                 JSON output (default stdout)\n");
+}
+
+static bool RU_ParseBenchOptions(int argc, char **argv, RUBenchOptions &o) {
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        const char *v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!strcmp(a, "--sizes") && v) {
+            o.sizesMP.clear();
+            if (strcmp(v, "none")) {
+                for (const char *p = v; *p; ) {
+                    char *end = nullptr;
+                    const double mp = strtod(p, &end);
+                    if (end == p || !(mp > 0)) return false;
+                    o.sizesMP.push_back(mp);
+                    p = *end == ',' ? end + 1 : end;
+                }
+            }
+        } else if (!strcmp(a, "--cfa") && v) {
+            o.bayer  = strstr(v, "bayer") != nullptr;
+            o.xtrans = strstr(v, "xtrans") != nullptr;
+            if (!o.bayer && !o.xtrans) return false;
+        } else if (!strcmp(a, "--reps") && v) {
+            if ((o.reps = atoi(v)) < 1) return false;
+        } else if (!strcmp(a, "--rld-iter") && v) {
+            if ((o.rldIterations = atoi(v)) < 0) return false;
+        } else if (!strcmp(a, "--corpus") && v) {
+            o.corpus.push_back(v);
+        } else if (!strcmp(a, "--label") && v) {
+            o.label = v;
+        } else if (!strcmp(a, "-o") && v) {
+            o.output = v;
+        } else {
+            return false;
+        }
+        ++i;
+    }
+    return true;
+}
+
+// MARK: - JSON
+
+static void RU_JSONString(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; *s; ++s) {
+        const unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') fprintf(f, "\\%c", c);
+        else if (c < 0x20)         fprintf(f, "\\u%04x", c);
+        else                       fputc(c, f);
+    }
+    fputc('"', f);
+}
+
+// `extra` appends more members to the stage object.
+static void RU_JSONStage(FILE *f, const RUStageResult &r, const char *indent,
+                         const std::function<void(FILE *)> &extra = {}) {
+    const double med = RU_Median(r.seconds);
+    const double best = r.seconds.empty() ? 0 : *std::min_element(r.seconds.begin(), r.seconds.end());
+    fprintf(f, "%s{\"stage\": ", indent);
+    RU_JSONString(f, r.stage.c_str());
+    fprintf(f, ", \"ok\": %s, \"mp\": %.3f, \"seconds\": %.6f, \"min_seconds\": %.6f, \"mp_per_s\": %.2f,"
+               " \"peak_rss_mb\": %.1f, \"heap_allocs\": %llu, \"heap_bytes\": %llu,"
+               " \"pool_acquires\": %llu, \"pool_allocs\": %llu, \"pool_bytes\": %llu",
+            r.ok ? "true" : "false", r.mp, med, best, (r.ok && med > 0) ? r.mp / med : 0.0,
+            r.peakRSSMB, (unsigned long long)r.allocs.heapAllocs, (unsigned long long)r.allocs.heapBytes,
+            (unsigned long long)r.allocs.pool.acquires, (unsigned long long)r.allocs.pool.allocations,
+            (unsigned long long)r.allocs.pool.allocatedBytes);
+    if (!r.iterSeconds.empty()) {
+        fputs(", \"iter_seconds\": [", f);
+        for (size_t i = 0; i < r.iterSeconds.size(); ++i)
+            fprintf(f, "%s%.6f", i ? ", " : "", r.iterSeconds[i]);
+        fputc(']', f);
+    }
+    if (extra) extra(f);
+    fputc('}', f);
+}
+
+// MARK: - Synthetic stages
+
+static void RU_BenchSynthetic(bool xtrans, double sizeMP, const RUBenchOptions &o, FILE *f, bool first) {
+    // 3:2 frame, both sides multiples of 6 so either CFA tiles it
+    int W = (int)std::lround(std::sqrt(sizeMP * 1e6 * 1.5) / 6.0) * 6;
+    int H = (int)std::lround(W / 1.5 / 6.0) * 6;
+    W = std::max(W, 48); H = std::max(H, 48);
+    const size_t N = (size_t)W * H;
+    const double MP = N / 1e6;
+    const int reps = o.reps;
+    fprintf(stderr, "%s %dx%d (%.1f MP)\n", xtrans ? "xtrans" : "bayer", W, H, MP);
+
+    std::vector<RUStageResult> stages;
+    RUSyntheticMosaic mosaic;
+    RU_MakeMosaic(xtrans, W, H, mosaic);
+    const RURawMosaic &m = mosaic.m;
+
+    RUPooled<float> mono(N);
+    if (!mono) { fprintf(stderr, "  out of memory\n"); return; }
+    stages.push_back(RU_Measure("normalize", MP, reps, [&] { return RU_NormalizeMosaic(m, mono.get()); }));
+
+    // ---- demosaic: binning engines (previews), full-res engines ----
+    if (!xtrans)
+        stages.push_back(RU_Measure("demosaic.superpixel2x2", MP, reps, [&] {
+            RUPlanarImage out;
+            return RU_BayerSuperpixel2x2(m, out);
+        }));
+    for (const int factor : { 2, 3, 4 }) {
+        const std::string name = "demosaic.bin" + std::to_string(factor);
+        stages.push_back(RU_Measure(name.c_str(), MP, reps, [&] {
+            RUPlanarImage out;
+            return RU_BinMosaic(m, factor, out);
+        }));
+    }
+
+    RUPlanarImage base, img;   // stage input (restored before each run) and working copy
+    if (!base.allocate(W, H)) { fprintf(stderr, "  out of memory\n"); return; }
+    bool demosaiced = false;
+#if defined(RU_BENCH_HAVE_DEVELOP)
+    if (!xtrans) {
+        unsigned cf4[4];
+        for (int k = 0; k < 4; ++k) { const unsigned c = m.cfa[k >> 1][k & 1]; cf4[k] = c == 3 ? 1 : c; }
+        stages.push_back(RU_Measure("demosaic.amaze", MP, reps, [&] {
+            return bridge_amaze_demosaic(mono.get(), W, H, cf4, base.R.get(), base.G.get(), base.B.get()) == 0;
+        }));
+        demosaiced = stages.back().ok;
+    } else {
+        RUPooled<float> P[3] = { RUPooled<float>(N), RUPooled<float>(N), RUPooled<float>(N) };
+        unsigned xp[6][6];
+        for (int r = 0; r < 6; ++r) for (int c = 0; c < 6; ++c) xp[r][c] = m.cfa[r][c];
+        if (P[0] && P[1] && P[2]) {
+            for (int y = 0; y < H; ++y)
+                for (int x = 0; x < W; ++x) {
+                    const size_t i = (size_t)y * W + x;
+                    const int c = m.colorAt(y, x);
+                    for (int k = 0; k < 3; ++k) P[k][i] = (k == c) ? mono[i] : 0.f;
+                }
+            stages.push_back(RU_Measure("demosaic.markesteijn", MP, reps, [&] {
+                return bridge_xtrans_demosaic(P[0].get(), P[1].get(), P[2].get(), W, H, xp,
+                                              base.R.get(), base.G.get(), base.B.get()) == 0;
+            }));
+            demosaiced = stages.back().ok;
+        }
+    }
+#endif
+    mono.reset();
+    mosaic.raw = std::vector<uint16_t>();
+    if (!demosaiced) RU_FillPlanes(base);
+
+    auto restore = [&] { img.copyFrom(base); };
+
+    // ---- WB + camera matrix (a typical daylight as-shot WB and rgb_cam) ----
+    static const float kWB[3] = { 2.1f, 1.f, 1.45f };
+    static const float kCam[9] = { 1.62f, -0.48f, -0.14f, -0.21f, 1.52f, -0.31f, 0.02f, -0.47f, 1.45f };
+    RUPooled<uint8_t> flags(N);
+    stages.push_back(RU_Measure("wb_matrix", MP, reps, [&] {
+        RU_ApplyWBMatrix(img.R.get(), img.G.get(), img.B.get(), N, kWB, kCam, flags.get());
+        return true;
+    }, restore));
+    base.copyFrom(img);
+
+    // ---- RLD (export path: FP32 planes) ----
+    const RURLDParams rp { o.rldIterations, 0.75f, 100.f, 0.f };
+    std::vector<double> iters;
+    iters.reserve(o.rldIterations);
+    RUClock::time_point tIter;
+    RUStageResult rld = RU_Measure("rld", MP, reps, [&] {
+        iters.clear();
+        tIter = RUClock::now();
+        RU_RLDLuma(img, rp, [&](int, int) {
+            const RUClock::time_point t = RUClock::now();
+            iters.push_back(RU_Seconds(tIter, t));
+            tIter = t;
+        });
+        return true;
+    }, restore);
+    rld.iterSeconds = iters;
+    stages.push_back(std::move(rld));
+    base.copyFrom(img);
+
+    // ---- tone ----
+    stages.push_back(RU_Measure("tone", MP, reps, [&] {
+        RU_ApplyExposureEV(img.R.get(), img.G.get(), img.B.get(), (int)N, 0.5f);
+        RU_ApplyBlack     (img.R.get(), img.G.get(), img.B.get(), (int)N, 0.01f);
+        RU_ApplyShadows   (img.R.get(), img.G.get(), img.B.get(), (int)N, 20.f);
+        return true;
+    }, restore));
+    base.copyFrom(img);
+
+    // ---- pack BGRA8 (display histogram on the way) ----
+    RUHistogram hist(256);
+    RUPooled<uint8_t> bgraRef;
+    stages.push_back(RU_Measure("pack.bgra8", MP, reps, [&] {
+        RUPackTarget t;
+        t.histogram = &hist;
+        if (!t.allocate(W, H)) return false;
+        RU_PackRows(t, base.R.get(), base.G.get(), base.B.get(), (size_t)W, 0, H, flags.get());
+        bgraRef = std::move(t.pixels);
+        return true;
+    }));
+
+    // ---- Lab (on the packed BGRA, as the preview does) ----
+    RUPooled<uint8_t> bgra(N * 4);
+    if (bgraRef && bgra) {
+        stages.push_back(RU_Measure("lab", MP, reps, [&] {
+            RU_ApplyLabOps_OnBGRA(bgra.get(), W, H, true, 20.f, true, 10.f, true, 10.f);
+            return true;
+        }, [&] { memcpy(bgra.get(), bgraRef.get(), N * 4); }));
+    }
+    bgra.reset();
+    bgraRef.reset();
+
+    // ---- pack RGB16 (export); orientation = the same pack rotating 90° ----
+    for (const int exif : { 1, 6 }) {
+        stages.push_back(RU_Measure(exif == 1 ? "pack.rgb16" : "orientation", MP, reps, [&] {
+            RUPackTarget t;
+            t.format = RUPackTarget::RGB16;
+            t.exif = exif;
+            if (!t.allocate(W, H)) return false;
+            RU_PackRows(t, base.R.get(), base.G.get(), base.B.get(), (size_t)W, 0, H);
+            return true;
+        }));
+    }
+
+    fprintf(f, "%s\n    {\"cfa\": \"%s\", \"width\": %d, \"height\": %d, \"mp\": %.3f, \"full_res_demosaic\": %s,\n"
+               "     \"stages\": [\n",
+            first ? "" : ",", xtrans ? "xtrans" : "bayer", W, H, MP, demosaiced ? "true" : "false");
+    for (size_t i = 0; i < stages.size(); ++i) {
+        RU_JSONStage(f, stages[i], "       ");
+        fputs(i + 1 < stages.size() ? ",\n" : "\n", f);
+    }
+    fputs("     ]}", f);
+}
+
+// MARK: - Corpus
+#if defined(RU_BENCH_HAVE_DEVELOP)
+
+static void RU_CollectCorpus(const std::string &path, std::vector<std::string> &files) {
+    struct stat st {};
+    if (stat(path.c_str(), &st) != 0) { fprintf(stderr, "%s: not found\n", path.c_str()); return; }
+    if (!S_ISDIR(st.st_mode)) { files.push_back(path); return; }
+    std::vector<std::string> found;
+    if (DIR *d = opendir(path.c_str())) {
+        while (const dirent *e = readdir(d)) {
+            const std::string name = e->d_name;
+            if (name.empty() || name[0] == '.') continue;
+            const size_t dot = name.rfind('.');
+            const std::string ext = dot == std::string::npos ? "" : name.substr(dot);
+            if (ext == ".pp3" || ext == ".json" || ext == ".xmp") continue;
+            const std::string full = path + "/" + name;
+            if (stat(full.c_str(), &st) == 0 && S_ISREG(st.st_mode)) found.push_back(full);
+        }
+        closedir(d);
+    }
+    std::sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+}
+
+// Time between consecutive progress posts, summed per "phase.step" (the
+// phase and step strings are literals in the pipeline: compared by value,
+// kept by pointer, so the hook itself allocates nothing).
+struct RUPhaseClock {
+    struct Phase { const char *phase, *step; double seconds; };
+    std::vector<Phase> phases;
+    const char *phase = nullptr, *step = nullptr;
+    RUClock::time_point since;
+
+    void start() { phases.clear(); phase = step = nullptr; since = RUClock::now(); }
+    void mark(const char *p, const char *s) {
+        const RUClock::time_point now = RUClock::now();
+        if (phase) {
+            auto it = std::find_if(phases.begin(), phases.end(), [&](const Phase &x) {
+                return !strcmp(x.phase, phase) && !strcmp(x.step, step);
+            });
+            if (it != phases.end()) it->seconds += RU_Seconds(since, now);
+            else if (phases.size() < phases.capacity()) phases.push_back({ phase, step, RU_Seconds(since, now) });
+        }
+        phase = p; step = s; since = now;
+    }
+};
+
+static void RU_BenchFile(const std::string &file, const RUBenchOptions &o, FILE *f, bool first) {
+    int W = 0, H = 0;
+    if (!RU_RawActiveSize(file.c_str(), W, H)) { fprintf(stderr, "%s: not a RAW LibRaw opens\n", file.c_str()); return; }
+    fprintf(stderr, "%s %dx%d\n", file.c_str(), W, H);
+    const double MP = (double)W * H / 1e6;
+
+    RU_PP3 P;
+    const std::string pp3 = file + ".pp3";
+    const bool havePP3 = RU_LoadPP3(pp3.c_str(), P);
+
+    RUPhaseClock clock;
+    clock.phases.reserve(64);
+    RUJobHooks job;
+    job.progress = [&clock](const char *phase, const char *step, int, int) { clock.mark(phase, step); };
+    // A fresh session per run: otherwise later runs reuse cached preview stages.
+    auto fresh = [&] { RU_EndSession(file.c_str()); };
+
+    struct Render { RUStageResult result; std::vector<RUPhaseClock::Phase> phases; };
+    std::vector<Render> renders;
+    renders.push_back({ RU_Measure("full", MP, o.reps, [&] {
+        RUPackTarget out;
+        out.format = RUPackTarget::RGB16;
+        out.exif = 0;
+        clock.start();
+        const bool ok = RU_RenderFullRes(file.c_str(), P, job, out);
+        clock.mark(nullptr, nullptr);
+        return ok;
+    }, fresh), clock.phases });
+    renders.push_back({ RU_Measure("bin2", MP, o.reps, [&] {
+        RUPackTarget out;
+        clock.start();
+        const bool ok = RU_RenderBinned(file.c_str(), P, 2, job, out);
+        clock.mark(nullptr, nullptr);
+        return ok;
+    }, fresh), clock.phases });
+    RU_EndSession(file.c_str());
+
+    fprintf(f, "%s\n    {\"file\": ", first ? "" : ",");
+    RU_JSONString(f, file.c_str());
+    fprintf(f, ", \"width\": %d, \"height\": %d, \"pp3\": %s,\n     \"renders\": [\n", W, H, havePP3 ? "true" : "false");
+    for (size_t i = 0; i < renders.size(); ++i) {
+        const Render &r = renders[i];
+        RU_JSONStage(f, r.result, "       ", [&r](FILE *f) {   // phases of the last repetition
+            fputs(", \"phases\": {", f);
+            for (size_t k = 0; k < r.phases.size(); ++k) {
+                const std::string key = std::string(r.phases[k].phase) + "." + r.phases[k].step;
+                fputs(k ? ", " : "", f);
+                RU_JSONString(f, key.c_str());
+                fprintf(f, ": %.6f", r.phases[k].seconds);
+            }
+            fputc('}', f);
+        });
+        fputs(i + 1 < renders.size() ? ",\n" : "\n", f);
+    }
+    fputs("     ]}", f);
+}
+#endif
+
+// MARK: - Main
+
+int main(int argc, char **argv) {
+    RUBenchOptions o;
+    if (argc > 1 && (!strcmp(argv[1], "-h") || !strcmp(argv[1], "--help"))) { RU_BenchUsage(stdout); return 0; }
+    if (!RU_ParseBenchOptions(argc, argv, o)) { RU_BenchUsage(stderr); return 2; }
+#if !defined(RU_BENCH_HAVE_DEVELOP)
+    if (!o.corpus.empty()) { fprintf(stderr, "--corpus needs a build with LibRaw and librtprocess\n"); return 2; }
+#endif
+    FILE *f = o.output ? fopen(o.output, "w") : stdout;
+    if (!f) { perror(o.output); return 1; }
+
+    fputs("{\"bench\": \"ru_stage_bench\", \"label\": ", f);
+    RU_JSONString(f, o.label.c_str());
+    fprintf(f, ", \"threads\": %u, \"reps\": %d, \"rld_iterations\": %d,\n \"synthetic\": [",
+            std::thread::hardware_concurrency(), o.reps, o.rldIterations);
+    bool first = true;
+    for (const double mp : o.sizesMP) {
+        if (o.bayer)  { RU_BenchSynthetic(false, mp, o, f, first); first = false; }
+        if (o.xtrans) { RU_BenchSynthetic(true,  mp, o, f, first); first = false; }
+        RUBufferPool::shared().trim();
+    }
+    fputs("\n ],\n \"corpus\": [", f);
+#if defined(RU_BENCH_HAVE_DEVELOP)
+    std::vector<std::string> files;
+    for (const std::string &p : o.corpus) RU_CollectCorpus(p, files);
+    first = true;
+    for (const std::string &file : files) { RU_BenchFile(file, o, f, first); first = false; }
+#endif
+    fputs("\n ]}\n", f);
+    if (f != stdout) fclose(f);
+    return 0;
+}
@@ -0,0 +1,340 @@
+/*
+    RawUnravel - rawunravel-cli.cpp
+    -------------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Develops a RAW with an optional PP3 through the full-res pipeline
+// (RU_RenderFullRes, same as the app's export) and writes a TIFF or PNG.
+//
+//   rawunravel-cli IMG.RAF -p IMG.RAF.pp3 -o out.tif
+//   rawunravel-cli IMG.CR3 -o out.png --depth 8 --long-edge 2048
+//
+// TIFF is uncompressed 8/16-bit RGB in host byte order; PNG needs zlib.
+// Pixels are sRGB-encoded (--linear: linear light) with the orientation baked.
+
+#include "RUDevelop.h"
+#include "RUPack.h"
+#include "RUPP3.h"
+#include "RUSession.h"
+#include "RUTrace.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#if defined(RU_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+struct RUCliOptions {
+    const char *input = nullptr;
+    const char *pp3 = nullptr;
+    const char *output = nullptr;
+    const char *trace = nullptr;
+    int   depth = 16;
+    int   longEdge = 0;
+    bool  linear = false;
+    bool  verbose = false;
+    float crop[4] = {0.f, 0.f, 1.f, 1.f};
+};
+
+static void RU_CliUsage(FILE *f) {
+    fprintf(f,
+        "usage: rawunravel-cli RAW [-p PP3] -o OUT.tif|OUT.png [options]\n"
+        "  -p, --pp3 FILE        develop settings (default: none)\n"
+        "  -o, --output FILE     .tif/.tiff or .png\n"
+        "  --depth 8|16          bits per channel (default 16)\n"
+        "  --long-edge N         downscale so the long edge is at most N\n"
+        "  --crop x0,y0,x1,y1    normalized crop in output orientation\n"
+        "  --linear              linear light instead of the sRGB curve\n"
+        "  --band-rows N         rows per full-res band (0: whole frame)\n"
+        "  --trace FILE          write the stage trace as Chrome trace JSON\n"
+        "  -v, --verbose         print progress and stage timings to stderr\n");
+}
+
+// Per-stage totals of the last render of `path`, slowest first.
+static void RU_CliPrintTimings(const char *path) {
+    const std::shared_ptr<RUSession> s = RU_SessionForPath(path);
+    const std::shared_ptr<const RUSession::Timings> t = s ? s->timings() : nullptr;
+    if (!t) return;
+    struct Total { const char *name; double seconds; uint64_t bytes; int count; };
+    std::vector<Total> totals;
+    for (const RUTraceEvent &e : *t) {
+        auto it = std::find_if(totals.begin(), totals.end(),
+                               [&](const Total &x) { return !strcmp(x.name, e.name); });
+        if (it == totals.end()) it = totals.insert(totals.end(), Total { e.name, 0.0, 0, 0 });
+        it->seconds += e.seconds();
+        it->bytes   += e.bytes;
+        it->count   += 1;
+    }
+    std::sort(totals.begin(), totals.end(), [](const Total &a, const Total &b) { return a.seconds > b.seconds; });
+    for (const Total &x : totals)
+        fprintf(stderr, "  %-18s %9.3f ms  x%-4d %8.1f MB\n", x.name, x.seconds * 1e3, x.count, x.bytes / 1e6);
+}
+
+static bool RU_HasSuffix(const char *s, const char *suffix) {
+    const size_t n = strlen(s), m = strlen(suffix);
+    if (n < m) return false;
+    for (size_t i = 0; i < m; ++i)
+        if (tolower((unsigned char)s[n - m + i]) != suffix[i]) return false;
+    return true;
+}
+
+static bool RU_ParseOptions(int argc, char **argv, RUCliOptions &o) {
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        auto value = [&]() -> const char * { return i + 1 < argc ? argv[++i] : nullptr; };
+        if (!strcmp(a, "-p") || !strcmp(a, "--pp3")) {
+            if (!(o.pp3 = value())) return false;
+        } else if (!strcmp(a, "-o") || !strcmp(a, "--output")) {
+            if (!(o.output = value())) return false;
+        } else if (!strcmp(a, "--depth")) {
+            const char *v = value();
+            if (!v) return false;
+            o.depth = atoi(v);
+            if (o.depth != 8 && o.depth != 16) return false;
+        } else if (!strcmp(a, "--long-edge")) {
+            const char *v = value();
+            if (!v || (o.longEdge = atoi(v)) < 0) return false;
+        } else if (!strcmp(a, "--crop")) {
+            const char *v = value();
+            float c[4];
+            if (!v || sscanf(v, "%f,%f,%f,%f", &c[0], &c[1], &c[2], &c[3]) != 4) return false;
+            if (!(0.f <= c[0] && c[0] < c[2] && c[2] <= 1.f && 0.f <= c[1] && c[1] < c[3] && c[3] <= 1.f))
+                return false;
+            memcpy(o.crop, c, sizeof c);
+        } else if (!strcmp(a, "--linear")) {
+            o.linear = true;
+        } else if (!strcmp(a, "--band-rows")) {
+            const char *v = value();
+            if (!v || atoi(v) < 0) return false;
+            gRU_FullResBandRows.store(atoi(v), std::memory_order_relaxed);
+        } else if (!strcmp(a, "--trace")) {
+            if (!(o.trace = value())) return false;
+        } else if (!strcmp(a, "-v") || !strcmp(a, "--verbose")) {
+            o.verbose = true;
+        } else if (a[0] == '-' && a[1]) {
+            return false;
+        } else if (!o.input) {
+            o.input = a;
+        } else {
+            return false;
+        }
+    }
+    return o.input && o.output;
+}
+
+// MARK: - Writers
+// `rgb16` is out.pixels of an RGB16 target: W×H×3 host-endian uint16.
+
+static uint8_t RU_To8(uint16_t v) { return (uint8_t)((v * 255u + 32767u) / 65535u); }
+
+// Baseline TIFF, one uncompressed strip, written in host byte order.
+static bool RU_WriteTIFF(const char *path, const uint16_t *rgb16, int W, int H, int depth) {
+    const uint64_t dataBytes = (uint64_t)W * H * 3 * (depth / 8);
+    if (dataBytes > 0xFFFFFFF0ull) { fprintf(stderr, "image too large for a baseline TIFF\n"); return false; }
+    FILE *f = fopen(path, "wb");
+    if (!f) { perror(path); return false; }
+
+    const uint16_t one = 1;
+    const bool little = *(const uint8_t *)&one == 1;
+    struct Entry { uint16_t tag, type; uint32_t count, value; };
+    enum : uint16_t { SHORT = 3, LONG = 4 };
+    const uint16_t kEntries = 11;
+    const uint32_t ifdOffset = 8;
+    const uint32_t bpsOffset = ifdOffset + 2 + kEntries * 12 + 4;
+    const uint32_t dataOffset = bpsOffset + 8;
+    // SHORT values sit in the first two bytes of the value field.
+    auto shortValue = [&](uint16_t v) -> uint32_t {
+        uint32_t field = 0;
+        memcpy(&field, &v, sizeof v);
+        return field;
+    };
+    const Entry entries[kEntries] = {
+        { 256, LONG,  1, (uint32_t)W },                 // ImageWidth
+        { 257, LONG,  1, (uint32_t)H },                 // ImageLength
+        { 258, SHORT, 3, bpsOffset },                   // BitsPerSample
+        { 259, SHORT, 1, shortValue(1) },               // Compression: none
+        { 262, SHORT, 1, shortValue(2) },               // Photometric: RGB
+        { 273, LONG,  1, dataOffset },                  // StripOffsets
+        { 274, SHORT, 1, shortValue(1) },               // Orientation: baked
+        { 277, SHORT, 1, shortValue(3) },               // SamplesPerPixel
+        { 278, LONG,  1, (uint32_t)H },                 // RowsPerStrip
+        { 279, LONG,  1, (uint32_t)dataBytes },         // StripByteCounts
+        { 284, SHORT, 1, shortValue(1) },               // PlanarConfiguration: chunky
+    };
+
+    bool ok = fwrite(little ? "II" : "MM", 1, 2, f) == 2;
+    const uint16_t magic = 42;
+    ok = ok && fwrite(&magic, 2, 1, f) == 1 && fwrite(&ifdOffset, 4, 1, f) == 1;
+    ok = ok && fwrite(&kEntries, 2, 1, f) == 1;
+    for (const Entry &e : entries)
+        ok = ok && fwrite(&e.tag, 2, 1, f) == 1 && fwrite(&e.type, 2, 1, f) == 1
+                && fwrite(&e.count, 4, 1, f) == 1 && fwrite(&e.value, 4, 1, f) == 1;
+    const uint32_t nextIFD = 0;
+    const uint16_t bps[4] = { (uint16_t)depth, (uint16_t)depth, (uint16_t)depth, 0 };
+    ok = ok && fwrite(&nextIFD, 4, 1, f) == 1 && fwrite(bps, 2, 4, f) == 4;
+
+    const size_t rowSamples = (size_t)W * 3;
+    if (depth == 16) {
+        ok = ok && fwrite(rgb16, 2, rowSamples * H, f) == rowSamples * H;
+    } else {
+        std::vector<uint8_t> row(rowSamples);
+        for (int y = 0; ok && y < H; ++y) {
+            const uint16_t *src = rgb16 + rowSamples * y;
+            for (size_t i = 0; i < rowSamples; ++i) row[i] = RU_To8(src[i]);
+            ok = fwrite(row.data(), 1, rowSamples, f) == rowSamples;
+        }
+    }
+    if (fclose(f) != 0) ok = false;
+    if (!ok) fprintf(stderr, "%s: write failed\n", path);
+    return ok;
+}
+
+#if defined(RU_HAVE_ZLIB)
+static void RU_PutBE32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16); p[2] = (uint8_t)(v >> 8); p[3] = (uint8_t)v;
+}
+
+static bool RU_PNGChunk(FILE *f, const char type[4], const uint8_t *data, uint32_t len) {
+    uint8_t head[8];
+    RU_PutBE32(head, len);
+    memcpy(head + 4, type, 4);
+    uLong crc = crc32(0L, (const Bytef *)type, 4);
+    if (len) crc = crc32(crc, data, len);
+    uint8_t tail[4];
+    RU_PutBE32(tail, (uint32_t)crc);
+    return fwrite(head, 1, 8, f) == 8 && (!len || fwrite(data, 1, len, f) == len)
+        && fwrite(tail, 1, 4, f) == 4;
+}
+
+// RGB PNG, filter 0 on every row, deflated one row at a time into IDAT chunks.
+static bool RU_WritePNG(const char *path, const uint16_t *rgb16, int W, int H, int depth) {
+    FILE *f = fopen(path, "wb");
+    if (!f) { perror(path); return false; }
+    static const uint8_t kSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    uint8_t ihdr[13];
+    RU_PutBE32(ihdr, (uint32_t)W);
+    RU_PutBE32(ihdr + 4, (uint32_t)H);
+    ihdr[8] = (uint8_t)depth; ihdr[9] = 2; ihdr[10] = ihdr[11] = ihdr[12] = 0;
+    bool ok = fwrite(kSignature, 1, 8, f) == 8 && RU_PNGChunk(f, "IHDR", ihdr, sizeof ihdr);
+
+    z_stream z {};
+    ok = ok && deflateInit(&z, 6) == Z_OK;
+    const size_t rowSamples = (size_t)W * 3;
+    std::vector<uint8_t> row(1 + rowSamples * (depth / 8));
+    std::vector<uint8_t> chunk(1 << 18);
+    auto pump = [&](int flush) {
+        do {
+            z.next_out = chunk.data();
+            z.avail_out = (uInt)chunk.size();
+            const int rc = deflate(&z, flush);
+            if (rc == Z_STREAM_ERROR) return false;
+            const uint32_t have = (uint32_t)(chunk.size() - z.avail_out);
+            if (have && !RU_PNGChunk(f, "IDAT", chunk.data(), have)) return false;
+        } while (z.avail_out == 0);
+        return true;
+    };
+    for (int y = 0; ok && y < H; ++y) {
+        const uint16_t *src = rgb16 + rowSamples * y;
+        row[0] = 0;
+        if (depth == 16) {
+            for (size_t i = 0; i < rowSamples; ++i) {
+                row[1 + 2 * i]     = (uint8_t)(src[i] >> 8);   // PNG samples are big-endian
+                row[1 + 2 * i + 1] = (uint8_t)src[i];
+            }
+        } else {
+            for (size_t i = 0; i < rowSamples; ++i) row[1 + i] = RU_To8(src[i]);
+        }
+        z.next_in = row.data();
+        z.avail_in = (uInt)row.size();
+        ok = pump(Z_NO_FLUSH);
+    }
+    ok = ok && pump(Z_FINISH);
+    deflateEnd(&z);
+    ok = ok && RU_PNGChunk(f, "IEND", nullptr, 0);
+    if (fclose(f) != 0) ok = false;
+    if (!ok) fprintf(stderr, "%s: write failed\n", path);
+    return ok;
+}
+#endif
+
+// MARK: - Main
+
+int main(int argc, char **argv) {
+    RUCliOptions o;
+    if (argc > 1 && (!strcmp(argv[1], "-h") || !strcmp(argv[1], "--help"))) { RU_CliUsage(stdout); return 0; }
+    if (!RU_ParseOptions(argc, argv, o)) { RU_CliUsage(stderr); return 2; }
+
+    const bool png = RU_HasSuffix(o.output, ".png");
+    if (!png && !RU_HasSuffix(o.output, ".tif") && !RU_HasSuffix(o.output, ".tiff")) {
+        fprintf(stderr, "%s: output must be .tif, .tiff or .png\n", o.output);
+        return 2;
+    }
+#if !defined(RU_HAVE_ZLIB)
+    if (png) { fprintf(stderr, "PNG output needs a build with zlib\n"); return 2; }
+#endif
+    if (!RU_RawAvailable(o.input)) { fprintf(stderr, "%s: no such file\n", o.input); return 1; }
+
+    RU_PP3 P;
+    if (o.pp3 && !RU_LoadPP3(o.pp3, P)) { fprintf(stderr, "%s: cannot read PP3\n", o.pp3); return 1; }
+
+    RUPackTarget out;
+    out.format   = RUPackTarget::RGB16;
+    out.linear   = o.linear;
+    out.exif     = 0;   // the file's orientation
+    out.longEdge = o.longEdge;
+    memcpy(out.crop, o.crop, sizeof o.crop);
+
+    RUJobHooks job;
+    if (o.verbose) {
+        job.progress = [](const char *phase, const char *step, int iter, int total) {
+            if (total > 0) fprintf(stderr, "%s %s %d/%d\n", phase, step, iter, total);
+            else           fprintf(stderr, "%s %s\n", phase, step);
+        };
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    if (!RU_RenderFullRes(o.input, P, job, out)) { fprintf(stderr, "%s: develop failed\n", o.input); return 1; }
+    const auto t1 = std::chrono::steady_clock::now();
+
+    const int W = out.outWidth(), H = out.outHeight();
+    const uint16_t *rgb16 = reinterpret_cast<const uint16_t *>(out.pixels.get());
+    bool ok;
+#if defined(RU_HAVE_ZLIB)
+    ok = png ? RU_WritePNG(o.output, rgb16, W, H, o.depth) : RU_WriteTIFF(o.output, rgb16, W, H, o.depth);
+#else
+    ok = RU_WriteTIFF(o.output, rgb16, W, H, o.depth);
+#endif
+    const auto t2 = std::chrono::steady_clock::now();
+    if (o.verbose) {
+        const double dev = std::chrono::duration<double>(t1 - t0).count();
+        const double wr  = std::chrono::duration<double>(t2 - t1).count();
+        fprintf(stderr, "%dx%d: develop %.3f s (%.1f MP/s), write %.3f s\n",
+                W, H, dev, (double)W * H / 1e6 / (dev > 0 ? dev : 1e-9), wr);
+        RU_CliPrintTimings(o.input);
+    }
+    if (o.trace && !RU_TraceWriteChrome(o.trace)) { perror(o.trace); ok = false; }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+/*
+    RawUnravel - ru_synth_dng.cpp
+    -----------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Writes a small synthetic Bayer DNG (RGGB, 12-bit in 16-bit samples,
+// uncompressed, camera = linear sRGB under D65) for the CLI smoke test:
+//
+//   ru_synth_dng out.dng [width height]
+//
+// The scene is a grey ramp, colour patches and a blown highlight, so the
+// pipeline gets neutral, saturated and clipped areas to work on.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// MARK: - TIFF writer (little endian)
+
+namespace {
+
+enum : uint16_t { kByte = 1, kAscii = 2, kShort = 3, kLong = 4, kRational = 5, kSRational = 10 };
+
+struct RUDNGEntry {
+    uint16_t tag, type;
+    uint32_t count;
+    std::vector<uint8_t> bytes;   // payload, little endian
+};
+
+void put16(std::vector<uint8_t> &v, uint32_t x) { v.push_back(x & 0xFF); v.push_back(x >> 8 & 0xFF); }
+void put32(std::vector<uint8_t> &v, uint32_t x) { put16(v, x & 0xFFFF); put16(v, x >> 16); }
+
+RUDNGEntry shorts(uint16_t tag, std::initializer_list<uint32_t> vs) {
+    RUDNGEntry e { tag, kShort, (uint32_t)vs.size(), {} };
+    for (uint32_t x : vs) put16(e.bytes, x);
+    return e;
+}
+RUDNGEntry longs(uint16_t tag, std::initializer_list<uint32_t> vs) {
+    RUDNGEntry e { tag, kLong, (uint32_t)vs.size(), {} };
+    for (uint32_t x : vs) put32(e.bytes, x);
+    return e;
+}
+RUDNGEntry bytes(uint16_t tag, std::initializer_list<uint8_t> vs) {
+    return { tag, kByte, (uint32_t)vs.size(), std::vector<uint8_t>(vs) };
+}
+RUDNGEntry ascii(uint16_t tag, const char *s) {
+    RUDNGEntry e { tag, kAscii, (uint32_t)strlen(s) + 1, {} };
+    e.bytes.assign(s, s + e.count);
+    return e;
+}
+// (signed) rationals with denominator 10000
+RUDNGEntry rationals(uint16_t tag, bool isSigned, std::initializer_list<double> vs) {
+    RUDNGEntry e { tag, isSigned ? kSRational : kRational, (uint32_t)vs.size(), {} };
+    for (double x : vs) { put32(e.bytes, (uint32_t)(int32_t)lrint(x * 10000.0)); put32(e.bytes, 10000); }
+    return e;
+}
+
+// MARK: - Scene
+
+// Linear scene RGB (0..~1.2) at (x, y) of a W×H frame.
+void scene(int x, int y, int W, int H, float rgb[3]) {
+    const float u = (x + 0.5f) / W, v = (y + 0.5f) / H;
+    float r = 0.05f + 0.6f * u, g = r, b = r;   // grey ramp
+    if (v > 0.5f) {                              // colour patches along the bottom
+        static const float kPatch[6][3] = {
+            { 0.6f, 0.1f, 0.1f }, { 0.1f, 0.5f, 0.1f }, { 0.1f, 0.1f, 0.6f },
+            { 0.6f, 0.5f, 0.1f }, { 0.1f, 0.5f, 0.6f }, { 0.5f, 0.1f, 0.5f },
+        };
+        const float *p = kPatch[std::min(5, (int)(u * 6))];
+        r = p[0]; g = p[1]; b = p[2];
+    }
+    const float dx = u - 0.8f, dy = v - 0.25f;
+    if (dx * dx + dy * dy < 0.006f) r = g = b = 1.2f;   // blown highlight
+    rgb[0] = r; rgb[1] = g; rgb[2] = b;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc != 2 && argc != 4) {
+        fprintf(stderr, "usage: ru_synth_dng OUT.dng [width height]\n");
+        return 2;
+    }
+    const int W = argc == 4 ? atoi(argv[2]) & ~1 : 384;
+    const int H = argc == 4 ? atoi(argv[3]) & ~1 : 256;
+    if (W < 16 || H < 16 || W > 16384 || H > 16384) { fprintf(stderr, "bad size\n"); return 2; }
+
+    // As-shot neutral 0.5 : 1 : 0.7 (camera response per channel)
+    const float kGain[3] = { 0.5f, 1.f, 0.7f };
+    const float black = 256.f, white = 4095.f;
+    std::vector<uint8_t> strip;
+    strip.reserve((size_t)W * H * 2);
+    uint32_t noise = 12345;
+    for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x) {
+            float rgb[3];
+            scene(x, y, W, H, rgb);
+            const int c = (y & 1) ? ((x & 1) ? 2 : 1) : ((x & 1) ? 1 : 0);   // RGGB
+            noise = noise * 1664525u + 1013904223u;
+            const float n = ((noise >> 8) / 16777216.f - 0.5f) * 8.f;
+            const float dn = black + rgb[c] * kGain[c] * (white - black) + n;
+            put16(strip, (uint32_t)std::min(white, std::max(0.f, dn)));
+        }
+
+    std::vector<RUDNGEntry> ifd = {
+        longs (254, { 0 }),                                // NewSubFileType: main image
+        longs (256, { (uint32_t)W }),
+        longs (257, { (uint32_t)H }),
+        shorts(258, { 16 }),                               // BitsPerSample
+        shorts(259, { 1 }),                                // uncompressed
+        shorts(262, { 32803 }),                            // CFA
+        ascii (271, "RawUnravel"),
+        ascii (272, "Synthetic Bayer"),
+        longs (273, { 0 }),                                // StripOffsets (patched below)
+        shorts(274, { 1 }),
+        shorts(277, { 1 }),
+        longs (278, { (uint32_t)H }),
+        longs (279, { (uint32_t)strip.size() }),
+        shorts(284, { 1 }),
+        shorts(33421, { 2, 2 }),                           // CFARepeatPatternDim
+        bytes (33422, { 0, 1, 1, 2 }),                     // CFAPattern RGGB
+        bytes (50706, { 1, 4, 0, 0 }),                     // DNGVersion
+        bytes (50707, { 1, 1, 0, 0 }),
+        ascii (50708, "RawUnravel Synthetic Bayer"),
+        shorts(50714, { (uint32_t)black }),                // BlackLevel
+        shorts(50717, { (uint32_t)white }),                // WhiteLevel
+        rationals(50721, true, { 3.2406, -1.5372, -0.4986, // ColorMatrix1: XYZ → linear sRGB
+                                -0.9689,  1.8758,  0.0415,
+                                 0.0557, -0.2040,  1.0570 }),
+        rationals(50728, false, { kGain[0], kGain[1], kGain[2] }),   // AsShotNeutral
+        shorts(50778, { 21 }),                             // CalibrationIlluminant1: D65
+    };
+
+    // header, IFD, out-of-line values, strip
+    const uint32_t ifdOff = 8, ifdSize = 2 + 12 * (uint32_t)ifd.size() + 4;
+    uint32_t dataOff = ifdOff + ifdSize;
+    for (const RUDNGEntry &e : ifd)
+        if (e.bytes.size() > 4) dataOff += (uint32_t)(e.bytes.size() + 1) & ~1u;
+    const uint32_t stripOff = dataOff;
+    for (RUDNGEntry &e : ifd)
+        if (e.tag == 273) { e.bytes.clear(); put32(e.bytes, stripOff); }
+
+    std::vector<uint8_t> f = { 'I', 'I', 42, 0 };
+    put32(f, ifdOff);
+    std::vector<uint8_t> data;
+    put16(f, (uint32_t)ifd.size());
+    for (const RUDNGEntry &e : ifd) {
+        put16(f, e.tag); put16(f, e.type); put32(f, e.count);
+        if (e.bytes.size() <= 4) {
+            std::vector<uint8_t> v = e.bytes;
+            v.resize(4, 0);
+            f.insert(f.end(), v.begin(), v.end());
+        } else {
+            put32(f, ifdOff + ifdSize + (uint32_t)data.size());
+            data.insert(data.end(), e.bytes.begin(), e.bytes.end());
+            if (data.size() & 1) data.push_back(0);
+        }
+    }
+    put32(f, 0);   // no next IFD
+    f.insert(f.end(), data.begin(), data.end());
+    f.insert(f.end(), strip.begin(), strip.end());
+
+    FILE *out = fopen(argv[1], "wb");
+    if (!out) { perror(argv[1]); return 1; }
+    const bool ok = fwrite(f.data(), 1, f.size(), out) == f.size();
+    if (fclose(out) != 0 || !ok) { perror(argv[1]); return 1; }
+    return 0;
+}
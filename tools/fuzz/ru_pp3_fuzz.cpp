@@ -0,0 +1,120 @@
+/*
+    RawUnravel - ru_pp3_fuzz.cpp
+    ----------------------------
+    Copyright (C) 2025 Richard Barber
+
+    This file is part of RawUnravel.
+
+    RawUnravel is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    RawUnravel is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with RawUnravel.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Fuzz target for the PP3 parser. Checks that any input leaves the settings
+// finite and in range, and that hashing/diffing stays consistent.
+//
+// libFuzzer (clang), from the repository root:
+//   clang++ -std=c++17 -g -O1 -fsanitize=fuzzer,address,undefined -I app/RAWUnravel/RAWUnravel tools/fuzz/ru_pp3_fuzz.cpp app/RAWUnravel/RAWUnravel/RUPP3.cpp -o ru_pp3_fuzz
+//   ./ru_pp3_fuzz -max_len=4096
+//
+// With -DRU_FUZZ_STANDALONE (the CMake target ru_pp3_fuzz) it needs no
+// libFuzzer: runs each file given on the command line, or N random mutations
+// of a built-in profile (build/ru_pp3_fuzz [iterations]).
+
+#include "RUPP3.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+static void check(bool ok, const char *what) {
+    if (!ok) { std::fprintf(stderr, "invariant failed: %s\n", what); std::abort(); }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    RU_PP3 P;
+    RU_ParsePP3(reinterpret_cast<const char *>(data), size, P);
+
+    for (float f : { P.exposureEV, P.black, P.shadows, P.chromaticity, P.cChroma, P.jContrast,
+                     P.deconvAmount, P.deconvRadius, P.deconvDamping,
+                     P.wbTemp, P.wbGreen, P.wbEqual, P.caRed, P.caBlue })
+        check(std::isfinite(f), "finite fields");
+    check(P.deconvIter >= 0 && P.deconvIter <= 100, "deconvIter in [0, 100]");
+    check(P.caAutoIterations >= 1 && P.caAutoIterations <= 5, "caAutoIterations in [1, 5]");
+    check(!P.hasExposure || std::fabs(P.exposureEV) > 1e-4f, "hasExposure implies nonzero EV");
+
+    check(RU_PP3Hash(P) == RU_PP3Hash(P), "hash is deterministic");
+    check(RU_PP3Diff(P, P) == 0, "diff with itself is empty");
+    RU_PP3 Q = P;
+    RU_ParsePP3(reinterpret_cast<const char *>(data), size, Q);
+    check(RU_PP3Diff(P, Q) == 0, "parsing twice is idempotent");
+    return 0;
+}
+
+#ifdef RU_FUZZ_STANDALONE
+
+static const char kSeed[] =
+    "[Exposure]\nCompensation=0.70\nBlack=12\nShadows=-20.00\nHighlightReconstruction=true\n\n"
+    "[White Balance]\nSetting=Custom\nTemperature=5200\nGreen=1.02\nEqual=1\n\n"
+    "[Sharpening]\nEnabled=true\nMethod=deconv\nDeconvAmount=75\nDeconvIterations=20\n"
+    "DeconvDamping=0\nDeconvRadius=0.375\n\n"
+    "[RAW]\nCA=true\nCARed=0\nCABlue=0\nCAAutoIterations=2\nCAAvoidColourshift=true\n\n"
+    "[Color appearance]\nEnabled=true\nAlgorithm=JC\nC-Chroma=10\nC-ChromaEnabled=true\n"
+    "J-Contrast=-5\nJ-ContrastEnabled=true\n\n"
+    "[Luminance Curve]\nEnabled=true\nChromaticity=15\nChromaticityEnabled=true\n";
+
+static std::vector<uint8_t> readFile(const char *path) {
+    std::vector<uint8_t> buf;
+    if (FILE *f = std::fopen(path, "rb")) {
+        uint8_t chunk[4096];
+        for (size_t n; (n = std::fread(chunk, 1, sizeof chunk, f)) > 0; ) buf.insert(buf.end(), chunk, chunk + n);
+        std::fclose(f);
+    }
+    return buf;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && std::atoi(argv[1]) == 0) {
+        for (int i = 1; i < argc; ++i) {
+            const std::vector<uint8_t> buf = readFile(argv[i]);
+            LLVMFuzzerTestOneInput(buf.data(), buf.size());
+        }
+        std::printf("%d file(s) ok\n", argc - 1);
+        return 0;
+    }
+
+    const int runs = argc > 1 ? std::atoi(argv[1]) : 200000;
+    const std::string seed(kSeed);
+    static const char kAlphabet[] = "[]=#;\r\n\t -+.eE0123456789nainfNANINFtrue";
+    std::mt19937 rng(20250101);
+    for (int r = 0; r < runs; ++r) {
+        std::string s = seed;
+        const int edits = 1 + (int)(rng() % 16);
+        for (int e = 0; e < edits && !s.empty(); ++e) {
+            const size_t at = rng() % s.size();
+            switch (rng() % 4) {
+                case 0: s[at] = (char)(rng() & 0xFF); break;
+                case 1: s.insert(at, 1, kAlphabet[rng() % (sizeof kAlphabet - 1)]); break;
+                case 2: s.erase(at, 1 + rng() % 8); break;
+                case 3: s.insert(at, s.substr(rng() % s.size(), 1 + rng() % 32)); break;
+            }
+        }
+        LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(s.data()), s.size());
+    }
+    std::printf("%d mutation(s) ok\n", runs);
+    return 0;
+}
+
+#endif